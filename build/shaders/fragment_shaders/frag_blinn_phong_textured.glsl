@@ -14,11 +14,15 @@ layout(location = 0) out vec4 frag_color;
 // Unity
 struct Material {
 	sampler2D Diffuse;
-	float     Shininess;
 };
 // Create a uniform for the material
 uniform Material u_Material;
 
+// Plain values are packed into a uniform buffer, so the material can be bound with one call
+layout (std140, binding = 3) uniform b_Material {
+	float Shininess;
+} u_MaterialParams;
+
 ////////////////////////////////////////////////////////////////
 ///////////// Application Level Uniforms ///////////////////////
 ////////////////////////////////////////////////////////////////
@@ -38,7 +42,7 @@ void main() {
 	vec3 normal = normalize(inNormal);
 
 	// Use the lighting calculation that we included from our partial file
-	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_Material.Shininess);
+	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_MaterialParams.Shininess);
 
 	// Get the albedo from the diffuse / albedo map
 	vec4 textureColor = texture(u_Material.Diffuse, inUV);
@@ -2,11 +2,26 @@
 // Vertex inputs
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec3 inNormal;
+layout(location = 2) in vec4 inNormalData;
 layout(location = 3) in vec2 inUV;
 
-layout(location = 4) in vec3 inTangent;
-layout(location = 5) in vec3 inBiTangent;
+layout(location = 4) in vec4 inTangentData;
+layout(location = 5) in vec3 inBiTangentData;
+
+// Decodes a unit vector that was octahedral encoded into the [-1, 1] square
+vec3 OctDecode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+// Packed vertices (see VertexPackedPosNormTexColTangents) store octahedral normals and tangents
+// with a w of 0, and leave the bitangent to be rebuilt with the handedness in the tangent's z.
+// Float attributes have a w of 1, so the same shader works for both vertex formats
+#define inNormal    (inNormalData.w  == 0.0 ? OctDecode(inNormalData.xy)  : inNormalData.xyz)
+#define inTangent   (inTangentData.w == 0.0 ? OctDecode(inTangentData.xy) : inTangentData.xyz)
+#define inBiTangent (inTangentData.w == 0.0 ? cross(inNormal, inTangent) * inTangentData.z : inBiTangentData)
 
 // Standard vertex shader outputs
 layout(location = 0) out vec3 outWorldPos;
@@ -0,0 +1,59 @@
+#version 430
+
+#include "../fragments/fs_common_inputs.glsl"
+
+// The layers of our array textures, from fragments/vs_common_instanced.glsl
+layout(location = 7) flat in vec4 inTextureLayers;
+
+// We output a single color to the color buffer
+layout(location = 0) out vec4 frag_color;
+
+////////////////////////////////////////////////////////////////
+/////////////// Instance Level Uniforms ////////////////////////
+////////////////////////////////////////////////////////////////
+
+// Represents a collection of attributes that would define a material
+// For instance, you can think of this like material settings in 
+// Unity
+// The diffuse is stored in a texture array, so materials that only use different
+// textures can still be drawn together. It's layer is in inTextureLayers.x
+struct Material {
+	sampler2DArray Diffuse;
+};
+// Create a uniform for the material
+uniform Material u_Material;
+
+// Plain values are packed into a uniform buffer, so the material can be bound with one call
+layout (std140, binding = 3) uniform b_Material {
+	float Shininess;
+} u_MaterialParams;
+
+////////////////////////////////////////////////////////////////
+///////////// Application Level Uniforms ///////////////////////
+////////////////////////////////////////////////////////////////
+
+#include "../fragments/multiple_point_lights.glsl"
+
+////////////////////////////////////////////////////////////////
+/////////////// Frame Level Uniforms ///////////////////////////
+////////////////////////////////////////////////////////////////
+
+#include "../fragments/frame_uniforms.glsl"
+#include "../fragments/color_correction.glsl"
+
+// https://learnopengl.com/Advanced-Lighting/Advanced-Lighting
+void main() {
+	// Normalize our input normal
+	vec3 normal = normalize(inNormal);
+
+	// Use the lighting calculation that we included from our partial file
+	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_MaterialParams.Shininess);
+
+	// Get the albedo from the diffuse / albedo map
+	vec4 textureColor = texture(u_Material.Diffuse, vec3(inUV, inTextureLayers.x));
+
+	// combine for the final result
+	vec3 result = lightAccumulation  * inColor * textureColor.rgb;
+
+	frag_color = vec4(ColorCorrect(result), textureColor.a);
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+// Include our common vertex shader attributes, outputs and uniforms
+#include "vs_common.glsl"
+
+// Per-instance inputs, fed by the RenderLayer's instance buffer
+// Attributes 0-5 are used by our common inputs, so let's skip to 8 to leave some space
+// This will consume 4 slots, since it's essentially 4 vec4s in memory
+layout(location = 8) in mat4 inModelTransform;
+// This will consume 3 slots in memory
+layout(location = 12) in mat3 inNormalMatrix;
+// The layers of the material's sampler2DArray textures, see Material::GetTextureLayers
+layout(location = 15) in vec4 inTextureLayers;
+
+// Instanced shaders pass the layers on to the fragment shader, they're the same for the whole instance
+layout(location = 7) flat out vec4 outTextureLayers;
+
+// Redirect the instance level uniforms to our per-instance inputs, this way any shader
+// written against vs_common.glsl can be instanced by just swapping the include
+#define u_Model inModelTransform
+#define u_NormalMatrix mat4(inNormalMatrix)
+#define u_ModelViewProjection (u_ViewProjection * inModelTransform)
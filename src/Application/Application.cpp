@@ -22,6 +22,8 @@
 #include "Graphics/Textures/Texture2D.h"
 #include "Graphics/Textures/Texture3D.h"
 #include "Graphics/Textures/TextureCube.h"
+#include "Graphics/Textures/TextureUploader.h"
+#include "Graphics/Textures/TextureArrayPool.h"
 #include "Graphics/VertexTypes.h"
 #include "Graphics/Font.h"
 #include "Graphics/GuiBatcher.h"
@@ -118,10 +120,26 @@ bool Application::LoadScene(const std::string& path) {
 		if (std::filesystem::exists(manifestPath)) {
 			LOG_INFO("Loading manifest from \"{}\"", manifestPath);
 			ResourceManager::LoadManifest(manifestPath);
+			// Start reading and parsing everything in parallel, the scene will pick up the results
+			// as it requests the resources
+			ResourceManager::PreloadAllAsync();
 		}
 
-		Gameplay::Scene::Sptr scene = Gameplay::Scene::Load(path);
-		LoadScene(scene);
+		std::filesystem::path scenePath = path;
+		#ifdef PREFER_BINARY_SCENES
+		// Shipping builds will load the binary version of the scene instead, as long as it's up to date
+		std::filesystem::path binaryPath = std::filesystem::path(path).replace_extension(".bscn");
+		if (std::filesystem::exists(binaryPath) && std::filesystem::last_write_time(binaryPath) >= std::filesystem::last_write_time(path)) {
+			scenePath = binaryPath;
+		}
+		#endif
+
+		Gameplay::Scene::Sptr scene = scenePath.extension() == ".bscn" ?
+			Gameplay::Scene::LoadBinary(scenePath.string()) :
+			Gameplay::Scene::Load(scenePath.string());
+		if (scene != nullptr) {
+			LoadScene(scene);
+		}
 		return scene != nullptr;
 	}
 	return false;
@@ -192,6 +210,13 @@ void Application::_Run()
 		// Receive events like input and window position/size changes from GLFW
 		glfwPollEvents();
 
+		// Finish any resources that have been prepared in the background
+		ResourceManager::Update();
+		// Upload any textures that have finished decoding in the background
+		Texture2D::ProcessPendingLoads();
+		// Stream in this frame's share of queued texture data
+		TextureUploader::Update();
+
 		// Handle closing the app via the close button
 		if (glfwWindowShouldClose(_window)) {
 			_isRunning = false;
@@ -234,6 +259,10 @@ void Application::_Run()
 
 	}
 
+	// Release the upload staging buffer and texture arrays while we still have a GL context
+	TextureUploader::Uninitialize();
+	TextureArrayPool::Uninitialize();
+
 	// Unload all our layers
 	_Unload();
 }
@@ -104,9 +104,11 @@ void DefaultSceneLayer::_CreateScene()
 		reflectiveShader->SetDebugName("Reflective");
 
 		// This shader handles our basic materials without reflections (cause they expensive)
+		// It uses the instanced vertex shader, so objects sharing a mesh and material get batched by the RenderLayer.
+		// The diffuse is read from a texture array, so materials that only differ by diffuse texture are batched too
 		ShaderProgram::Sptr basicShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
-			{ ShaderPartType::Vertex, "shaders/vertex_shaders/basic.glsl" },
-			{ ShaderPartType::Fragment, "shaders/fragment_shaders/frag_blinn_phong_textured.glsl" }
+			{ ShaderPartType::Vertex, "shaders/vertex_shaders/basic_instanced.glsl" },
+			{ ShaderPartType::Fragment, "shaders/fragment_shaders/frag_blinn_phong_textured_array.glsl" }
 		});
 		basicShader->SetDebugName("Blinn-phong");
 
@@ -415,6 +417,9 @@ void DefaultSceneLayer::_CreateScene()
 			renderer->SetMesh(tiledMesh);
 			renderer->SetMaterial(boxMaterial);
 
+			// The floor never moves, so it can be drawn with the other static scenery
+			renderer->SetStatic(true);
+
 			// Attach a plane collider that extends infinitely along the X/Y axis
 			RigidBody::Sptr physics = plane->Add<RigidBody>(/*static by default*/);
 			physics->AddCollider(BoxCollider::Create(glm::vec3(50.0f, 50.0f, 1.0f)))->SetPosition({ 0,0,-1 });
@@ -158,7 +158,7 @@ void ImGuiDebugLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 
 				// Load scene item
 				if (ImGui::MenuItem("Load Scene", NULL, false)) {
-					std::optional<std::string> path = FileDialogs::OpenFile("Scene File\0*.json\0\0");
+					std::optional<std::string> path = FileDialogs::OpenFile("Scene File\0*.json\0Binary Scene File\0*.bscn\0\0");
 					if (path.has_value()) {
 						app.LoadScene(path.value());
 					}
@@ -175,6 +175,17 @@ void ImGuiDebugLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 					}
 				}
 
+				// Export binary scene item, these are faster to load but are not human readable
+				if (ImGui::MenuItem("Export Binary Scene", NULL, false)) {
+					std::optional<std::string> path = FileDialogs::SaveFile("Binary Scene File\0*.bscn\0\0");
+					if (path.has_value()) {
+						app.CurrentScene()->SaveBinary(path.value());
+
+						std::string newFilename = std::filesystem::path(path.value()).stem().string() + "-manifest.json";
+						ResourceManager::SaveManifest(newFilename);
+					}
+				}
+
 				ImGui::EndMenu();
 			}
 
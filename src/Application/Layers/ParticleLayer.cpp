@@ -19,19 +19,19 @@ void ParticleLayer::OnUpdate()
 	// Only update the particle systems when the game is playing, so we can edit them in
 	// the inspector
 	if (app.CurrentScene()->IsPlaying) {
-		app.CurrentScene()->Components().Each<ParticleSystem>([](const ParticleSystem::Sptr& system) {
+		for (ParticleSystem* system : app.CurrentScene()->Components().Pool<ParticleSystem>()) {
 			if (system->IsEnabled) {
 				system->Update();
 			}
-		});
+		}
 	}
 }
 
 void ParticleLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 {
-	Application::Get().CurrentScene()->Components().Each<ParticleSystem>([](const ParticleSystem::Sptr& system) {
+	for (ParticleSystem* system : Application::Get().CurrentScene()->Components().Pool<ParticleSystem>()) {
 		if (system->IsEnabled) {
 			system->Render();
 		}
-	});
+	}
 }
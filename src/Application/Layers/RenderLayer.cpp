@@ -7,6 +7,9 @@
 #include "../Timing.h"
 #include "Gameplay/Components/ComponentManager.h"
 #include "Gameplay/Components/RenderComponent.h"
+#include "Utils/Bounds.h"
+
+#include <algorithm>
 
 // GLM math library
 #include <GLM/glm.hpp>
@@ -20,13 +23,17 @@ RenderLayer::RenderLayer() :
 	ApplicationLayer(),
 	_primaryFBO(nullptr),
 	_blitFbo(true),
+	_frustumCulling(true),
+	_multiDraw(true),
 	_frameUniforms(nullptr),
 	_instanceUniforms(nullptr),
+	_instanceBuffer(nullptr),
+	_indirectBuffer(nullptr),
 	_renderFlags(RenderFlags::EnableColorCorrection),
 	_clearColor({ 0.1f, 0.1f, 0.1f, 1.0f })
 {
 	Name = "Rendering";
-	Overrides = AppLayerFunctions::OnAppLoad | AppLayerFunctions::OnRender | AppLayerFunctions::OnWindowResize;
+	Overrides = AppLayerFunctions::OnAppLoad | AppLayerFunctions::OnRender | AppLayerFunctions::OnSceneUnload | AppLayerFunctions::OnWindowResize;
 }
 
 RenderLayer::~RenderLayer() = default;
@@ -57,10 +64,6 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
 
-	// The current material that is bound for rendering
-	Material::Sptr currentMat = nullptr;
-	ShaderProgram::Sptr shader = nullptr;
-
 	// Bind the skybox texture to a reserved texture slot
 	// See Material.h and Material.cpp for how we're reserving texture slots
 	TextureCube::Sptr environment = app.CurrentScene()->GetSkyboxTexture();
@@ -77,7 +80,6 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 	// Here we'll bind all the UBOs to their corresponding slots
 	app.CurrentScene()->PreRender();
 	_frameUniforms->Bind(FRAME_UBO_BINDING);
-	_instanceUniforms->Bind(INSTANCE_UBO_BINDING);
 
 	// Draw physics debug
 	app.CurrentScene()->DrawPhysicsDebug();
@@ -95,11 +97,27 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 
 	Material::Sptr defaultMat = app.CurrentScene()->DefaultMaterial;
 
-	// Render all our objects
-	app.CurrentScene()->Components().Each<RenderComponent>([&](const RenderComponent::Sptr& renderable) {
+	// Cache the view matrix and far plane for calculating object depths
+	const glm::mat4& view = camera->GetView();
+	float farPlane = camera->GetFarPlane();
+
+	// Extract the camera's frustum planes so we can skip objects it can't see
+	Frustum frustum = Frustum::FromViewProjection(viewProj);
+
+	// Used to work out how large an object's LOD error would be on screen
+	glm::vec3 cameraPos = camera->GetGameObject()->GetPosition();
+	float viewportHeight = static_cast<float>(_primaryFBO->GetHeight());
+
+	// Build the render queue for this frame
+	_renderQueue.clear();
+	for (RenderComponent* renderable : app.CurrentScene()->Components().Pool<RenderComponent>()) {
+		if (!renderable->IsEnabled) {
+			continue;
+		}
+
 		// Early bail if mesh not set
 		if (renderable->GetMesh() == nullptr) {
-			return;
+			continue;
 		}
 
 		// If we don't have a material, try getting the scene's fallback material
@@ -108,33 +126,237 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 			if (defaultMat != nullptr) {
 				renderable->SetMaterial(defaultMat);
 			} else {
-				return;
+				continue;
 			}
 		}
 
-		// If the material has changed, we need to bind the new shader and set up our material and frame data
-		// Note: This is a good reason why we should be sorting the render components in ComponentManager
-		if (renderable->GetMaterial() != currentMat) {
-			currentMat = renderable->GetMaterial();
-			shader = currentMat->GetShader();
+		// Skip objects that are completely outside of the camera's view
+		const Bounds& worldBounds = renderable->GetGameObject()->GetWorldBounds(renderable->GetMeshResource()->LocalBounds);
+		if (_frustumCulling && !frustum.Intersects(worldBounds)) {
+			continue;
+		}
 
-			shader->Bind();
-			currentMat->Apply();
+		// Select the LOD based on the closest the object's bounds can be to the camera
+		if (renderable->GetMesh()->GetLodCount() > 1) {
+			float distance = glm::length(worldBounds.Sphere.Center - cameraPos) - worldBounds.Sphere.Radius;
+			renderable->UpdateLod(camera->GetPixelsPerUnit(distance, viewportHeight));
+		}
+
+		const Material::Sptr& material = renderable->GetMaterial();
+
+		// Determine the distance to the object along the camera's forward axis
+		glm::vec4 viewPos = view * renderable->GetGameObject()->GetTransform()[3];
+		float depth = -viewPos.z / farPlane;
+
+		// Static objects with instanced shaders can be multi-drawn, as long as their mesh can go in an arena
+		DrawCommand command;
+		command.Arena = nullptr;
+		command.ArenaEntry = nullptr;
+		if (_multiDraw && renderable->IsStatic() && _IsInstanced(material->GetShader())) {
+			command.Arena = _GetArena(renderable->GetMesh());
+			command.ArenaEntry = command.Arena != nullptr ? command.Arena->GetOrAdd(renderable->GetMesh()) : nullptr;
 		}
 
-		// Grab the game object so we can do some stuff with it
+		// Materials that only differ by the layers of their array textures share a batch ID, so they are sorted together
+		command.BatchId = material->GetBatchId();
+		command.SortKey = _MakeSortKey(material->GetShader()->GetHandle(), command.BatchId, command.ArenaEntry != nullptr, renderable->GetMesh()->GetHandle(), depth);
+		command.Renderable = renderable;
+		_renderQueue.push_back(command);
+	}
+
+	// Sort the queue so that draws sharing state are submitted together
+	std::sort(_renderQueue.begin(), _renderQueue.end());
+
+	// Split the queue into batches of draws that share a mesh and material batch ID. If the material's
+	// shader reads it's transforms from per-instance attributes, the batch becomes one instanced draw
+	_batches.clear();
+	_instanceData.clear();
+	_indirectCommands.clear();
+	for (size_t ix = 0; ix < _renderQueue.size(); ) {
+		const DrawCommand& command = _renderQueue[ix];
+		RenderComponent* first = command.Renderable;
+
+		DrawBatch batch;
+		batch.First = ix;
+		batch.Count = 1;
+		batch.BaseInstance = -1;
+		batch.UniformOffset = StreamingBuffer::INVALID_OFFSET;
+		batch.Arena = nullptr;
+		batch.CommandOffset = 0;
+		batch.CommandCount = 0;
+
+		if (command.ArenaEntry != nullptr) {
+			// Multi-draws cover everything in the arena that shares our material, regardless of mesh
+			while (ix + batch.Count < _renderQueue.size()) {
+				const DrawCommand& next = _renderQueue[ix + batch.Count];
+				if (next.ArenaEntry == nullptr || next.Arena != command.Arena || next.BatchId != command.BatchId) {
+					break;
+				}
+				batch.Count++;
+			}
+
+			// Store the index of our first command for now, it becomes a byte offset once the commands are uploaded
+			batch.Arena = command.Arena;
+			batch.BaseInstance = static_cast<int>(_instanceData.size());
+			batch.CommandOffset = static_cast<uint32_t>(_indirectCommands.size());
+
+			// Objects sharing a mesh and LOD are sorted next to each other, and become a single instanced command
+			for (uint32_t iy = 0; iy < batch.Count; ) {
+				const DrawCommand& run = _renderQueue[ix + iy];
+				uint32_t runLength = 1;
+				while (iy + runLength < batch.Count) {
+					const DrawCommand& next = _renderQueue[ix + iy + runLength];
+					if (next.ArenaEntry != run.ArenaEntry || next.Renderable->GetLod() != run.Renderable->GetLod()) {
+						break;
+					}
+					runLength++;
+				}
+
+				uint32_t baseInstance = static_cast<uint32_t>(_instanceData.size());
+				for (uint32_t iz = 0; iz < runLength; iz++) {
+					_instanceData.push_back(_MakeInstanceAttributes(_renderQueue[ix + iy + iz].Renderable));
+				}
+
+				for (const MeshArena::DrawRange& range : run.ArenaEntry->GetLod(run.Renderable->GetLod())) {
+					DrawElementsIndirectCommand indirect;
+					indirect.IndexCount    = range.IndexCount;
+					indirect.InstanceCount = runLength;
+					indirect.FirstIndex    = range.FirstIndex;
+					indirect.BaseVertex    = range.BaseVertex;
+					indirect.BaseInstance  = baseInstance;
+					_indirectCommands.push_back(indirect);
+				}
+
+				iy += runLength;
+			}
+			batch.CommandCount = static_cast<uint32_t>(_indirectCommands.size()) - batch.CommandOffset;
+		}
+		else if (_IsInstanced(first->GetMaterial()->GetShader())) {
+			// Since the queue is sorted, anything sharing our mesh and material batch will be right after us
+			while (ix + batch.Count < _renderQueue.size()) {
+				const DrawCommand& next = _renderQueue[ix + batch.Count];
+				if (next.ArenaEntry != nullptr || next.BatchId != command.BatchId || next.Renderable->GetMeshResource() != first->GetMeshResource() || next.Renderable->GetLod() != first->GetLod()) {
+					break;
+				}
+				batch.Count++;
+			}
+
+			// Pack the transforms for all the instances in the batch
+			batch.BaseInstance = static_cast<int>(_instanceData.size());
+			for (uint32_t iy = 0; iy < batch.Count; iy++) {
+				_instanceData.push_back(_MakeInstanceAttributes(_renderQueue[ix + iy].Renderable));
+			}
+		}
+
+		_batches.push_back(batch);
+		ix += batch.Count;
+	}
+
+	// Upload all the instance data for the frame in one go
+	if (!_instanceData.empty()) {
+		_instanceBuffer->LoadData(_instanceData.data(), static_cast<uint32_t>(_instanceData.size()));
+	}
+
+	// Write the indirect commands for all the multi-draws in one go, and convert the batch's command indices to offsets
+	uint32_t commandBytes = static_cast<uint32_t>(_indirectCommands.size() * sizeof(DrawElementsIndirectCommand));
+	_indirectBuffer->BeginFrame(_indirectBuffer->GetAlignedSize(commandBytes));
+	if (!_indirectCommands.empty()) {
+		uint32_t commandBase = _indirectBuffer->Allocate(commandBytes);
+		memcpy(_indirectBuffer->GetPointer(commandBase), _indirectCommands.data(), commandBytes);
+		for (DrawBatch& batch : _batches) {
+			if (batch.Arena != nullptr) {
+				batch.CommandOffset = commandBase + batch.CommandOffset * sizeof(DrawElementsIndirectCommand);
+			}
+		}
+	}
+	_indirectBuffer->Bind();
+
+	// Write the uniforms for all non-instanced draws straight into this frame's section of the streaming
+	// buffer, so we don't need to update a buffer that the GPU may still be reading between draws
+	uint32_t uniformSize = _instanceUniforms->GetAlignedSize(sizeof(InstanceLevelUniforms));
+	uint32_t numUniformBatches = static_cast<uint32_t>(std::count_if(_batches.begin(), _batches.end(), [](const DrawBatch& batch) { return batch.BaseInstance < 0; }));
+	_instanceUniforms->BeginFrame(numUniformBatches * uniformSize);
+	for (DrawBatch& batch : _batches) {
+		if (batch.BaseInstance >= 0) {
+			continue;
+		}
+		RenderComponent* renderable = _renderQueue[batch.First].Renderable;
 		GameObject* object = renderable->GetGameObject();
 
-		// Use our uniform buffer for our instance level uniforms
-		auto& instanceData = _instanceUniforms->GetData();
-		instanceData.u_Model = object->GetTransform();
-		instanceData.u_ModelViewProjection = viewProj * object->GetTransform();
-		instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(object->GetTransform())));
-		_instanceUniforms->Update();
+		const VertexArrayObject::Sptr& mesh = renderable->GetMeshResource()->Mesh;
+		glm::mat4 model = mesh->HasPositionTransform() ? object->GetTransform() * mesh->GetPositionTransform() : object->GetTransform();
+
+		// The mapped memory is write only, so fill out the whole struct without reading it back
+		batch.UniformOffset = _instanceUniforms->Allocate(sizeof(InstanceLevelUniforms));
+		InstanceLevelUniforms* uniforms = reinterpret_cast<InstanceLevelUniforms*>(_instanceUniforms->GetPointer(batch.UniformOffset));
+		uniforms->u_ModelViewProjection = viewProj * model;
+		uniforms->u_Model = model;
+		uniforms->u_NormalMatrix = object->GetNormalMatrix();
+	}
+
+	// The state that is currently bound for rendering
+	ShaderProgram*     currentShader = nullptr;
+	Material*          currentMat    = nullptr;
+	VertexArrayObject* currentVao    = nullptr;
+
+	// Render all our objects
+	for (const DrawBatch& batch : _batches) {
+		const DrawCommand& command = _renderQueue[batch.First];
+		RenderComponent* renderable = command.Renderable;
+		Material* material = renderable->GetMaterial().get();
+
+		// Only re-bind the shader when it actually changes
+		if (material->GetShader().get() != currentShader) {
+			currentShader = material->GetShader().get();
+			currentShader->Bind();
+
+			// A new shader means that the material needs to re-apply it's state
+			currentMat = nullptr;
+		}
+
+		// If the material state has changed, we need to set up our material data. Materials with the
+		// same batch ID put the pipeline in the same state, so only the first one needs to be applied
+		if (currentMat == nullptr || command.BatchId != currentMat->GetBatchId()) {
+			currentMat = material;
+			currentMat->Apply();
+		}
+
+		// Instanced batches use a copy of the mesh's VAO which also reads from the instance buffer,
+		// multi-draws do the same with the arena's VAO
+		VertexArrayObject* vao = 
+			batch.Arena != nullptr ? _GetInstancedVao(batch.Arena->GetVao()).get() :
+			batch.BaseInstance >= 0 ? _GetInstancedVao(renderable->GetMeshResource()->Mesh).get() :
+			renderable->GetMeshResource()->Mesh.get();
+
+		// Only re-bind the VAO when the mesh changes
+		if (vao != currentVao) {
+			currentVao = vao;
+			currentVao->Bind();
+		}
+
+		// Multi-draws are submitted with a single call, reading their commands from the indirect buffer
+		if (batch.Arena != nullptr) {
+			currentVao->MultiDrawIndirect(batch.CommandOffset, batch.CommandCount, DrawMode::TriangleList, false);
+			continue;
+		}
 
-		// Draw the object
-		renderable->GetMesh()->Draw();
-	});
+		// Instanced batches are drawn all at once, the VAO is already bound
+		if (batch.BaseInstance >= 0) {
+			currentVao->DrawInstanced(batch.Count, DrawMode::TriangleList, false, batch.BaseInstance, renderable->GetLod());
+			continue;
+		}
+
+		// Point the instance uniform block at this object's section of the streaming buffer
+		_instanceUniforms->BindRange(INSTANCE_UBO_BINDING, batch.UniformOffset, sizeof(InstanceLevelUniforms));
+
+		// Draw the object, the VAO is already bound
+		currentVao->Draw(DrawMode::TriangleList, false, renderable->GetLod());
+	}
+
+	// The GPU is done with this frame's uniforms and commands once all the above draws complete
+	_instanceUniforms->EndFrame();
+	_indirectBuffer->EndFrame();
+	IBuffer::UnBind(BufferType::DrawIndirect);
 
 	// Use our cubemap to draw our skybox
 	app.CurrentScene()->DrawSkybox();
@@ -145,6 +367,98 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 	VertexArrayObject::Unbind();
 }
 
+uint64_t RenderLayer::_MakeSortKey(uint32_t shader, uint32_t material, bool multiDraw, uint32_t vao, float depth)
+{
+	// Quantize the depth into 16 bits, anything behind the camera or past the far plane is clamped
+	uint64_t depthBits = static_cast<uint64_t>(glm::clamp(depth, 0.0f, 1.0f) * 65535.0f);
+
+	return
+		(static_cast<uint64_t>(shader   & 0xFFFF) << 48) |
+		(static_cast<uint64_t>(material & 0xFFFF) << 32) |
+		(static_cast<uint64_t>(multiDraw ? 0 : 1) << 31) |
+		(static_cast<uint64_t>(vao      & 0x7FFF) << 16) |
+		depthBits;
+}
+
+RenderLayer::InstanceAttributes RenderLayer::_MakeInstanceAttributes(const RenderComponent* renderable)
+{
+	const glm::mat4& transform = renderable->GetGameObject()->GetTransform();
+	const VertexArrayObject::Sptr& mesh = renderable->GetMeshResource()->Mesh;
+
+	// Quantized positions are mapped back to local space as part of the model transform,
+	// normals are not quantized so the normal matrix only uses the object's transform
+	InstanceAttributes instance;
+	instance.u_Model = mesh->HasPositionTransform() ? transform * mesh->GetPositionTransform() : transform;
+	instance.u_NormalMatrix = renderable->GetGameObject()->GetNormalMatrix();
+	instance.u_TextureLayers = renderable->GetMaterial()->GetTextureLayers();
+	return instance;
+}
+
+MeshArena* RenderLayer::_GetArena(const VertexArrayObject::Sptr& mesh)
+{
+	if (!MeshArena::CanStore(mesh)) {
+		return nullptr;
+	}
+	for (const MeshArena::Sptr& arena : _meshArenas) {
+		if (arena->IsCompatible(mesh)) {
+			return arena.get();
+		}
+	}
+
+	_meshArenas.push_back(MeshArena::Create(MeshArena::GetLayout(mesh)));
+	return _meshArenas.back().get();
+}
+
+const VertexArrayObject::Sptr& RenderLayer::_GetInstancedVao(const VertexArrayObject::Sptr& source)
+{
+	auto it = _instancedVaos.find(source.get());
+
+	// If we have no copy yet, or the VAO this was copied from no longer exists, (re)create it
+	if (it == _instancedVaos.end() || it->second.Source.lock() != source) {
+		// Drop copies of VAOs that have been destroyed (ex: when an arena grows), since our copies keep
+		// their buffers alive
+		for (auto stale = _instancedVaos.begin(); stale != _instancedVaos.end();) {
+			stale = stale->second.Source.expired() ? _instancedVaos.erase(stale) : std::next(stale);
+		}
+		InstancedVao& entry = _instancedVaos[source.get()];
+
+		// Sending our 2 matrices and the texture layers as attributes, see fragments/vs_common_instanced.glsl
+		const int stride = sizeof(InstanceAttributes);
+		std::vector<BufferAttribute> instancedParams = {
+			BufferAttribute(INSTANCE_ATTRIB_SLOT + 0, 4, AttributeType::Float, stride, 0, AttribUsage::User0),
+			BufferAttribute(INSTANCE_ATTRIB_SLOT + 1, 4, AttributeType::Float, stride, 4 * sizeof(float), AttribUsage::User0),
+			BufferAttribute(INSTANCE_ATTRIB_SLOT + 2, 4, AttributeType::Float, stride, 8 * sizeof(float), AttribUsage::User0),
+			BufferAttribute(INSTANCE_ATTRIB_SLOT + 3, 4, AttributeType::Float, stride, 12 * sizeof(float), AttribUsage::User0),
+
+			BufferAttribute(INSTANCE_ATTRIB_SLOT + 4, 3, AttributeType::Float, stride, 16 * sizeof(float), AttribUsage::User0),
+			BufferAttribute(INSTANCE_ATTRIB_SLOT + 5, 3, AttributeType::Float, stride, 20 * sizeof(float), AttribUsage::User0),
+			BufferAttribute(INSTANCE_ATTRIB_SLOT + 6, 3, AttributeType::Float, stride, 24 * sizeof(float), AttribUsage::User0),
+
+			BufferAttribute(INSTANCE_ATTRIB_SLOT + 7, 4, AttributeType::Float, stride, 32 * sizeof(float), AttribUsage::User0),
+		};
+
+		entry.Source = source;
+		entry.Vao = source->Clone();
+		entry.Vao->AddVertexBuffer(_instanceBuffer, instancedParams, true);
+		return entry.Vao;
+	}
+
+	return it->second.Vao;
+}
+
+bool RenderLayer::_IsInstanced(const ShaderProgram::Sptr& shader) const
+{
+	return shader->GetAttributeLocation("inModelTransform") == INSTANCE_ATTRIB_SLOT;
+}
+
+void RenderLayer::OnSceneUnload()
+{
+	// Meshes from the old scene may be destroyed, and their space in the arenas is never re-used, so
+	// start with fresh arenas for the new scene rather than growing the old ones forever
+	_meshArenas.clear();
+	_instancedVaos.clear();
+}
+
 void RenderLayer::OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize)
 {
 	if (newSize.x * newSize.y == 0) return;
@@ -182,7 +496,13 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 
 	// Create our common uniform buffers
 	_frameUniforms = std::make_shared<UniformBuffer<FrameLevelUniforms>>(BufferUsage::DynamicDraw);
-	_instanceUniforms = std::make_shared<UniformBuffer<InstanceLevelUniforms>>(BufferUsage::DynamicDraw);
+	_instanceUniforms = StreamingBuffer::Create(BufferType::Uniform);
+
+	// Create the buffer that will store per-instance data for instanced batches
+	_instanceBuffer = VertexBuffer::Create(BufferUsage::DynamicDraw);
+
+	// Create the buffer that the multi-draw commands are streamed through
+	_indirectBuffer = StreamingBuffer::Create(BufferType::DrawIndirect);
 }
 
 const Framebuffer::Sptr& RenderLayer::GetPrimaryFBO() const {
@@ -197,6 +517,22 @@ void RenderLayer::SetBlitEnabled(bool value) {
 	_blitFbo = value;
 }
 
+bool RenderLayer::IsFrustumCullingEnabled() const {
+	return _frustumCulling;
+}
+
+void RenderLayer::SetFrustumCullingEnabled(bool value) {
+	_frustumCulling = value;
+}
+
+bool RenderLayer::IsMultiDrawEnabled() const {
+	return _multiDraw;
+}
+
+void RenderLayer::SetMultiDrawEnabled(bool value) {
+	_multiDraw = value;
+}
+
 Framebuffer::Sptr RenderLayer::GetRenderOutput() {
 	return _primaryFBO;
 }
@@ -2,6 +2,12 @@
 #include "../ApplicationLayer.h"
 #include "Graphics/Framebuffer.h"
 #include "Graphics/Buffers/UniformBuffer.h"
+#include "Graphics/Buffers/StreamingBuffer.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/ShaderProgram.h"
+#include "Graphics/MeshArena.h"
+
+class RenderComponent;
 
 ENUM_FLAGS(RenderFlags, uint32_t,
 	None = 0,
@@ -34,7 +40,8 @@ public:
 
 	// Structure for our instance-level uniforms, matches layout from
 	// fragments/frame_uniforms.glsl
-	// For use with a UBO.
+	// Every object's uniforms are written to the streaming buffer once per frame,
+	// and each draw binds it's own range of the buffer
 	struct InstanceLevelUniforms {
 		// Complete MVP
 		glm::mat4 u_ModelViewProjection;
@@ -44,6 +51,41 @@ public:
 		glm::mat4 u_NormalMatrix;
 	};
 
+	// Structure for our per-instance vertex attributes, matches layout from
+	// fragments/vs_common_instanced.glsl
+	// For use with a per-instance vertex buffer
+	struct InstanceAttributes {
+		// The model transform for the instance
+		glm::mat4 u_Model;
+		// Normal matrix for the instance, only the upper 3x3 is read by the shader
+		glm::mat4 u_NormalMatrix;
+		// The layers of the instance's array textures, see Material::GetTextureLayers
+		glm::vec4 u_TextureLayers;
+	};
+
+	/// <summary>
+	/// Represents a single entry in our render queue. The sort key packs the GL state that
+	/// the draw depends on, so that sorting the queue groups draws sharing the same shader,
+	/// material and mesh together. From most to least significant bits:
+	///   [63..48] shader program handle
+	///   [47..32] material batch ID
+	///   [31]     0 if the draw is part of a multi-draw, so they are grouped at the start of the material
+	///   [30..16] vertex array handle
+	///   [15..0]  view depth, quantized (front to back)
+	/// </summary>
+	struct DrawCommand {
+		uint64_t         SortKey;
+		// Non-owning, only valid for the frame the queue was built in
+		RenderComponent* Renderable;
+		// The material's batch ID, draws with the same ID can share a batch even if their materials differ
+		uint32_t         BatchId;
+		// The arena holding the object's mesh if it will be multi-drawn, otherwise null
+		MeshArena*              Arena;
+		const MeshArena::Entry* ArenaEntry;
+
+		bool operator <(const DrawCommand& other) const { return SortKey < other.SortKey; }
+	};
+
 	RenderLayer();
 	virtual ~RenderLayer();
 
@@ -55,6 +97,19 @@ public:
 	bool IsBlitEnabled() const;
 	void SetBlitEnabled(bool value);
 
+	/// <summary>
+	/// Gets whether objects outside of the camera's view frustum are skipped when rendering
+	/// </summary>
+	bool IsFrustumCullingEnabled() const;
+	void SetFrustumCullingEnabled(bool value);
+
+	/// <summary>
+	/// Gets whether static objects with instanced shaders are merged into shared buffers and
+	/// drawn with glMultiDrawElementsIndirect, one call per material
+	/// </summary>
+	bool IsMultiDrawEnabled() const;
+	void SetMultiDrawEnabled(bool value);
+
 	const glm::vec4& GetClearColor() const;
 	void SetClearColor(const glm::vec4& value);
 
@@ -65,12 +120,15 @@ public:
 
 	virtual void OnAppLoad(const nlohmann::json& config) override;
 	virtual void OnRender(const Framebuffer::Sptr& prevLayer) override;
+	virtual void OnSceneUnload() override;
 	virtual void OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize) override;
 	virtual Framebuffer::Sptr GetRenderOutput() override;
 
 protected:
 	Framebuffer::Sptr _primaryFBO;
 	bool              _blitFbo;
+	bool              _frustumCulling;
+	bool              _multiDraw;
 	glm::vec4         _clearColor;
 	RenderFlags       _renderFlags;
 
@@ -78,5 +136,76 @@ protected:
 	UniformBuffer<FrameLevelUniforms>::Sptr _frameUniforms;
 
 	const int INSTANCE_UBO_BINDING = 1;
-	UniformBuffer<InstanceLevelUniforms>::Sptr _instanceUniforms;
+	StreamingBuffer::Sptr _instanceUniforms;
+
+	// The draw calls for the current frame, kept around so we don't re-allocate every frame
+	std::vector<DrawCommand> _renderQueue;
+
+	// A run of consecutive commands in the render queue that share a mesh and material
+	struct DrawBatch {
+		// Index of the first command in the render queue
+		size_t   First;
+		// The number of commands in the batch
+		uint32_t Count;
+		// The offset into the instance buffer, or -1 if the batch is not instanced
+		int      BaseInstance;
+		// The offset of the batch's InstanceLevelUniforms in the streaming buffer, if not instanced
+		uint32_t UniformOffset;
+		// The arena to draw from if this batch is a multi-draw, otherwise null
+		MeshArena* Arena;
+		// The offset in bytes of the batch's first indirect command, and the number of commands
+		uint32_t   CommandOffset;
+		uint32_t   CommandCount;
+	};
+	std::vector<DrawBatch> _batches;
+
+	// The first vertex input slot used by instanced shaders, see fragments/vs_common_instanced.glsl
+	const int INSTANCE_ATTRIB_SLOT = 8;
+	// Stores the per-instance attributes for all instanced batches this frame
+	VertexBuffer::Sptr _instanceBuffer;
+	std::vector<InstanceAttributes> _instanceData;
+
+	// Copies of mesh VAOs with our instance buffer attached, keyed by the source VAO
+	struct InstancedVao {
+		std::weak_ptr<VertexArrayObject> Source;
+		VertexArrayObject::Sptr          Vao;
+	};
+	std::unordered_map<VertexArrayObject*, InstancedVao> _instancedVaos;
+
+	// Shared buffers for static meshes, one per vertex layout. These are dropped when the scene is
+	// unloaded, since arenas never release the space used by meshes that have been destroyed
+	std::vector<MeshArena::Sptr> _meshArenas;
+	// The indirect commands for all multi-draw batches this frame
+	std::vector<DrawElementsIndirectCommand> _indirectCommands;
+	StreamingBuffer::Sptr _indirectBuffer;
+
+	/// <summary>
+	/// Gets a copy of the given mesh VAO that also sources our per-instance attributes
+	/// from the instance buffer, creating it if needed
+	/// </summary>
+	/// <param name="source">The VAO of the mesh to instance</param>
+	const VertexArrayObject::Sptr& _GetInstancedVao(const VertexArrayObject::Sptr& source);
+	/// <summary>
+	/// Returns true if the shader reads it's transforms from per-instance attributes
+	/// </summary>
+	bool _IsInstanced(const ShaderProgram::Sptr& shader) const;
+	/// <summary>
+	/// Gets the arena that can store the given mesh, creating one if needed
+	/// </summary>
+	/// <returns>The arena for the mesh, or nullptr if the mesh can't be stored in an arena</returns>
+	MeshArena* _GetArena(const VertexArrayObject::Sptr& mesh);
+	/// <summary>
+	/// Gets the per-instance attributes for drawing the given object with an instanced shader
+	/// </summary>
+	static InstanceAttributes _MakeInstanceAttributes(const RenderComponent* renderable);
+
+	/// <summary>
+	/// Packs the state for a single draw into a key for sorting the render queue
+	/// </summary>
+	/// <param name="shader">The shader program handle</param>
+	/// <param name="material">The material's batch ID</param>
+	/// <param name="multiDraw">True if the object will be drawn as part of a multi-draw</param>
+	/// <param name="vao">The vertex array handle</param>
+	/// <param name="depth">The normalized view depth of the object, 0 at the camera, 1 at the far plane</param>
+	static uint64_t _MakeSortKey(uint32_t shader, uint32_t material, bool multiDraw, uint32_t vao, float depth);
 };
\ No newline at end of file
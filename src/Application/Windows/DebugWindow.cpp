@@ -2,6 +2,10 @@
 #include "Application/Application.h"
 #include "Application/ApplicationLayer.h"
 #include "Application/Layers/RenderLayer.h"
+#include "Graphics/Textures/TextureUploader.h"
+#include "Graphics/Textures/TextureArrayPool.h"
+#include "Utils/ObjParser.h"
+#include "Logging.h"
 
 DebugWindow::DebugWindow() :
 	IEditorWindow()
@@ -37,4 +41,39 @@ void DebugWindow::RenderMenuBar()
 	if (changed) {
 		renderLayer->SetRenderFlags(flags);
 	}
+
+	ImGui::Separator();
+
+	bool culling = renderLayer->IsFrustumCullingEnabled();
+	if (ImGui::Checkbox("Frustum Culling", &culling)) {
+		renderLayer->SetFrustumCullingEnabled(culling);
+	}
+
+	bool multiDraw = renderLayer->IsMultiDrawEnabled();
+	if (ImGui::Checkbox("Multi-Draw Static Objects", &multiDraw)) {
+		renderLayer->SetMultiDrawEnabled(multiDraw);
+	}
+
+	ImGui::Separator();
+
+	int uploadBudget = static_cast<int>(TextureUploader::GetFrameBudget() / 1024);
+	ImGui::SetNextItemWidth(100.0f);
+	if (ImGui::DragInt("Texture Upload KB/Frame", &uploadBudget, 16.0f, 64, 64 * 1024)) {
+		TextureUploader::SetFrameBudget(static_cast<uint32_t>(uploadBudget) * 1024);
+	}
+
+	ImGui::Text("Texture Arrays: %d (%d textures)", static_cast<int>(TextureArrayPool::GetArrayCount()), static_cast<int>(TextureArrayPool::GetTextureCount()));
+
+	ImGui::Separator();
+
+	ImGui::SetNextItemWidth(200.0f);
+	ImGui::InputText("##objBenchmark", _objBenchmarkPath, 256);
+	ImGui::SameLine();
+	if (ImGui::Button("Benchmark OBJ Parser")) {
+		try {
+			ObjParser::Benchmark(_objBenchmarkPath);
+		} catch (const std::exception& e) {
+			LOG_ERROR("Failed to benchmark OBJ parser with \"{}\": {}", _objBenchmarkPath, e.what());
+		}
+	}
 }
@@ -15,4 +15,6 @@ public:
 	virtual void RenderMenuBar() override;
 
 protected:
+	// The OBJ file to run ObjParser::Benchmark on
+	char _objBenchmarkPath[256] = "Monkey.obj";
 };
\ No newline at end of file
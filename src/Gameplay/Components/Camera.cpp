@@ -91,6 +91,15 @@ namespace Gameplay {
 		_isProjectionDirty = true;
 	}
 
+	float Camera::GetPixelsPerUnit(float distance, float viewportHeight) const {
+		if (_isOrtho) {
+			return viewportHeight / _orthoVerticalScale;
+		}
+		// Anything closer than the near plane would be clipped anyways
+		distance = glm::max(distance, _nearPlane);
+		return viewportHeight / (2.0f * distance * glm::tan(_fovRadians / 2.0f));
+	}
+
 	const glm::mat4& Camera::GetView() const {
 		return GetGameObject()->GetInverseTransform();
 	}
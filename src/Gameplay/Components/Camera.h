@@ -67,6 +67,25 @@ namespace Gameplay {
 		/// Gets whether this camera is in orthographic mode
 		/// </summary>
 		bool GetOrthoEnabled() const { return _isOrtho; }
+		/// <summary>
+		/// Gets the vertical field of view in radians for this camera
+		/// </summary>
+		float GetFovRadians() const { return _fovRadians; }
+		/// <summary>
+		/// Gets how many pixels a world unit will cover vertically on screen at the given distance from
+		/// the camera. In orthographic mode, this does not depend on the distance
+		/// </summary>
+		/// <param name="distance">The distance from the camera, in world units</param>
+		/// <param name="viewportHeight">The height of the viewport being rendered to, in pixels</param>
+		float GetPixelsPerUnit(float distance, float viewportHeight) const;
+		/// <summary>
+		/// Gets the distance to the camera's near clipping plane, in world units
+		/// </summary>
+		float GetNearPlane() const { return _nearPlane; }
+		/// <summary>
+		/// Gets the distance to the camera's far clipping plane, in world units
+		/// </summary>
+		float GetFarPlane() const { return _farPlane; }
 
 		/// <summary>
 		/// Gets the view matrix for this camera
@@ -1,8 +1,10 @@
 #pragma once
 #include <functional>
 #include "IComponent.h"
+#include "ComponentPool.h"
 #include <typeindex>
 #include <optional>
+#include <unordered_map>
 #include <Logging.h>
 
 namespace Gameplay {
@@ -42,7 +44,43 @@ namespace Gameplay {
 					result->_weakSelfPtr = result;
 
 					// Add the component to the global pools
-					_Components[result->_realType].push_back(result);
+					_Track(result.get());
+					return result;
+				}
+			}
+			return nullptr;
+		}
+
+		/// <summary>
+		/// Loads a component with the given type name from a JSON blob, where the GUID and enabled
+		/// state are stored outside of the blob (for instance in a binary scene's component table)
+		/// If the type name does not correspond to a registered type, will return nullptr
+		/// </summary>
+		/// <param name="typeName">The name of the type to load (taken from GetComponentTypeName of component)</param>
+		/// <param name="blob">The JSON blob to decode</param>
+		/// <param name="guid">The GUID to give the component</param>
+		/// <param name="enabled">True if the component should be enabled</param>
+		/// <returns>The component as decoded from the JSON data, or nullptr</returns>
+		inline IComponent::Sptr Load(const std::string& typeName, const nlohmann::json& blob, Guid guid, bool enabled) {
+			// Try and get the type index from the name
+			std::optional<std::type_index> typeIndex = _TypeNameMap[typeName];
+
+			// If we have a value for type index, this component type was registered!
+			if (typeIndex.has_value()) {
+				// Get the load callback and make sure it exists
+				LoadComponentFunc callback = _TypeLoadRegistry[typeIndex.value()];
+				if (callback) {
+					// Invoke the loader, then apply the base component data
+					IComponent::Sptr result = callback(blob);
+					result->OverrideGUID(guid);
+					result->IsEnabled = enabled;
+
+					// Make sure the component knows it's own type
+					result->_realType = typeIndex.value();
+					result->_weakSelfPtr = result;
+
+					// Add the component to the global pools
+					_Track(result.get());
 					return result;
 				}
 			}
@@ -71,7 +109,7 @@ namespace Gameplay {
 					result->_realType = typeIndex.value();
 					result->_weakSelfPtr = result;
 					// Add the component to the global pools
-					_Components[result->_realType].push_back(result);
+					_Track(result.get());
 					return result;
 				}
 			}
@@ -98,7 +136,7 @@ namespace Gameplay {
 				result->_realType = type;
 				result->_weakSelfPtr = result;
 				// Add the component to the global pools
-				_Components[result->_realType].push_back(result);
+				_Track(result.get());
 				return result;
 			}
 			return nullptr;
@@ -131,16 +169,17 @@ namespace Gameplay {
 			std::type_index type = std::type_index(typeid(ComponentType));
 			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
 
-			// Create component, forwarding arguments
-			std::shared_ptr<ComponentType> component = std::make_shared<ComponentType>(std::forward<TArgs>(args)...);
+			// Create component, forwarding arguments. We allocate from the arena for the type so
+			// that components of the same type are packed together in memory
+			std::shared_ptr<ComponentType> component = std::allocate_shared<ComponentType>(ComponentAllocator<ComponentType>(), std::forward<TArgs>(args)...);
 
 			// Make sure the component knows it's concrete type
 			component->_realType = type;
 			// Give the component a weak pointer to itself that it can upcast to a shared pointer when needed
 			component->_weakSelfPtr = component;
 
-			// Add to global component list for that type
-			_Components[type].push_back(component);
+			// Add to global component pool for that type
+			_Track(component.get());
 
 			// Return the result
 			return component;
@@ -161,24 +200,13 @@ namespace Gameplay {
 			std::type_index type = std::type_index(typeid(ComponentType));
 			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
 
-			// Clear any dead weak pointers
-			auto removeIt = std::remove_if(_Components[type].begin(), _Components[type].end(), [](const std::weak_ptr<IComponent>& ptr) {
-				return ptr.expired();
-			});
-			_Components[type].erase(removeIt, _Components[type].end());
-
-			// Search the component store for a component that matches that ID
-			auto& it = std::find_if(_Components[type].begin(), _Components[type].end(), [&](const std::weak_ptr<IComponent>& ptr) {
-				return (ptr.lock())->GetGUID() == id;
-			});
-
-			// If the component was found, return it. Otherwise return nullptr
-			if (it != _Components[type].end()) {
+			// Look up the component in the GUID index, making sure that it is the type we asked for
+			auto it = _ComponentsByGuid.find(id);
+			if (it != _ComponentsByGuid.end() && it->second->_realType == type) {
 				// We need to lock the weak pointer to convert it to a shared ptr
-				return std::dynamic_pointer_cast<ComponentType>((*it).lock());
-			} else {
-				return nullptr;
+				return std::static_pointer_cast<ComponentType>(it->second->SelfRef().lock());
 			}
+			return nullptr;
 		}
 
 		/// <summary>
@@ -195,18 +223,41 @@ namespace Gameplay {
 			std::type_index type = std::type_index(typeid(ComponentType));
 			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
 
-			// Iterate over all the components in the store
-			for (auto& wptr : _Components[type]) {
-				// Lock the weak pointer to get a shared pointer (maybe)
-				std::shared_ptr<IComponent> sptr = wptr.lock();
-				// If the pointer is alive and matches our enabled criteria, invoke the callback
-				if (sptr && sptr->IsEnabled | includeDisabled) {
-					// Upcast to component type and invoke the callback
-					callback(std::dynamic_pointer_cast<ComponentType>(sptr));
+			// Iterate over all the components in the pool, by index in case the callback removes components
+			ComponentPool& pool = _Components[type];
+			for (size_t ix = 0; ix < pool.Size(); ) {
+				IComponent* component = pool.Data()[ix];
+				// If the component matches our enabled criteria, invoke the callback
+				if (component->IsEnabled || includeDisabled) {
+					// Lock our weak self pointer to get a shared pointer, then cast to component type and invoke the callback
+					callback(std::static_pointer_cast<ComponentType>(component->SelfRef().lock()));
+				}
+				// Removing a component swaps the last one into it's slot, so we only move on if the slot
+				// still holds the component we just visited, otherwise the swapped in one would be skipped
+				if (ix < pool.Size() && pool.Data()[ix] == component) {
+					ix++;
 				}
 			}
 		}
 
+		/// <summary>
+		/// Gets a view over all live components of the given type, stored contiguously. This is the fast
+		/// path for iterating over components, as it does not touch any reference counts or require
+		/// dynamic casts, but the pointers should not be stored past the current frame. Note that
+		/// this includes disabled components
+		/// </summary>
+		/// <typeparam name="ComponentType">The type of component to iterate on</typeparam>
+		template <
+			typename ComponentType,
+			typename = typename std::enable_if<std::is_base_of<IComponent, ComponentType>::value>::type>
+		ComponentSpan<ComponentType> Pool() {
+			// We can use typeid and type_index to get a unique ID for our types
+			std::type_index type = std::type_index(typeid(ComponentType));
+			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
+
+			return _Components[type].As<ComponentType>();
+		}
+
 		/// <summary>
 		/// Attempts to register a given type as a component, should be called for each component type 
 		/// at the start of you application
@@ -234,7 +285,12 @@ namespace Gameplay {
 		/// Removes all components of all types from the registry, whether they are referenced elsewhere or not
 		/// </summary>
 		inline void FlushAll() {
-			_Components = std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>>();
+			// Make sure the components know they are no longer in a pool
+			for (auto& [type, pool] : _Components) {
+				pool.Clear();
+			}
+			_Components = std::unordered_map<std::type_index, ComponentPool>();
+			_ComponentsByGuid.clear();
 		}
 
 	private:
@@ -250,10 +306,22 @@ namespace Gameplay {
 		// Stores functions to load components from JSON, indexed on the type that they load
 		inline static std::unordered_map<std::type_index, CreateComponentFunc> _TypeCreateRegistry;
 
-		// Weak pointers let us store a reference to an object stored by a shared pointer, without
-		// actually increasing the reference count. Thus components will be destroyed at the correct
-		// time (when the only reference is the one stored here).
-		std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>> _Components;  
+		// The pools store raw pointers to the live components of each type in a dense array. We don't
+		// hold a reference, so components will be destroyed at the correct time (when the last shared
+		// pointer is released), at which point they remove themselves from their pool
+		std::unordered_map<std::type_index, ComponentPool> _Components;
+		// Maps component GUIDs to the live components, so components can resolve references to each other
+		// without searching the pools
+		std::unordered_map<Guid, IComponent*> _ComponentsByGuid;
+
+		/// <summary>
+		/// Adds a newly created or loaded component to the pool for it's type and the GUID index
+		/// </summary>
+		/// <param name="component">The component to add, should have it's real type and GUID set</param>
+		inline void _Track(IComponent* component) {
+			_Components[component->_realType].Add(component);
+			_ComponentsByGuid[component->GetGUID()] = component;
+		}
 
 		template <typename T>
 		static IComponent::Sptr ParseTypeFromBlob(const nlohmann::json& blob) {
@@ -266,8 +334,8 @@ namespace Gameplay {
 			std::type_index type = std::type_index(typeid(ComponentType));
 			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
 
-			// Create component, forwarding arguments
-			std::shared_ptr<ComponentType> component = std::make_shared<ComponentType>();
+			// Create component from the arena for the type
+			std::shared_ptr<ComponentType> component = std::allocate_shared<ComponentType>(ComponentAllocator<ComponentType>());
 
 			// Make sure the component knows it's concrete type
 			component->_realType = type;
@@ -281,22 +349,24 @@ namespace Gameplay {
 		/// <summary>
 		/// Removes a given component from the global pools. To be used in the IComponent destructor
 		/// </summary>
-		/// <typeparam name="ComponentType">The type of component to destroy</typeparam>
 		/// <param name="component">A raw pointer to the component to remove (should be called from IComponent destructor)</param>
 		/// <returns>True if the element was removed, false if not</returns>
 		inline void Remove(const IComponent* component) {
 			// Make sure the component's type was one that was registered
 			LOG_ASSERT(_TypeLoadRegistry[component->_realType] != nullptr, "You must register component types before creating them!");
 
-			// Get a reference to the vector of components for easy access
-			std::vector<std::weak_ptr<IComponent>>& componentStore = _Components[component->_realType];
+			// Components that were never added to a pool (or were flushed) have nothing to remove
+			if (component->_poolIndex < 0) {
+				return;
+			}
+
+			// Swap the last component of the type into our slot
+			_Components[component->_realType].Remove(const_cast<IComponent*>(component));
 
-			// Clear any dead weak pointers
-			auto it = std::remove_if(componentStore.begin(), componentStore.end(), [](const std::weak_ptr<IComponent>& ptr) {
-				return ptr.expired();
-			});
-			if (it != componentStore.end()) {
-				componentStore.erase(it);
+			// Only remove the index entry if it actually points to us
+			auto it = _ComponentsByGuid.find(component->GetGUID());
+			if (it != _ComponentsByGuid.end() && it->second == component) {
+				_ComponentsByGuid.erase(it);
 			}
 		}
 	};
@@ -0,0 +1,219 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <new>
+#include <cstdint>
+#include "IComponent.h"
+#include "Utils/Macros.h"
+
+namespace Gameplay {
+	/// <summary>
+	/// A fixed size block allocator that hands out slots from large chunks, so that objects of the
+	/// same size end up next to each other in memory. Freed slots are recycled before new chunks
+	/// are allocated. There is one arena per allocation size/alignment
+	/// </summary>
+	/// <typeparam name="Size">The size of a single allocation, in bytes</typeparam>
+	/// <typeparam name="Align">The alignment of a single allocation, in bytes</typeparam>
+	template <size_t Size, size_t Align>
+	class ComponentArena {
+	public:
+		NO_COPY(ComponentArena);
+		NO_MOVE(ComponentArena);
+
+		static ComponentArena& Get() {
+			static ComponentArena instance;
+			return instance;
+		}
+
+		void* Allocate() {
+			// Re-use the most recently freed slot if we have one
+			if (_freeList != nullptr) {
+				FreeSlot* result = _freeList;
+				_freeList = result->Next;
+				return result;
+			}
+
+			// Grab a new chunk if the current one is full
+			if (_chunks.empty() || _chunkOffset == SLOTS_PER_CHUNK) {
+				_chunks.push_back(static_cast<uint8_t*>(::operator new(SLOT_SIZE * SLOTS_PER_CHUNK, std::align_val_t(SLOT_ALIGN))));
+				_chunkOffset = 0;
+			}
+
+			return _chunks.back() + (SLOT_SIZE * _chunkOffset++);
+		}
+
+		void Free(void* ptr) {
+			FreeSlot* slot = static_cast<FreeSlot*>(ptr);
+			slot->Next = _freeList;
+			_freeList = slot;
+		}
+
+	private:
+		struct FreeSlot {
+			FreeSlot* Next;
+		};
+
+		// Slots need to be able to fit a free list entry, and be a multiple of the alignment
+		static constexpr size_t SLOT_ALIGN = Align > alignof(FreeSlot) ? Align : alignof(FreeSlot);
+		static constexpr size_t SLOT_SIZE  = (((Size > sizeof(FreeSlot) ? Size : sizeof(FreeSlot)) + SLOT_ALIGN - 1) / SLOT_ALIGN) * SLOT_ALIGN;
+		static constexpr size_t SLOTS_PER_CHUNK = 64;
+
+		// Note that chunks are never released, since shared pointers to components may
+		// outlive the arena during static destruction
+		std::vector<uint8_t*> _chunks;
+		size_t                _chunkOffset = 0;
+		FreeSlot*             _freeList = nullptr;
+
+		ComponentArena() = default;
+	};
+
+	/// <summary>
+	/// Allocator for use with std::allocate_shared, places components (and their control blocks)
+	/// into a ComponentArena so that components of the same type are packed together
+	/// </summary>
+	template <typename T>
+	struct ComponentAllocator {
+		typedef T value_type;
+
+		ComponentAllocator() = default;
+		template <typename U>
+		ComponentAllocator(const ComponentAllocator<U>&) {}
+
+		T* allocate(size_t count) {
+			if (count != 1) {
+				return std::allocator<T>().allocate(count);
+			}
+			return static_cast<T*>(ComponentArena<sizeof(T), alignof(T)>::Get().Allocate());
+		}
+
+		void deallocate(T* ptr, size_t count) {
+			if (count != 1) {
+				std::allocator<T>().deallocate(ptr, count);
+			} else {
+				ComponentArena<sizeof(T), alignof(T)>::Get().Free(ptr);
+			}
+		}
+
+		template <typename U>
+		bool operator ==(const ComponentAllocator<U>&) const { return true; }
+		template <typename U>
+		bool operator !=(const ComponentAllocator<U>&) const { return false; }
+	};
+
+	template <typename ComponentType>
+	class ComponentSpan;
+
+	/// <summary>
+	/// Stores all the live components of a single type in a dense array. This is a sparse set,
+	/// where each component stores it's own index into the dense array (it's handle), letting us
+	/// add and remove components in constant time
+	///
+	/// The pool does not own the components, they remove themselves when they are destroyed
+	/// </summary>
+	class ComponentPool {
+	public:
+		ComponentPool() = default;
+
+		/// <summary>
+		/// Adds a component to the end of the pool
+		/// </summary>
+		void Add(IComponent* component) {
+			component->_poolIndex = static_cast<int>(_dense.size());
+			_dense.push_back(component);
+		}
+
+		/// <summary>
+		/// Removes a component from the pool, by moving the last element into it's slot
+		/// </summary>
+		void Remove(IComponent* component) {
+			int index = component->_poolIndex;
+			if (index < 0 || index >= static_cast<int>(_dense.size()) || _dense[index] != component) {
+				return;
+			}
+
+			// Swap the last element into the removed slot, and update it's handle
+			IComponent* last = _dense.back();
+			_dense[index] = last;
+			last->_poolIndex = index;
+			_dense.pop_back();
+
+			component->_poolIndex = -1;
+		}
+
+		/// <summary>
+		/// Removes all components from the pool
+		/// </summary>
+		void Clear() {
+			for (IComponent* component : _dense) {
+				component->_poolIndex = -1;
+			}
+			_dense.clear();
+		}
+
+		size_t Size() const { return _dense.size(); }
+		IComponent* const* Data() const { return _dense.data(); }
+
+		/// <summary>
+		/// Gets a typed view over the components in this pool
+		/// </summary>
+		/// <typeparam name="ComponentType">The concrete type of the components in the pool</typeparam>
+		template <typename ComponentType>
+		ComponentSpan<ComponentType> As() const {
+			return ComponentSpan<ComponentType>(this);
+		}
+
+	private:
+		std::vector<IComponent*> _dense;
+	};
+
+	/// <summary>
+	/// A typed view over the components in a pool, which can be used in a range based for loop.
+	/// Iterating does not touch any reference counts, and the cast to the concrete type is static.
+	///
+	/// The view reads the pool by index, so components of the same type can be added or removed while
+	/// iterating. Added components are visited at the end, and a removed component's slot is visited
+	/// again since the pool moves it's last component into it
+	/// </summary>
+	/// <typeparam name="ComponentType">The concrete type of the components in the pool</typeparam>
+	template <typename ComponentType>
+	class ComponentSpan {
+	public:
+		class Iterator {
+		public:
+			Iterator(const ComponentPool* pool, size_t index) : _pool(pool), _index(index), _current(nullptr) { _Load(); }
+
+			ComponentType* operator*() const { return static_cast<ComponentType*>(_current); }
+			Iterator& operator++() {
+				// Only move on if the slot still holds the component we just visited
+				if (_index < _pool->Size() && _pool->Data()[_index] == _current) {
+					_index++;
+				}
+				_Load();
+				return *this;
+			}
+			bool operator ==(const Iterator& other) const { return _IsEnd() == other._IsEnd() && (_IsEnd() || _index == other._index); }
+			bool operator !=(const Iterator& other) const { return !(*this == other); }
+
+		private:
+			const ComponentPool* _pool;
+			size_t               _index;
+			IComponent*          _current;
+
+			bool _IsEnd() const { return _index >= _pool->Size(); }
+			void _Load() { _current = _IsEnd() ? nullptr : _pool->Data()[_index]; }
+		};
+
+		ComponentSpan(const ComponentPool* pool) : _pool(pool) {}
+
+		Iterator begin() const { return Iterator(_pool, 0); }
+		// The end is checked against the pool's current size, so it stays correct if the pool changes size
+		Iterator end() const { return Iterator(_pool, SIZE_MAX); }
+
+		size_t size() const { return _pool->Size(); }
+		bool empty() const { return _pool->Size() == 0; }
+		ComponentType* operator[](size_t index) const { return static_cast<ComponentType*>(_pool->Data()[index]); }
+
+	private:
+		const ComponentPool* _pool;
+	};
+}
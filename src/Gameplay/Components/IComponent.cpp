@@ -28,7 +28,8 @@ namespace Gameplay {
 		IResource(),
 		IsEnabled(true),
 		_realType(typeid(IComponent)),
-		_context(nullptr)
+		_context(nullptr),
+		_poolIndex(-1)
 	{ }
 
 	IComponent::~IComponent() {
@@ -158,10 +158,13 @@ namespace Gameplay {
 
 	private:
 		friend class ComponentManager;
+		friend class ComponentPool;
 		friend class GameObject;
 
 		std::type_index _realType;
 		GameObject* _context;
+		// Our index in the ComponentManager's pool for our type, or -1 if we are not in a pool
+		int _poolIndex;
 
 		// By storing a weak pointer to ourselves, we can pass a pointer to this
 		// for things like bullet user pointers
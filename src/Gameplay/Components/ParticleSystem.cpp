@@ -95,8 +95,9 @@ void ParticleSystem::Update()
 	glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Metadata)); // metadata 
 
 	// Bind the update shader and send our relevant uniforms
+	static const UniformHandle u_Gravity = "u_Gravity"_uniform;
 	_updateShader->Bind();
-	_updateShader->SetUniform("u_Gravity", _gravity);
+	_updateShader->SetUniform(u_Gravity, _gravity);
 
 	// Our particles are points that we're simulating
 	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, _query);
@@ -2,17 +2,22 @@
 
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ImGuiHelper.h"
+#include "Utils/JsonGlmHelpers.h"
 
 
 RenderComponent::RenderComponent(const Gameplay::MeshResource::Sptr& mesh, const Gameplay::Material::Sptr& material) :
 	_mesh(mesh), 
 	_material(material), 
+	_lod(0),
+	_isStatic(false),
 	_meshBuilderParams(std::vector<MeshBuilderParam>()) 
 { }
 
 RenderComponent::RenderComponent() : 
 	_mesh(nullptr), 
 	_material(nullptr), 
+	_lod(0),
+	_isStatic(false),
 	_meshBuilderParams(std::vector<MeshBuilderParam>())
 { }
 
@@ -36,10 +41,33 @@ const Gameplay::Material::Sptr& RenderComponent::GetMaterial() const {
 	return _material;
 }
 
+void RenderComponent::UpdateLod(float pixelsPerUnit, float maxPixelError) {
+	_lod = 0;
+	VertexArrayObject::Sptr mesh = GetMesh();
+	if (mesh == nullptr || mesh->GetLods().size() < 2) {
+		return;
+	}
+
+	// LOD errors are in the mesh's local space, so scale them by the largest axis of the object's transform
+	const glm::mat4& transform = GetGameObject()->GetTransform();
+	float scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+	float pixelsPerLocalUnit = pixelsPerUnit * scale;
+
+	// LODs are ordered by increasing error, so stop at the first one that would be too visible
+	const std::vector<VertexArrayObject::MeshLod>& lods = mesh->GetLods();
+	for (uint32_t ix = 1; ix < lods.size(); ix++) {
+		if (lods[ix].Error * pixelsPerLocalUnit > maxPixelError) {
+			break;
+		}
+		_lod = ix;
+	}
+}
+
 nlohmann::json RenderComponent::ToJson() const {
 	nlohmann::json result;
 	result["mesh"] = _mesh ? _mesh->GetGUID().str() : "null";
 	result["material"] = _material ? _material->GetGUID().str() : "null";
+	result["static"] = _isStatic;
 	return result;
 }
 
@@ -47,6 +75,7 @@ RenderComponent::Sptr RenderComponent::FromJson(const nlohmann::json& data) {
 	RenderComponent::Sptr result = std::make_shared<RenderComponent>();
 	result->_mesh = ResourceManager::Get<Gameplay::MeshResource>(Guid(data["mesh"].get<std::string>()));
 	result->_material = ResourceManager::Get<Gameplay::Material>(Guid(data["material"].get<std::string>()));
+	result->_isStatic = JsonGet(data, "static", false);
 
 	return result;
 }
@@ -54,7 +83,9 @@ RenderComponent::Sptr RenderComponent::FromJson(const nlohmann::json& data) {
 void RenderComponent::RenderImGui() {
 	ImGui::Text("Indexed:   %s", GetMesh() != nullptr ? (_mesh->Mesh->GetIndexBuffer() != nullptr ? "true" : "false") : "N/A");
 	ImGui::Text("Triangles: %d", GetMesh() != nullptr ? (_mesh->Mesh->GetElementCount() / 3) : 0);
+	ImGui::Text("LOD:       %d / %d", _lod, GetMesh() != nullptr ? _mesh->Mesh->GetLodCount() : 0);
 	ImGui::Text("Source:    %s", (_mesh == nullptr || _mesh->Filename.empty()) ? "Generated" : _mesh->Filename.c_str());
+	ImGui::Checkbox("Static", &_isStatic);
 	ImGui::Separator();
 	ImGui::Text("Material:  %s", _material != nullptr ? _material->Name.c_str() : "NULL");
 	ImGuiHelper::ResourceDragTarget<Gameplay::Material>(_material);
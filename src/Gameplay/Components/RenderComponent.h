@@ -42,6 +42,28 @@ public:
 	/// <param name="mat">The material for this object</param>
 	void SetMaterial(const Gameplay::Material::Sptr& mat);
 
+	/// <summary>
+	/// Picks the level of detail to draw this object with, this will be the least detailed LOD whose
+	/// simplification error would appear smaller than maxPixelError on screen
+	/// </summary>
+	/// <param name="pixelsPerUnit">How many pixels a world unit covers on screen at this object's distance from the camera</param>
+	/// <param name="maxPixelError">The largest error that is allowed to be visible, in pixels</param>
+	void UpdateLod(float pixelsPerUnit, float maxPixelError = DEFAULT_LOD_PIXEL_ERROR);
+	/// <summary>
+	/// Gets the level of detail selected by the last call to UpdateLod, 0 is the full detail mesh
+	/// </summary>
+	uint32_t GetLod() const { return _lod; }
+
+	/// <summary>
+	/// Marks this object as static scenery. Static objects whose material uses an instanced shader
+	/// are merged into shared buffers and drawn with multi-draw indirect by the RenderLayer
+	/// </summary>
+	void SetStatic(bool value) { _isStatic = value; }
+	bool IsStatic() const { return _isStatic; }
+
+	// How far a simplified mesh is allowed to be from the full mesh on screen before we use a more detailed LOD
+	static constexpr float DEFAULT_LOD_PIXEL_ERROR = 1.0f;
+
 	// Inherited from IComponent
 
 	virtual void RenderImGui() override;
@@ -55,6 +77,10 @@ protected:
 	// The object's material
 	Gameplay::Material::Sptr      _material;
 
+	// The level of detail to draw the mesh at this frame
+	uint32_t                      _lod;
+	bool                          _isStatic;
+
 	// If we want to use MeshFactory, we can populate this list
 	std::vector<MeshBuilderParam> _meshBuilderParams;
 };
\ No newline at end of file
@@ -28,7 +28,11 @@ namespace Gameplay {
 		_isLocalTransformDirty(true),
 		_worldTransform(MAT4_IDENTITY),
 		_inverseWorldTransform(MAT4_IDENTITY),
+		_normalMatrix(glm::mat3(1.0f)),
 		_isWorldTransformDirty(true),
+		_localBounds(Bounds()),
+		_worldBounds(Bounds()),
+		_isWorldBoundsDirty(true),
 		_parent(WeakRef()),
 		_children(std::vector<WeakRef>())
 	{ }
@@ -37,7 +41,8 @@ namespace Gameplay {
 	{
 		if (_isLocalTransformDirty) {
 			_localTransform = glm::translate(MAT4_IDENTITY, _position) * glm::mat4_cast(_rotation) * glm::scale(MAT4_IDENTITY, _scale);
-			_inverseLocalTransform = glm::inverse(_localTransform);
+			// Since this is a TRS matrix, we can invert each part on it's own instead of doing a general inverse
+			_inverseLocalTransform = glm::scale(MAT4_IDENTITY, 1.0f / _scale) * glm::mat4_cast(glm::conjugate(_rotation)) * glm::translate(MAT4_IDENTITY, -_position);
 			_isLocalTransformDirty = false;
 			_isWorldTransformDirty = true;
 
@@ -62,7 +67,8 @@ namespace Gameplay {
 			// If out parent exists, we apply our local transformation relative to the parent's world transformation
 			if (parent != nullptr) {
 				_worldTransform = parent->GetTransform() * _localTransform;
-				_inverseWorldTransform = glm::inverse(_worldTransform);
+				// inverse(A * B) = inverse(B) * inverse(A), and we already have both inverses
+				_inverseWorldTransform = _inverseLocalTransform * parent->GetInverseTransform();
 			}
 
 			// If our parent is null, we can simply use the local transform as the world transform
@@ -70,7 +76,12 @@ namespace Gameplay {
 				_worldTransform = _localTransform;
 				_inverseWorldTransform = _inverseLocalTransform;
 			}
+			// The normal matrix is the transpose of the inverse, so we get it for free
+			_normalMatrix = glm::transpose(glm::mat3(_inverseWorldTransform));
 			_isWorldTransformDirty = false;
+
+			// Our world bounds depend on the world transform
+			_isWorldBoundsDirty = true;
 		}
 	}
 
@@ -81,6 +92,14 @@ namespace Gameplay {
 		_children.erase(it, _children.end());
 	}
 
+	void GameObject::_AttachLoadedComponent(const IComponent::Sptr& component) {
+		component->_context = this;
+
+		// Add component to object and allow it to perform self initialization
+		_components.push_back(component);
+		component->OnLoad();
+	}
+
 	void GameObject::LookAt(const glm::vec3& point) {
 		glm::mat4 rot = glm::lookAt(_position, point, glm::vec3(0.0f, 0.0f, 1.0f));
 		// Take the conjugate of the quaternion, as lookAt returns the *inverse* rotation
@@ -157,6 +176,23 @@ namespace Gameplay {
 		return _inverseWorldTransform;
 	}
 
+	const glm::mat3& GameObject::GetNormalMatrix() const {
+		_RecalcWorldTransform();
+		return _normalMatrix;
+	}
+
+	const Bounds& GameObject::GetWorldBounds(const Bounds& localBounds) const {
+		_RecalcWorldTransform();
+
+		// Re-calculate if we've moved, or if we're being asked about different bounds than last time
+		if (_isWorldBoundsDirty || localBounds != _localBounds) {
+			_localBounds = localBounds;
+			_worldBounds = localBounds.Transform(_worldTransform);
+			_isWorldBoundsDirty = false;
+		}
+		return _worldBounds;
+	}
+
 	const glm::mat4& GameObject::GetLocalTransform() const
 	{
 		_RecalcLocalTransform();
@@ -470,11 +506,7 @@ namespace Gameplay {
 			// based on the type name (note that all component types need to be
 			// registered at the start of the application)
 			IComponent::Sptr component = scene->Components().Load(typeName, value);
-			component->_context = result.get();
-
-			// Add component to object and allow it to perform self initialization
-			result->_components.push_back(component);
-			component->OnLoad();
+			result->_AttachLoadedComponent(component);
 		}
 
 		return result;
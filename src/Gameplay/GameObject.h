@@ -12,6 +12,7 @@
 #include "Gameplay/Components/IComponent.h"
 #include "Gameplay/Components/ComponentManager.h"
 #include "Utils/ResourceManager/IResource.h"
+#include "Utils/Bounds.h"
 
 class InspectorWindow;
 class HierarchyWindow;
@@ -220,10 +221,22 @@ namespace Gameplay {
 		/// This matrix transforms points from world space to local space
 		/// </summary>
 		const glm::mat4& GetInverseTransform() const;
+		/// <summary>
+		/// Gets or recalculates the matrix for transforming normals from local space to world space.
+		/// This is the inverse transpose of the world transform, and is cached along with it
+		/// </summary>
+		const glm::mat3& GetNormalMatrix() const;
 
 		const glm::mat4& GetLocalTransform() const;
 		const glm::mat4& GetInverseLocalTransform() const;
 
+		/// <summary>
+		/// Gets the world space bounds for the given local space bounds (ex: from a mesh) attached
+		/// to this object. The result is cached until the object's world transform changes
+		/// </summary>
+		/// <param name="localBounds">The bounds in this object's local space</param>
+		const Bounds& GetWorldBounds(const Bounds& localBounds) const;
+
 		/// <summary>
 		/// Allows components to render GUI elements to the screen
 		/// </summary>
@@ -351,8 +364,14 @@ namespace Gameplay {
 
 		mutable glm::mat4 _worldTransform;
 		mutable glm::mat4 _inverseWorldTransform;
+		mutable glm::mat3 _normalMatrix;
 		mutable bool _isWorldTransformDirty;
 
+		// Cached world space bounds, and the local bounds they were calculated from
+		mutable Bounds _localBounds;
+		mutable Bounds _worldBounds;
+		mutable bool _isWorldBoundsDirty;
+
 		// For the hierarchy
 		WeakRef _parent;
 		std::vector<WeakRef> _children;
@@ -376,6 +395,11 @@ namespace Gameplay {
 		void _RecalcWorldTransform() const;
 
 		void _PurgeDeletedChildren();
+
+		/// <summary>
+		/// Attaches a component that was loaded from a scene file to this object and invokes it's OnLoad
+		/// </summary>
+		void _AttachLoadedComponent(const IComponent::Sptr& component);
 	};
 
 }
\ No newline at end of file
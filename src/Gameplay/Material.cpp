@@ -7,12 +7,35 @@
 #include "Utils/ImGuiHelper.h"
 #include "Graphics/Textures/Texture1D.h"
 #include "Graphics/Textures/Texture3D.h"
+#include <algorithm>
 
 namespace Gameplay {
+	uint32_t Material::__nextSortId = 0;
+	UniformBufferPool::Sptr Material::__blockPool = nullptr;
+	std::unordered_map<std::string, Material::BatchEntry> Material::__batchIds;
+	std::vector<uint32_t> Material::__freeBatchIds;
+
 	Material::Material(const ShaderProgram::Sptr& shader) :
 		IResource(),
 		_shader(shader),
-		_uniforms(std::unordered_map<std::string, UniformData>())
+		_uniforms(std::unordered_map<std::string, UniformData>()),
+		_sortId(__nextSortId++),
+		_records(),
+		_dirtyRecords(),
+		_textures(),
+		_textureHandles(),
+		_isCompiled(false),
+		_arrayTextures(),
+		_textureLayers(0.0f),
+		_layersGeneration(0),
+		_hasPendingLayers(false),
+		_batchId(0),
+		_isBatchIdDirty(true),
+		_batchKey(),
+		_blockUniforms(),
+		_blockOffset(UniformBufferPool::INVALID_OFFSET),
+		_blockSize(0),
+		_isBlockDirty(false)
 	{
 		_PopulateUniforms();
 	}
@@ -20,9 +43,34 @@ namespace Gameplay {
 	Material::Material() :
 		IResource(),
 		_shader(nullptr),
-		_uniforms(std::unordered_map<std::string, UniformData>())
+		_uniforms(std::unordered_map<std::string, UniformData>()),
+		_sortId(__nextSortId++),
+		_records(),
+		_dirtyRecords(),
+		_textures(),
+		_textureHandles(),
+		_isCompiled(false),
+		_arrayTextures(),
+		_textureLayers(0.0f),
+		_layersGeneration(0),
+		_hasPendingLayers(false),
+		_batchId(0),
+		_isBatchIdDirty(true),
+		_batchKey(),
+		_blockUniforms(),
+		_blockOffset(UniformBufferPool::INVALID_OFFSET),
+		_blockSize(0),
+		_isBlockDirty(false)
 	{ }
 
+	Material::~Material() {
+		_ReleaseBatchId();
+		// Give our block back to the pool so other materials can use it
+		if (_blockOffset != UniformBufferPool::INVALID_OFFSET && __blockPool != nullptr) {
+			__blockPool->Free(_blockOffset, _blockSize);
+		}
+	}
+
 	void Material::Set(const std::string& name, ShaderDataType type, const void* value, size_t arraySize)
 	{
 		// Try and find the matching uniform
@@ -33,6 +81,7 @@ namespace Gameplay {
 			// If it's a texture, we update TextureAsset so it adds to the ref count
 			if (GetShaderDataTypeCode(uniform.Type) == ShaderDataTypecode::Texture && type == ShaderDataType::None) {
 				uniform.TextureAsset = *reinterpret_cast<const ITexture::Sptr*>(value);
+				_isBatchIdDirty = true;
 			}
 			// Check for type mismatch
 			else if (uniform.Type != type && uniform.Type != ShaderDataType::None) {
@@ -48,6 +97,7 @@ namespace Gameplay {
 				else {
 					memcpy(uniform.Value, value, ShaderDataTypeSize(type));
 				}
+				_MarkDirty(uniform);
 			}
 		}
 		// We couldn't find that uniform, log a warning
@@ -60,41 +110,366 @@ namespace Gameplay {
 		return _shader;
 	}
 
+	uint32_t Material::GetBatchId() {
+		_ResolveTextureLayers();
+		if (_isBatchIdDirty) {
+			if (_arrayTextures.empty()) {
+				_ReleaseBatchId();
+				_batchId = _sortId;
+			} else {
+				_batchId = _FindBatchId();
+			}
+			_isBatchIdDirty = false;
+		}
+		return _batchId;
+	}
+
+	const glm::vec4& Material::GetTextureLayers() {
+		_ResolveTextureLayers();
+		return _textureLayers;
+	}
+
 	void Material::Apply() {
 		if (_shader != nullptr) {
-			// Skip the reserved # of texture slots
-			int textureSlot = 0;
-			
-			// Iterate over the uniforms map
-			for (auto&[name, data] : _uniforms) {
-				// The typecode is basically the underlying type of the uniform
-				// ex: float, matrix, texture, etc...
-				ShaderDataTypecode typeCode = GetShaderDataTypeCode(data.Type);
-
-				// If the uniform is a texture, we try and bind it, then move to the next slot
-				if (typeCode == ShaderDataTypecode::Texture) {
-					if (textureSlot >= MAX_TEXTURE_SLOTS) {
-						LOG_WARN("Ignoring material binding, exceeds allowed number of textures");
+			if (!_isCompiled) {
+				_CompileUniforms();
+			}
+
+			// Uniforms are stored in the program, so if we were the last material to use it we only
+			// need to send what has changed since then
+			uint32_t ownerId = _sortId + 1;
+			if (_shader->GetUniformOwner() != ownerId) {
+				for (UniformRecord& record : _records) {
+					_UploadRecord(record);
+				}
+				_shader->SetUniformOwner(ownerId);
+			} else {
+				for (uint32_t ix : _dirtyRecords) {
+					_UploadRecord(_records[ix]);
+				}
+			}
+			for (uint32_t ix : _dirtyRecords) {
+				_records[ix].Dirty = false;
+			}
+			_dirtyRecords.clear();
+
+			// Block values live in our range of the shared buffer, so we only need to bind it
+			if (_blockOffset != UniformBufferPool::INVALID_OFFSET) {
+				if (_isBlockDirty) {
+					_WriteBlock();
+					_isBlockDirty = false;
+				}
+				__blockPool->BindRange(MATERIAL_UBO_BINDING, _blockOffset, _blockSize);
+			}
+
+			// Texture units are shared between programs, so these need to be bound every time
+			if (!_textures.empty()) {
+				for (size_t ix = 0; ix < _textures.size(); ix++) {
+					const ITexture::Sptr& texture = _textures[ix]->TextureAsset;
+					_textureHandles[ix] = texture != nullptr ? texture->GetHandle() : 0;
+				}
+
+				// Array textures bind the whole array, the shader gets the layer from the instance attributes
+				_ResolveTextureLayers();
+				for (const ArrayTexture& arrayTexture : _arrayTextures) {
+					_textureHandles[arrayTexture.TextureSlot] = arrayTexture.Layer.Handle;
+				}
+				glBindTextures(0, static_cast<GLsizei>(_textureHandles.size()), _textureHandles.data());
+			}
+		}
+	}
+
+	void Material::_CompileUniforms() {
+		_records.clear();
+		_dirtyRecords.clear();
+		_textures.clear();
+		_blockUniforms.clear();
+
+		for (auto& [name, data] : _uniforms) {
+			data.RecordIndex = -1;
+			if (data.Location < 0) {
+				continue;
+			}
+			if (data.InBlock) {
+				_blockUniforms.push_back(&data);
+				continue;
+			}
+			UniformRecord record;
+			record.Location    = data.Location;
+			record.Type        = data.Type;
+			record.TextureSlot = -1;
+			record.Dirty       = false;
+			record.Data        = &data;
+			_records.push_back(record);
+		}
+
+		// Uploading in location order means we touch the program's uniform storage in order
+		std::sort(_records.begin(), _records.end(), [](const UniformRecord& a, const UniformRecord& b) {
+			return a.Location < b.Location;
+		});
+
+		for (size_t ix = 0; ix < _records.size(); ) {
+			UniformRecord& record = _records[ix];
+			// The typecode is basically the underlying type of the uniform
+			// ex: float, matrix, texture, etc...
+			if (GetShaderDataTypeCode(record.Type) == ShaderDataTypecode::Texture) {
+				if (_textures.size() >= MAX_TEXTURE_SLOTS) {
+					LOG_WARN("Ignoring material binding \"{}\", exceeds allowed number of textures", record.Data->Name);
+					_records.erase(_records.begin() + ix);
+					continue;
+				}
+				record.TextureSlot = static_cast<int>(_textures.size());
+				_textures.push_back(record.Data);
+			}
+			record.Data->RecordIndex = static_cast<int>(ix);
+			ix++;
+		}
+		_textureHandles.resize(_textures.size());
+
+		// Texture2Ds given to sampler2DArray parameters are looked up in the texture array pool
+		_arrayTextures.clear();
+		for (size_t ix = 0; ix < _textures.size(); ix++) {
+			if (_textures[ix]->Type == ShaderDataType::Tex2D_Array) {
+				if (_arrayTextures.size() == MAX_ARRAY_TEXTURES) {
+					LOG_WARN("Material \"{}\" has more than {} array textures, \"{}\" will always use layer 0", Name, MAX_ARRAY_TEXTURES, _textures[ix]->Name);
+				}
+				ArrayTexture arrayTexture;
+				arrayTexture.TextureSlot = static_cast<uint32_t>(ix);
+				arrayTexture.Layer.Handle = 0;
+				arrayTexture.Layer.ArrayId = TextureArrayPool::INVALID_ARRAY_ID;
+				arrayTexture.Layer.Layer = 0;
+				_arrayTextures.push_back(arrayTexture);
+			}
+		}
+		_textureLayers = glm::vec4(0.0f);
+		_isBatchIdDirty = true;
+
+		// Grab a range of the block pool if our shader has a material block
+		const ShaderProgram::UniformBlockInfo* block = _shader->FindUniformBlock(MATERIAL_BLOCK_NAME);
+		if (block != nullptr && !_blockUniforms.empty()) {
+			if (_blockOffset != UniformBufferPool::INVALID_OFFSET && _blockSize != block->SizeInBytes) {
+				__blockPool->Free(_blockOffset, _blockSize);
+				_blockOffset = UniformBufferPool::INVALID_OFFSET;
+			}
+			if (_blockOffset == UniformBufferPool::INVALID_OFFSET) {
+				if (__blockPool == nullptr) {
+					__blockPool = UniformBufferPool::Create();
+				}
+				_blockSize   = block->SizeInBytes;
+				_blockOffset = __blockPool->Allocate(_blockSize);
+			}
+			// Make sure the shader reads the block from the slot we bind it to
+			if (block->CurrentBinding != MATERIAL_UBO_BINDING) {
+				_shader->BindUniformBlockToSlot(MATERIAL_BLOCK_NAME, MATERIAL_UBO_BINDING);
+			}
+			_isBlockDirty = true;
+		}
+
+		// The records have changed, so everything needs to be uploaded next time we're applied
+		if (_shader != nullptr && _shader->GetUniformOwner() == _sortId + 1) {
+			_shader->SetUniformOwner(0);
+		}
+		_isCompiled = true;
+	}
+
+	void Material::_UploadRecord(UniformRecord& record) {
+		// Samplers are sent the texture unit, rather than the texture itself
+		if (record.TextureSlot >= 0) {
+			_shader->SetUniform(record.Location, record.Type, &record.TextureSlot);
+		}
+		// The uniform is a plain ol' value type, send it in
+		else {
+			UniformData& data = *record.Data;
+			_shader->SetUniform(record.Location, record.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, static_cast<int>(data.ArraySize));
+		}
+	}
+
+	void Material::_WriteBlock() {
+		uint8_t* block = __blockPool->GetData(_blockOffset);
+		memset(block, 0, _blockSize);
+
+		// Our values are tightly packed, so they need to be spread out to match the std140 layout
+		for (UniformData* data : _blockUniforms) {
+			ShaderDataTypecode typeCode = GetShaderDataTypeCode(data->Type);
+			uint32_t elementSize = ShaderDataTypeSize(data->Type);
+			const uint8_t* source = data->ArraySize > 1 ? (const uint8_t*)data->ArrayBlock : data->Value;
+
+			for (size_t ix = 0; ix < data->ArraySize; ix++) {
+				const uint8_t* element = source + elementSize * ix;
+				uint8_t* dest = block + data->Location + data->ArrayStride * ix;
+
+				// Matrices are stored a column at a time
+				if (typeCode == ShaderDataTypecode::Matrix || typeCode == ShaderDataTypecode::MatrixD) {
+					uint32_t columns = ((uint32_t)data->Type & ShaderDataType_Size2Mask) >> 3;
+					uint32_t columnSize = elementSize / columns;
+					for (uint32_t column = 0; column < columns; column++) {
+						memcpy(dest + data->MatrixStride * column, element + columnSize * column, columnSize);
 					}
-					else {
-						ITexture::Sptr texture = data.TextureAsset;
-						if (texture != nullptr) {
-							texture->Bind(textureSlot);
-						}
-						else {
-							ITexture::Unbind(textureSlot);
-						}
-						// Send the slot to the shader
-						_shader->SetUniform(data.Location, data.Type, &textureSlot);
-						textureSlot++;
+				}
+				// Bools are 4 bytes in GLSL, but only 1 in C++
+				else if (typeCode == ShaderDataTypecode::Bool) {
+					for (uint32_t component = 0; component < elementSize; component++) {
+						uint32_t value = element[component] ? 1 : 0;
+						memcpy(dest + component * sizeof(uint32_t), &value, sizeof(uint32_t));
 					}
 				}
-				// The uniform is a plain ol' value type, send it in
 				else {
-					_shader->SetUniform(data.Location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
+					memcpy(dest, element, elementSize);
 				}
 			}
 		}
+
+		__blockPool->Update(_blockOffset, _blockSize);
+	}
+
+	void Material::_ResolveTextureLayers() {
+		if (!_isCompiled) {
+			_CompileUniforms();
+		}
+
+		// Layers only move when the pool changes, or when one of our textures finishes loading
+		bool changed = _isBatchIdDirty || _hasPendingLayers || _layersGeneration != TextureArrayPool::GetGeneration();
+		if (_arrayTextures.empty() || !changed) {
+			return;
+		}
+
+		_hasPendingLayers = false;
+		for (size_t ix = 0; ix < _arrayTextures.size(); ix++) {
+			ArrayTexture& arrayTexture = _arrayTextures[ix];
+			Texture2D* texture = dynamic_cast<Texture2D*>(_textures[arrayTexture.TextureSlot]->TextureAsset.get());
+
+			// Textures that aren't in the pool yet show up as white
+			TextureArrayLayer layer;
+			if (!TextureArrayPool::TryGetLayer(texture, layer)) {
+				layer.Handle = TextureArrayPool::GetFallbackHandle();
+				layer.ArrayId = TextureArrayPool::INVALID_ARRAY_ID;
+				layer.Layer = 0;
+				_hasPendingLayers |= texture != nullptr && texture->IsLoading();
+			}
+
+			// Moving to a different array changes our state, but moving within one does not
+			if (layer.ArrayId != arrayTexture.Layer.ArrayId) {
+				_isBatchIdDirty = true;
+			}
+			arrayTexture.Layer = layer;
+			if (ix < MAX_ARRAY_TEXTURES) {
+				_textureLayers[static_cast<glm::length_t>(ix)] = static_cast<float>(layer.Layer);
+			}
+		}
+		_layersGeneration = TextureArrayPool::GetGeneration();
+	}
+
+	uint32_t Material::_FindBatchId() {
+		// The key is made from everything that Apply would send to the pipeline, with the arrays standing in for our array textures
+		std::string key;
+		auto append = [&key](const void* data, size_t size) {
+			key.append(reinterpret_cast<const char*>(data), size);
+		};
+
+		GLuint program = _shader->GetHandle();
+		append(&program, sizeof(GLuint));
+		for (const UniformRecord& record : _records) {
+			append(&record.Location, sizeof(int));
+			if (record.TextureSlot >= 0) {
+				auto arrayTexture = std::find_if(_arrayTextures.begin(), _arrayTextures.end(), [&](const ArrayTexture& item) {
+					return item.TextureSlot == static_cast<uint32_t>(record.TextureSlot);
+				});
+				if (arrayTexture != _arrayTextures.end()) {
+					append(&arrayTexture->Layer.ArrayId, sizeof(uint32_t));
+				} else {
+					const ITexture* texture = record.Data->TextureAsset.get();
+					append(&texture, sizeof(texture));
+				}
+			} else {
+				const UniformData& data = *record.Data;
+				append(data.ArraySize > 1 ? data.ArrayBlock : data.Value, ShaderDataTypeSize(data.Type) * std::max<size_t>(data.ArraySize, 1));
+			}
+		}
+		for (const UniformData* data : _blockUniforms) {
+			append(&data->Location, sizeof(int));
+			append(data->ArraySize > 1 ? data->ArrayBlock : data->Value, ShaderDataTypeSize(data->Type) * std::max<size_t>(data->ArraySize, 1));
+		}
+
+		if (key == _batchKey) {
+			return __batchIds[_batchKey].Id;
+		}
+
+		// Release our old batch first, so a material whose values change every frame can keep re-using the same ID
+		_ReleaseBatchId();
+
+		// Batch IDs come from the same counter as sort IDs, so they can never be confused with another material's sort ID
+		auto it = __batchIds.find(key);
+		if (it == __batchIds.end()) {
+			BatchEntry entry;
+			entry.RefCount = 0;
+			if (!__freeBatchIds.empty()) {
+				entry.Id = __freeBatchIds.back();
+				__freeBatchIds.pop_back();
+			} else {
+				entry.Id = __nextSortId++;
+			}
+			it = __batchIds.emplace(key, entry).first;
+		}
+		it->second.RefCount++;
+		_batchKey = key;
+		return it->second.Id;
+	}
+
+	void Material::_ReleaseBatchId() {
+		if (_batchKey.empty()) {
+			return;
+		}
+		auto it = __batchIds.find(_batchKey);
+		if (it != __batchIds.end() && --it->second.RefCount == 0) {
+			__freeBatchIds.push_back(it->second.Id);
+			__batchIds.erase(it);
+		}
+		_batchKey.clear();
+	}
+
+	bool Material::_FindBlockUniform(const ShaderProgram::Sptr& shader, const std::string& name, ShaderProgram::UniformInfo* out) {
+		const ShaderProgram::UniformBlockInfo* block = shader != nullptr ? shader->FindUniformBlock(MATERIAL_BLOCK_NAME) : nullptr;
+		if (block == nullptr) {
+			return false;
+		}
+		for (const ShaderProgram::UniformInfo& member : block->SubUniforms) {
+			if (_GetBlockParameterName(member.Name) == name) {
+				if (out != nullptr) {
+					*out = member;
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::string Material::_GetBlockParameterName(const std::string& memberName) {
+		// Members of named blocks are reported as BlockName.Member
+		std::string prefix = std::string(MATERIAL_BLOCK_NAME) + ".";
+		if (memberName.compare(0, prefix.size(), prefix) == 0) {
+			return "u_Material." + memberName.substr(prefix.size());
+		}
+		return memberName;
+	}
+
+	void Material::_MarkDirty(UniformData& uniform) {
+		// Any change could mean we no longer match the other materials in our batch
+		_isBatchIdDirty = true;
+
+		// Block values are uploaded all at once
+		if (uniform.InBlock) {
+			_isBlockDirty = true;
+			return;
+		}
+		// Before the first Apply everything will be uploaded anyways
+		if (!_isCompiled || uniform.RecordIndex < 0) {
+			return;
+		}
+		UniformRecord& record = _records[uniform.RecordIndex];
+		if (!record.Dirty) {
+			record.Dirty = true;
+			_dirtyRecords.push_back(static_cast<uint32_t>(uniform.RecordIndex));
+		}
 	}
 
 	void Material::RenderImGui() {
@@ -109,7 +484,9 @@ namespace Gameplay {
 			// Draw all of our valid uniforms
 			for (auto&[key, value] : _uniforms) {
 				if (value.Location != -2 && value.Location != -1) {
-					value.RenderImGui();
+					if (value.RenderImGui()) {
+						_MarkDirty(value);
+					}
 				}
 			}
 
@@ -170,6 +547,8 @@ namespace Gameplay {
 	{
 		UniformData& data = _uniforms[name];
 		if (data.Location == -2) {
+			// A new uniform, so the records need to be rebuilt
+			_isCompiled = false;
 			ShaderProgram::UniformInfo uniform;
 			if (_shader->FindUniform(name, &uniform)) {
 				// Ignoring our reserved textures
@@ -179,6 +558,8 @@ namespace Gameplay {
 				else {
 					data = UniformData(name, _shader);
 				}
+			} else if (_FindBlockUniform(_shader, name, nullptr)) {
+				data = UniformData(name, _shader);
 			} else {
 				data.Location = -1;
 			}
@@ -192,6 +573,15 @@ namespace Gameplay {
 		for (const auto& [key, value] : uniforms) {
 			_uniforms[key] = _GetUniform(key);
 		}
+
+		// Uniforms in the material block aren't in the shader's uniform list
+		const ShaderProgram::UniformBlockInfo* block = _shader->FindUniformBlock(MATERIAL_BLOCK_NAME);
+		if (block != nullptr) {
+			for (const ShaderProgram::UniformInfo& member : block->SubUniforms) {
+				std::string name = _GetBlockParameterName(member.Name);
+				_uniforms[name] = _GetUniform(name);
+			}
+		}
 	}
 
 	bool Material::UniformData::RenderImGui() {
@@ -298,12 +688,14 @@ namespace Gameplay {
 					case ShaderDataType::Tex2D_Multisample:
 					case ShaderDataType::Tex2D_Int:
 					case ShaderDataType::Tex2D_Uint: 
+					case ShaderDataType::Tex2D_Array:
 					{
 						Texture2D::Sptr tex = std::dynamic_pointer_cast<Texture2D>(TextureAsset);
 						if (tex != nullptr) {
 							ImGui::Image((ImTextureID)tex->GetHandle(), ImVec2(ImGui::GetTextLineHeight() * 2, ImGui::GetTextLineHeight() * 2));
 							if (ImGuiHelper::ResourceDragTarget<Texture2D>(tex)) {
 								TextureAsset = tex;
+								modified = true;
 							}
 						}
 					}
@@ -410,6 +802,22 @@ namespace Gameplay {
 			ArraySize = uniform.ArraySize;
 			BindingSlot = uniform.Binding;
 			
+			// Allocate memory for array if the uniform is an array
+			if (ArraySize > 1) {
+				ArrayBlock = malloc(ShaderDataTypeSize(Type) * ArraySize);
+			}
+		}
+		// Parameters in the material block are stored the same way, Location is the offset into the block
+		else if (Material::_FindBlockUniform(shader, uniformName, &uniform)) {
+			Name = uniformName;
+			Location = uniform.Location;
+			Type = uniform.Type;
+			ArraySize = uniform.ArraySize;
+			BindingSlot = -1;
+			InBlock = true;
+			ArrayStride = uniform.ArrayStride;
+			MatrixStride = uniform.MatrixStride;
+			
 			// Allocate memory for array if the uniform is an array
 			if (ArraySize > 1) {
 				ArrayBlock = malloc(ShaderDataTypeSize(Type) * ArraySize);
@@ -424,6 +832,9 @@ namespace Gameplay {
 		Location = other.Location;
 		ArraySize = other.ArraySize;
 		Type = other.Type;
+		InBlock = other.InBlock;
+		ArrayStride = other.ArrayStride;
+		MatrixStride = other.MatrixStride;
 
 		if (GetShaderDataTypeCode(Type) == ShaderDataTypecode::Texture) {
 			TextureAsset = other.TextureAsset;
@@ -444,6 +855,9 @@ namespace Gameplay {
 		Location  = other.Location;
 		ArraySize = other.ArraySize;
 		Type      = other.Type;
+		InBlock   = other.InBlock;
+		ArrayStride  = other.ArrayStride;
+		MatrixStride = other.MatrixStride;
 
 		if (GetShaderDataTypeCode(Type) == ShaderDataTypecode::Texture) {
 			TextureAsset = other.TextureAsset;
@@ -769,6 +1183,8 @@ namespace Gameplay {
 			case ShaderDataType::Tex2D_Uint:
 			case ShaderDataType::Tex2D_Uint_Multisample:
 			case ShaderDataType::Tex2D_Int_Multisample:
+			// Array parameters take a Texture2D, which is placed in an array by the TextureArrayPool
+			case ShaderDataType::Tex2D_Array:
 				result.TextureAsset = ResourceManager::Get<Texture2D>(Guid(blob["value"].get<std::string>()));
 				break;
 			case ShaderDataType::TexCube:
@@ -791,7 +1207,6 @@ namespace Gameplay {
 			case ShaderDataType::Tex1D_ShadowArray:
 			case ShaderDataType::Tex2D_Rect:
 			case ShaderDataType::Tex2D_Rect_Shadow:
-			case ShaderDataType::Tex2D_Array:
 			case ShaderDataType::Tex2D_Shadow:
 			case ShaderDataType::Tex2D_ShadowArray:
 			case ShaderDataType::Tex2D_MultisampleArray:
@@ -2,6 +2,8 @@
 #include <memory>
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/Textures/ITexture.h"
+#include "Graphics/Buffers/UniformBufferPool.h"
+#include "Graphics/Textures/TextureArrayPool.h"
 
 namespace Gameplay {
 	/// <summary>
@@ -19,6 +21,23 @@ namespace Gameplay {
 		/// </summary>
 		static const int MAX_TEXTURE_SLOTS = 14;
 
+		/// <summary>
+		/// If a material's shader declares a std140 uniform block with this name, the material's values
+		/// for the block are stored in a shared uniform buffer, and bound with a single call when the
+		/// material is applied. Members of the block are exposed as u_Material.[member] parameters, so
+		/// they have the same names as they would in the u_Material struct
+		/// </summary>
+		inline static const char* MATERIAL_BLOCK_NAME = "b_Material";
+		/// <summary>
+		/// The uniform buffer binding slot that material blocks are bound to
+		/// </summary>
+		static const int MATERIAL_UBO_BINDING = 3;
+		/// <summary>
+		/// The number of sampler2DArray parameters that can have their layers passed to the shader,
+		/// see GetTextureLayers
+		/// </summary>
+		static const int MAX_ARRAY_TEXTURES = 4;
+
 		/// <summary>
 		/// A human readable name for the material
 		/// </summary>
@@ -33,6 +52,7 @@ namespace Gameplay {
 		/// </summary>
 		/// <param name="shader">The shader for the material</param>
 		Material(const ShaderProgram::Sptr& shader);
+		virtual ~Material();
 
 		/// <summary>
 		/// Sets a material parameter with the given name and type
@@ -60,9 +80,32 @@ namespace Gameplay {
 		/// </summary>
 		const ShaderProgram::Sptr& GetShader() const;
 
+		/// <summary>
+		/// Gets a small unique identifier for this material, used by the renderer to
+		/// group draw calls that share the same material state
+		/// </summary>
+		uint32_t GetSortId() const { return _sortId; }
+		/// <summary>
+		/// Gets an identifier that is shared by all materials which would put the pipeline in the same
+		/// state when applied. Texture2Ds given to sampler2DArray parameters are bound through the
+		/// TextureArrayPool, so materials that only differ by which layer of an array their textures
+		/// are in share an ID, and objects using any of them can be drawn in the same batch.
+		/// Materials without any sampler2DArray parameters just use their sort ID
+		/// </summary>
+		uint32_t GetBatchId();
+		/// <summary>
+		/// Gets the layers of the textures given to our sampler2DArray parameters, in texture unit order.
+		/// The renderer sends these to instanced shaders as a per-instance attribute, see
+		/// fragments/vs_common_instanced.glsl
+		/// </summary>
+		const glm::vec4& GetTextureLayers();
+
 		/// <summary>
 		/// Handles applying this material's state to the OpenGL pipeline
-		/// Will bind the shader, update material uniforms, and bind textures
+		/// Will update material uniforms, and bind textures
+		/// 
+		/// If this material was the last one applied with its shader, only the uniforms that have
+		/// been changed since then are uploaded
 		/// </summary>
 		virtual void Apply();
 
@@ -108,6 +151,13 @@ namespace Gameplay {
 			// The size of the array, in elements
 			size_t         ArraySize;
 			int            BindingSlot;
+			// Index of this uniform in the material's compiled records, or -1 if it is not in them
+			int            RecordIndex = -1;
+			// True if the uniform is in the material block, in which case Location is its offset in the block
+			bool           InBlock = false;
+			// For uniforms in the material block, the bytes between array elements and matrix columns
+			int            ArrayStride = 0;
+			int            MatrixStride = 0;
 
 			// The type of uniform
 			ShaderDataType Type = ShaderDataType::None;
@@ -174,8 +224,105 @@ namespace Gameplay {
 		/// The uniforms that the material will be modifying
 		/// </summary>
 		std::unordered_map<std::string, UniformData> _uniforms;
+		/// <summary>
+		/// Unique ID assigned on creation, see GetSortId
+		/// </summary>
+		uint32_t _sortId;
+
+		/// <summary>
+		/// A uniform that will be uploaded when the material is applied
+		/// </summary>
+		struct UniformRecord {
+			int            Location;
+			ShaderDataType Type;
+			// For textures, the texture unit that the texture is bound to, otherwise -1
+			int            TextureSlot;
+			// True if the value has been changed since the material was last applied
+			bool           Dirty;
+			UniformData*   Data;
+		};
+		/// <summary>
+		/// The uniforms from _uniforms that exist in the shader, sorted by location. This is
+		/// rebuilt whenever uniforms are added to the map
+		/// </summary>
+		std::vector<UniformRecord> _records;
+		// Indices of the records that have been changed since the last Apply
+		std::vector<uint32_t>      _dirtyRecords;
+		// The texture uniforms, indexed by the texture unit they are bound to
+		std::vector<UniformData*>  _textures;
+		// Storage for the texture handles passed to glBindTextures
+		std::vector<GLuint>        _textureHandles;
+		bool                       _isCompiled;
+
+		/// <summary>
+		/// A sampler2DArray parameter, and where it's texture is in the TextureArrayPool
+		/// </summary>
+		struct ArrayTexture {
+			// The texture unit of the parameter, which is also it's index in _textures
+			uint32_t          TextureSlot;
+			TextureArrayLayer Layer;
+		};
+		std::vector<ArrayTexture>  _arrayTextures;
+		glm::vec4                  _textureLayers;
+		// The pool generation that the layers were last looked up in
+		uint32_t                   _layersGeneration;
+		// True if one of our array textures was still loading the last time the layers were looked up
+		bool                       _hasPendingLayers;
+		uint32_t                   _batchId;
+		bool                       _isBatchIdDirty;
+		// The key of the batch we hold a reference to in __batchIds, empty if we don't hold one
+		std::string                _batchKey;
+
+		// The uniforms that are stored in our range of the block pool
+		std::vector<UniformData*>  _blockUniforms;
+		// Our range of the block pool, the offset is INVALID_OFFSET if we don't have one
+		uint32_t                   _blockOffset;
+		uint32_t                   _blockSize;
+		// True if the block's values have changed since they were last uploaded
+		bool                       _isBlockDirty;
 
 		UniformData& _GetUniform(const std::string& name);
 		void _PopulateUniforms();
+		void _CompileUniforms();
+		void _UploadRecord(UniformRecord& record);
+		void _MarkDirty(UniformData& uniform);
+		void _WriteBlock();
+		/// <summary>
+		/// Looks up where our array textures are in the TextureArrayPool, if anything may have moved
+		/// </summary>
+		void _ResolveTextureLayers();
+		/// <summary>
+		/// Gets the batch ID for our current state, assigning a new one if no other material has it
+		/// </summary>
+		uint32_t _FindBatchId();
+		/// <summary>
+		/// Drops our reference to our current batch, freeing it's ID if no other material is using it
+		/// </summary>
+		void _ReleaseBatchId();
+
+		/// <summary>
+		/// Finds a member of the shader's material block from its parameter name (ex: u_Material.Shininess)
+		/// </summary>
+		static bool _FindBlockUniform(const ShaderProgram::Sptr& shader, const std::string& name, ShaderProgram::UniformInfo* out);
+		/// <summary>
+		/// Gets the parameter name for a member of the material block (ex: b_Material.Shininess -> u_Material.Shininess)
+		/// </summary>
+		static std::string _GetBlockParameterName(const std::string& memberName);
+
+		// A batch ID, and the number of materials whose state maps to it
+		struct BatchEntry {
+			uint32_t Id;
+			uint32_t RefCount;
+		};
+		// Maps the state of materials with array textures to their batch IDs
+		static std::unordered_map<std::string, BatchEntry> __batchIds;
+		// Batch IDs that are no longer used by any material, these are handed out before taking new sort IDs
+		static std::vector<uint32_t> __freeBatchIds;
+
+		// The buffer that all material blocks are allocated from, created the first time it's needed
+		static UniformBufferPool::Sptr __blockPool;
+
+		// Counter used to assign sort IDs to new materials
+		static uint32_t __nextSortId;
 	};
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <filesystem>
 
 #include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
 
 namespace Gameplay {
 	MeshResource::MeshResource() :
@@ -20,6 +21,7 @@ namespace Gameplay {
 		BulletTriMesh(nullptr)
 	{
 		Mesh = ObjLoader::LoadFromFile(filename);
+		UpdateBounds();
 	}
 
 	MeshResource::~MeshResource() = default;
@@ -41,28 +43,54 @@ namespace Gameplay {
 
 	MeshResource::Sptr MeshResource::FromJson(const nlohmann::json & blob)
 	{
-		MeshResource::Sptr result = std::make_shared<MeshResource>();
+		return FromJson(blob, PrepareFromJson(blob));
+	}
+
+	std::shared_ptr<MeshResource::PreparedData> MeshResource::PrepareFromJson(const nlohmann::json& blob) {
+		std::shared_ptr<PreparedData> result = std::make_shared<PreparedData>();
 		if (blob.contains("params") && blob["params"].is_array()) {
 			std::vector<nlohmann::json> meshbuilderParams = blob["params"].get<std::vector<nlohmann::json>>();
-			MeshBuilder<VertexPosNormTexColTangents> mesh;
 			for (int ix = 0; ix < meshbuilderParams.size(); ix++) {
-				MeshBuilderParam p = MeshBuilderParam::FromJson(meshbuilderParams[ix]);
-				result->MeshBuilderParams.push_back(p);
-				MeshFactory::AddParameterized(mesh, p);
+				MeshFactory::AddParameterized(result->Builder, MeshBuilderParam::FromJson(meshbuilderParams[ix]));
 			}
-			MeshFactory::CalculateTBN(mesh);
-			result->Mesh = mesh.Bake();
+			MeshFactory::CalculateTBN(result->Builder);
+			result->HasBuilder = true;
 		} else {
-			result->Filename = JsonGet<std::string>(blob, "filename", "null");
-			if (result->Filename != "null" && std::filesystem::exists(result->Filename)) {
+			std::string filename = JsonGet<std::string>(blob, "filename", "null");
+			if (filename != "null" && std::filesystem::exists(filename)) {
 				#ifdef OPTIMIZED_OBJ_LOADER
-				result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename);
+				result->BinaryPath = OptimizedObjLoader::PrepareFile(filename);
 				#else
-				result->Mesh = ObjLoader::LoadFromFile(result->Filename);
+				result->Builder = ObjLoader::LoadMeshBuilder(filename);
+				result->HasBuilder = true;
 				#endif
+			}
+		}
+		return result;
+	}
 
+	MeshResource::Sptr MeshResource::FromJson(const nlohmann::json& blob, const std::shared_ptr<PreparedData>& prepared)
+	{
+		MeshResource::Sptr result = std::make_shared<MeshResource>();
+		if (blob.contains("params") && blob["params"].is_array()) {
+			std::vector<nlohmann::json> meshbuilderParams = blob["params"].get<std::vector<nlohmann::json>>();
+			for (int ix = 0; ix < meshbuilderParams.size(); ix++) {
+				result->MeshBuilderParams.push_back(MeshBuilderParam::FromJson(meshbuilderParams[ix]));
 			}
+		} else {
+			result->Filename = JsonGet<std::string>(blob, "filename", "null");
 		}
+
+		// Only the VAO needs to be created here, the vertices were built when the data was prepared
+		if (prepared->HasBuilder) {
+			result->Mesh = prepared->Builder.Bake();
+		}
+		#ifdef OPTIMIZED_OBJ_LOADER
+		else if (!prepared->BinaryPath.empty()) {
+			result->Mesh = OptimizedObjLoader::LoadFromFile(prepared->BinaryPath);
+		}
+		#endif
+		result->UpdateBounds();
 		return result;
 	}
 
@@ -73,9 +101,14 @@ namespace Gameplay {
 		}
 		MeshFactory::CalculateTBN(mesh);
 		Mesh = mesh.Bake();
+		UpdateBounds();
 	}
 
 	void MeshResource::AddParam(const MeshBuilderParam & param) {
 		MeshBuilderParams.push_back(param);
 	}
+
+	void MeshResource::UpdateBounds() {
+		LocalBounds = Mesh != nullptr ? Mesh->GetBounds() : Bounds();
+	}
 }
\ No newline at end of file
@@ -40,7 +40,10 @@ namespace Gameplay {
 		/// The VAO for rendering this mesh in OpenGL
 		/// </summary>
 		VertexArrayObject::Sptr         Mesh;
-
+		/// <summary>
+		/// The local space bounding box and sphere of the mesh, calculated when the mesh is built
+		/// </summary>
+		Bounds                          LocalBounds;
 
 		/// <summary>
 		/// The optional mesh resource for generating colliders from this mesh
@@ -60,10 +63,35 @@ namespace Gameplay {
 		/// </summary>
 		/// <param name="param">The parameter to add</param>
 		void AddParam(const MeshBuilderParam& param);
+		/// <summary>
+		/// Updates LocalBounds to match the bounds of the Mesh, should be called if the Mesh is replaced
+		/// </summary>
+		void UpdateBounds();
 
 		// Inherited from IResource
 
 		virtual nlohmann::json ToJson() const override;
 		static MeshResource::Sptr FromJson(const nlohmann::json& blob);
+
+		/// <summary>
+		/// The CPU side of a mesh, built by PrepareFromJson
+		/// </summary>
+		struct PreparedData {
+			// The vertices and indices to bake, if the mesh was generated or parsed from an OBJ
+			MeshBuilder<VertexPosNormTexColTangents> Builder;
+			bool                                     HasBuilder = false;
+			// The file to load with the optimized loader, which has already been converted to binary
+			std::string                              BinaryPath;
+		};
+		/// <summary>
+		/// Generates or parses the mesh in a JSON blob without creating any GL objects, so this is used
+		/// by the ResourceManager to load meshes on worker threads
+		/// </summary>
+		static std::shared_ptr<PreparedData> PrepareFromJson(const nlohmann::json& blob);
+		/// <summary>
+		/// Creates a mesh resource from a JSON blob and the data built by PrepareFromJson, must be
+		/// called from the main thread
+		/// </summary>
+		static MeshResource::Sptr FromJson(const nlohmann::json& blob, const std::shared_ptr<PreparedData>& prepared);
 	};
 }
\ No newline at end of file
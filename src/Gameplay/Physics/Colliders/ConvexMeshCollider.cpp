@@ -111,6 +111,18 @@ namespace Gameplay::Physics {
 					}
 				};
 
+				// Helper for extracting a position from the raw vertex data, packed meshes store their
+				// positions as normalized shorts that need to be mapped back into local space
+				const glm::mat4& positionTransform = vao->GetPositionTransform();
+				auto getPosition = [&](uint8_t* dataStore, size_t index) {
+					uint8_t* element = dataStore + (posAttrib.Stride * index) + posAttrib.Offset;
+					if (posAttrib.Type == AttributeType::UShort && posAttrib.Normalized) {
+						uint16_t* quantized = reinterpret_cast<uint16_t*>(element);
+						return glm::vec3(positionTransform * glm::vec4(quantized[0] / 65535.0f, quantized[1] / 65535.0f, quantized[2] / 65535.0f, 1.0f));
+					}
+					return *reinterpret_cast<glm::vec3*>(element);
+				};
+
 				// Allocate some space to read data from OpenGL and read our buffer data back into CPU memory
 				uint8_t* vertexStore = reinterpret_cast<uint8_t*>(malloc(vertexBuff->GetTotalSize()));
 				glGetNamedBufferSubData(vertexBuff->GetHandle(), 0, vertexBuff->GetTotalSize(), vertexStore);
@@ -122,20 +134,34 @@ namespace Gameplay::Physics {
 					uint8_t* indexStore = reinterpret_cast<uint8_t*>(malloc(indexBuff->GetTotalSize()));
 					glGetNamedBufferSubData(indexBuff->GetHandle(), 0, indexBuff->GetTotalSize(), indexStore);
 
+					// Split meshes store their indices relative to each sub-mesh's base vertex. If the mesh has
+					// LODs, we only want the full detail mesh, which matches what Draw uses for LOD 0
+					std::vector<VertexArrayObject::SubMesh> parts = vao->GetSubMeshes();
+					if (!vao->GetLods().empty() && vao->GetLods()[0].SubMeshCount > 0) {
+						const VertexArrayObject::MeshLod& fullLod = vao->GetLods()[0];
+						parts = std::vector<VertexArrayObject::SubMesh>(parts.begin() + fullLod.FirstSubMesh, parts.begin() + fullLod.FirstSubMesh + fullLod.SubMeshCount);
+					}
+					if (parts.empty()) {
+						uint32_t indexCount = vao->GetLods().empty() ? indexBuff->GetElementCount() : vao->GetLods()[0].IndexCount;
+						parts.push_back({ 0, indexCount, 0, vao->GetVertexCount() });
+					}
+
 					// Iterate over index triangles
-					for (size_t ix = 0; ix < indexBuff->GetElementCount(); ix+=3) {
-						// Extract index from the raw data
-						int i1 = getBufferIndex(indexBuff, indexStore, static_cast<int>(ix));
-						int i2 = getBufferIndex(indexBuff, indexStore, static_cast<int>(ix + 1));
-						int i3 = getBufferIndex(indexBuff, indexStore, static_cast<int>(ix + 2));
-
-						// Find the positions for the indices
-						glm::vec3 p1 = *reinterpret_cast<glm::vec3*>(vertexStore + (posAttrib.Stride * i1) + posAttrib.Offset);
-						glm::vec3 p2 = *reinterpret_cast<glm::vec3*>(vertexStore + (posAttrib.Stride * i2) + posAttrib.Offset);
-						glm::vec3 p3 = *reinterpret_cast<glm::vec3*>(vertexStore + (posAttrib.Stride * i3) + posAttrib.Offset);
-
-						// Add the triangle
-						_triMesh->addTriangle(ToBt(p1), ToBt(p2), ToBt(p3));
+					for (const auto& part : parts) {
+						for (size_t ix = part.FirstIndex; ix < part.FirstIndex + part.IndexCount; ix+=3) {
+							// Extract index from the raw data
+							int i1 = part.BaseVertex + getBufferIndex(indexBuff, indexStore, static_cast<int>(ix));
+							int i2 = part.BaseVertex + getBufferIndex(indexBuff, indexStore, static_cast<int>(ix + 1));
+							int i3 = part.BaseVertex + getBufferIndex(indexBuff, indexStore, static_cast<int>(ix + 2));
+
+							// Find the positions for the indices
+							glm::vec3 p1 = getPosition(vertexStore, i1);
+							glm::vec3 p2 = getPosition(vertexStore, i2);
+							glm::vec3 p3 = getPosition(vertexStore, i3);
+
+							// Add the triangle
+							_triMesh->addTriangle(ToBt(p1), ToBt(p2), ToBt(p3));
+						}
 					}
 			
 					// Free the data we copied the indices into
@@ -146,9 +172,9 @@ namespace Gameplay::Physics {
 				else {
 					// Iterate over triangles, and add each to the mesh
 					for (size_t ix = 0; ix < vertexBuff->GetElementCount(); ix+=3) {
-						glm::vec3 p1 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 0) * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p2 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 1) * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p3 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 2) * posAttrib.Stride) + posAttrib.Offset);
+						glm::vec3 p1 = getPosition(vertexStore, ix + 0);
+						glm::vec3 p2 = getPosition(vertexStore, ix + 1);
+						glm::vec3 p3 = getPosition(vertexStore, ix + 2);
 						_triMesh->addTriangle(ToBt(p1), ToBt(p2), ToBt(p3));
 					}
 				}
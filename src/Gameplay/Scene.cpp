@@ -3,8 +3,11 @@
 #include <GLFW/glfw3.h>
 #include <locale>
 #include <codecvt>
+#include <fstream>
+#include <cstring>
 
 #include "Utils/FileHelpers.h"
+#include "Utils/MappedFile.h"
 #include "Utils/GlmBulletConversions.h"
 
 #include "Gameplay/Physics/RigidBody.h"
@@ -21,6 +24,7 @@ namespace Gameplay {
 	Scene::Scene() :
 		_objects(std::vector<GameObject::Sptr>()),
 		_deletionQueue(std::vector<std::weak_ptr<GameObject>>()),
+		_objectsByGuid(),
 		Lights(std::vector<Light>()),
 		IsPlaying(false),
 		MainCamera(nullptr),
@@ -52,6 +56,7 @@ namespace Gameplay {
 		_skyboxMesh = nullptr;
 		_skyboxTexture = nullptr;
 		_objects.clear();
+		_objectsByGuid.clear();
 		Lights.clear();
 		_CleanupPhysics();
 	}
@@ -105,6 +110,7 @@ namespace Gameplay {
 		result->_scene = this;
 		result->_selfRef = result;
 		_objects.push_back(result);
+		_objectsByGuid[result->_guid] = result;
 		return result;
 	}
 
@@ -120,10 +126,8 @@ namespace Gameplay {
 	}
 
 	GameObject::Sptr Scene::FindObjectByGUID(Guid id) const {
-		auto it = std::find_if(_objects.begin(), _objects.end(), [&](const GameObject::Sptr& obj) {
-			return obj->_guid == id;
-		});
-		return it == _objects.end() ? nullptr : *it;
+		auto it = _objectsByGuid.find(id);
+		return it == _objectsByGuid.end() ? nullptr : it->second.lock();
 	}
 
 	void Scene::SetAmbientLight(const glm::vec3& value) {
@@ -162,9 +166,12 @@ namespace Gameplay {
 	}
 
 	void Scene::DoPhysics(float dt) {
-		_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
-			body->PhysicsPreStep(dt);
-		});
+		// Rigid bodies only sync with bullet here, so we can walk their pool directly
+		for (Gameplay::Physics::RigidBody* body : _components.Pool<Gameplay::Physics::RigidBody>()) {
+			if (body->IsEnabled) {
+				body->PhysicsPreStep(dt);
+			}
+		}
 		_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
 			body->PhysicsPreStep(dt);
 		});
@@ -173,9 +180,11 @@ namespace Gameplay {
 
 			_physicsWorld->stepSimulation(dt, 1);
 
-			_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
-				body->PhysicsPostStep(dt);
-			});
+			for (Gameplay::Physics::RigidBody* body : _components.Pool<Gameplay::Physics::RigidBody>()) {
+				if (body->IsEnabled) {
+					body->PhysicsPostStep(dt);
+				}
+			}
 			_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
 				body->PhysicsPostStep(dt);
 			});
@@ -255,19 +264,8 @@ namespace Gameplay {
 		Scene::Sptr result = std::make_shared<Scene>();
 		result->MainCamera = nullptr;
 		result->_objects.clear();
-		result->DefaultMaterial = ResourceManager::Get<Material>(Guid(data["default_material"]));
-
-		if (data.contains("ambient")) {
-			result->SetAmbientLight((data["ambient"]));
-		}
-
-		if (data.contains("skybox") && data["skybox"].is_object()) {
-			nlohmann::json& blob = data["skybox"].get<nlohmann::json>();
-			result->_skyboxMesh = ResourceManager::Get<MeshResource>(Guid(blob["mesh"]));
-			result->SetSkyboxShader(ResourceManager::Get<ShaderProgram>(Guid(blob["shader"])));
-			result->SetSkyboxTexture(ResourceManager::Get<TextureCube>(Guid(blob["texture"])));
-			result->SetSkyboxRotation(glm::mat3_cast((glm::quat)(blob["orientation"])));
-		}
+		result->_objectsByGuid.clear();
+		result->_LoadSettings(data);
 
 		// Make sure the scene has objects, then load them all in!
 		LOG_ASSERT(data["objects"].is_array(), "Objects not present in scene!");
@@ -277,20 +275,11 @@ namespace Gameplay {
 			obj->_parent.SceneContext = result.get();
 			obj->_selfRef = obj;
 			result->_objects.push_back(obj);
+			result->_objectsByGuid[obj->_guid] = obj;
 		}
 
 		// Re-build the parent hierarchy 
-		for (const auto& object : result->_objects) {
-			if (object->GetParent() != nullptr) {
-				object->GetParent()->AddChild(object);
-			}
-		}
-
-		// Make sure the scene has lights, then load all
-		LOG_ASSERT(data["lights"].is_array(), "Lights not present in scene!");
-		for (auto& light : data["lights"]) {
-			result->Lights.push_back(Light::FromJson(light));
-		}
+		result->_RebuildHierarchy();
 
 		// Create and load camera config
 		result->MainCamera = result->_components.GetComponentByGUID<Camera>(Guid(data["main_camera"]));
@@ -300,6 +289,42 @@ namespace Gameplay {
 
 	nlohmann::json Scene::ToJson() const
 	{
+		nlohmann::json blob = _SaveSettings();
+
+		// Save renderables
+		std::vector<nlohmann::json> objects;
+		objects.resize(_objects.size());
+		for (int ix = 0; ix < _objects.size(); ix++) {
+			objects[ix] = _objects[ix]->ToJson();
+		}
+		blob["objects"] = objects;
+
+		return blob;
+	}
+
+	void Scene::_LoadSettings(const nlohmann::json& data) {
+		DefaultMaterial = ResourceManager::Get<Material>(Guid(data["default_material"]));
+
+		if (data.contains("ambient")) {
+			SetAmbientLight((data["ambient"]));
+		}
+
+		if (data.contains("skybox") && data["skybox"].is_object()) {
+			nlohmann::json& blob = data["skybox"].get<nlohmann::json>();
+			_skyboxMesh = ResourceManager::Get<MeshResource>(Guid(blob["mesh"]));
+			SetSkyboxShader(ResourceManager::Get<ShaderProgram>(Guid(blob["shader"])));
+			SetSkyboxTexture(ResourceManager::Get<TextureCube>(Guid(blob["texture"])));
+			SetSkyboxRotation(glm::mat3_cast((glm::quat)(blob["orientation"])));
+		}
+
+		// Make sure the scene has lights, then load all
+		LOG_ASSERT(data["lights"].is_array(), "Lights not present in scene!");
+		for (auto& light : data["lights"]) {
+			Lights.push_back(Light::FromJson(light));
+		}
+	}
+
+	nlohmann::json Scene::_SaveSettings() const {
 		nlohmann::json blob;
 		// Save the default shader (really need a material class)
 		blob["default_material"] = DefaultMaterial ? DefaultMaterial->GetGUID().str() : "null";
@@ -312,14 +337,6 @@ namespace Gameplay {
 		blob["skybox"]["texture"] = _skyboxTexture ? _skyboxTexture->GetGUID().str() : "null";
 		blob["skybox"]["orientation"] = (glm::quat)_skyboxRotation;
 
-		// Save renderables
-		std::vector<nlohmann::json> objects;
-		objects.resize(_objects.size());
-		for (int ix = 0; ix < _objects.size(); ix++) {
-			objects[ix] = _objects[ix]->ToJson();
-		}
-		blob["objects"] = objects;
-
 		// Save lights
 		std::vector<nlohmann::json> lights;
 		lights.resize(Lights.size());
@@ -334,6 +351,14 @@ namespace Gameplay {
 		return blob;
 	}
 
+	void Scene::_RebuildHierarchy() {
+		for (const auto& object : _objects) {
+			if (object->GetParent() != nullptr) {
+				object->GetParent()->AddChild(object);
+			}
+		}
+	}
+
 	void Scene::Save(const std::string& path) {
 		_filePath = path;
 		// Save data to file
@@ -351,6 +376,245 @@ namespace Gameplay {
 		return result;
 	}
 
+	// Tables in binary scene files start on 16 byte boundaries, so they can be read in place
+	static uint32_t AlignBinaryOffset(size_t offset) {
+		return static_cast<uint32_t>((offset + 15) & ~static_cast<size_t>(15));
+	}
+
+	void Scene::SaveBinary(const std::string& path) {
+		std::vector<BinarySceneObject>    objects;
+		std::vector<BinarySceneTransform> transforms;
+		std::vector<BinarySceneType>      types;
+		std::vector<BinarySceneComponent> components;
+		std::string                       strings;
+		std::vector<uint8_t>              blobs;
+		objects.reserve(_objects.size());
+		transforms.reserve(_objects.size());
+
+		// Maps component type names to their index in the type table
+		std::unordered_map<std::string, uint32_t> typeIndices;
+
+		for (const auto& object : _objects) {
+			BinarySceneObject entry = BinarySceneObject();
+			memcpy(entry.Guid, object->_guid.bytes(), 16);
+			memcpy(entry.ParentGuid, object->_parent.ResourceGUID.bytes(), 16);
+			entry.NameOffset      = static_cast<uint32_t>(strings.size());
+			entry.NameLength      = static_cast<uint32_t>(object->Name.size());
+			entry.FirstComponent  = static_cast<uint32_t>(components.size());
+			entry.NumComponents   = static_cast<uint32_t>(object->_components.size());
+			entry.HideInHierarchy = object->HideInHierarchy ? 1 : 0;
+			strings += object->Name;
+			objects.push_back(entry);
+
+			BinarySceneTransform transform;
+			transform.Position[0] = object->_position.x;
+			transform.Position[1] = object->_position.y;
+			transform.Position[2] = object->_position.z;
+			transform.Rotation[0] = object->_rotation.x;
+			transform.Rotation[1] = object->_rotation.y;
+			transform.Rotation[2] = object->_rotation.z;
+			transform.Rotation[3] = object->_rotation.w;
+			transform.Scale[0]    = object->_scale.x;
+			transform.Scale[1]    = object->_scale.y;
+			transform.Scale[2]    = object->_scale.z;
+			transforms.push_back(transform);
+
+			for (const auto& component : object->_components) {
+				// Find or add the component's type in the type table
+				std::string typeName = component->ComponentTypeName();
+				auto it = typeIndices.find(typeName);
+				if (it == typeIndices.end()) {
+					BinarySceneType type;
+					type.NameOffset = static_cast<uint32_t>(strings.size());
+					type.NameLength = static_cast<uint32_t>(typeName.size());
+					strings += typeName;
+					it = typeIndices.emplace(typeName, static_cast<uint32_t>(types.size())).first;
+					types.push_back(type);
+				}
+
+				// Components only know how to serialize to JSON, so we store that as MessagePack
+				std::vector<uint8_t> blob = nlohmann::json::to_msgpack(component->ToJson());
+
+				BinarySceneComponent componentEntry = BinarySceneComponent();
+				memcpy(componentEntry.Guid, component->GetGUID().bytes(), 16);
+				componentEntry.TypeIndex  = it->second;
+				componentEntry.IsEnabled  = component->IsEnabled ? 1 : 0;
+				componentEntry.BlobOffset = static_cast<uint32_t>(blobs.size());
+				componentEntry.BlobSize   = static_cast<uint32_t>(blob.size());
+				blobs.insert(blobs.end(), blob.begin(), blob.end());
+				components.push_back(componentEntry);
+			}
+		}
+
+		std::vector<uint8_t> settings = nlohmann::json::to_msgpack(_SaveSettings());
+
+		// Lay out the tables one after another
+		BinarySceneHeader header = BinarySceneHeader();
+		header.Version          = 0x01; // Update this and implement different readers if changes to format are made
+		header.NumObjects       = static_cast<uint32_t>(objects.size());
+		header.ObjectsOffset    = AlignBinaryOffset(sizeof(BinarySceneHeader));
+		header.TransformsOffset = AlignBinaryOffset(header.ObjectsOffset + objects.size() * sizeof(BinarySceneObject));
+		header.NumTypes         = static_cast<uint32_t>(types.size());
+		header.TypesOffset      = AlignBinaryOffset(header.TransformsOffset + transforms.size() * sizeof(BinarySceneTransform));
+		header.NumComponents    = static_cast<uint32_t>(components.size());
+		header.ComponentsOffset = AlignBinaryOffset(header.TypesOffset + types.size() * sizeof(BinarySceneType));
+		header.StringsOffset    = AlignBinaryOffset(header.ComponentsOffset + components.size() * sizeof(BinarySceneComponent));
+		header.StringsSize      = static_cast<uint32_t>(strings.size());
+		header.BlobsOffset      = AlignBinaryOffset(header.StringsOffset + strings.size());
+		header.BlobsSize        = static_cast<uint32_t>(blobs.size());
+		header.SettingsOffset   = AlignBinaryOffset(header.BlobsOffset + blobs.size());
+		header.SettingsSize     = static_cast<uint32_t>(settings.size());
+
+		// Build the file in memory so we can write it in one go
+		std::vector<uint8_t> output(header.SettingsOffset + settings.size(), 0);
+		memcpy(output.data(), &header, sizeof(BinarySceneHeader));
+		if (!objects.empty()) {
+			memcpy(output.data() + header.ObjectsOffset, objects.data(), objects.size() * sizeof(BinarySceneObject));
+			memcpy(output.data() + header.TransformsOffset, transforms.data(), transforms.size() * sizeof(BinarySceneTransform));
+		}
+		if (!types.empty()) {
+			memcpy(output.data() + header.TypesOffset, types.data(), types.size() * sizeof(BinarySceneType));
+			memcpy(output.data() + header.ComponentsOffset, components.data(), components.size() * sizeof(BinarySceneComponent));
+		}
+		memcpy(output.data() + header.StringsOffset, strings.data(), strings.size());
+		if (!blobs.empty()) {
+			memcpy(output.data() + header.BlobsOffset, blobs.data(), blobs.size());
+		}
+		memcpy(output.data() + header.SettingsOffset, settings.data(), settings.size());
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file) {
+			LOG_ERROR("Could not open \"{}\" for writing", path);
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(output.data()), output.size());
+		LOG_INFO("Saved binary scene to \"{}\" ({} objects, {} components, {} bytes)", path, objects.size(), components.size(), output.size());
+	}
+
+	Scene::Sptr Scene::LoadBinary(const std::string& path)
+	{
+		LOG_INFO("Loading binary scene from \"{}\"", path);
+		MappedFile file(path);
+		if (!file.IsOpen()) {
+			return nullptr;
+		}
+		const uint8_t* data = file.GetData();
+		const size_t   size = file.GetSize();
+
+		// Validate the header
+		BinarySceneHeader header = BinarySceneHeader();
+		if (size < sizeof(BinarySceneHeader)) {
+			LOG_ERROR("Binary scene \"{}\" is too small to contain a header", path);
+			return nullptr;
+		}
+		memcpy(&header, data, sizeof(BinarySceneHeader));
+		if (memcmp(header.HeaderBytes, BinarySceneHeader().HeaderBytes, 4) != 0 || header.Version != 0x01) {
+			LOG_ERROR("\"{}\" is not a supported binary scene file (version {})", path, header.Version);
+			return nullptr;
+		}
+
+		// Make sure all the tables fit within the file before we touch them
+		auto tableFits = [&](uint64_t offset, uint64_t count, uint64_t stride) {
+			return offset + count * stride <= size;
+		};
+		if (!tableFits(header.ObjectsOffset, header.NumObjects, sizeof(BinarySceneObject)) ||
+			!tableFits(header.TransformsOffset, header.NumObjects, sizeof(BinarySceneTransform)) ||
+			!tableFits(header.TypesOffset, header.NumTypes, sizeof(BinarySceneType)) ||
+			!tableFits(header.ComponentsOffset, header.NumComponents, sizeof(BinarySceneComponent)) ||
+			!tableFits(header.StringsOffset, header.StringsSize, 1) ||
+			!tableFits(header.BlobsOffset, header.BlobsSize, 1) ||
+			!tableFits(header.SettingsOffset, header.SettingsSize, 1)) {
+			LOG_ERROR("Binary scene \"{}\" is truncated", path);
+			return nullptr;
+		}
+
+		const BinarySceneObject*    objects    = reinterpret_cast<const BinarySceneObject*>(data + header.ObjectsOffset);
+		const BinarySceneTransform* transforms = reinterpret_cast<const BinarySceneTransform*>(data + header.TransformsOffset);
+		const BinarySceneType*      types      = reinterpret_cast<const BinarySceneType*>(data + header.TypesOffset);
+		const BinarySceneComponent* components = reinterpret_cast<const BinarySceneComponent*>(data + header.ComponentsOffset);
+		const char*                 strings    = reinterpret_cast<const char*>(data + header.StringsOffset);
+		const uint8_t*              blobs      = data + header.BlobsOffset;
+
+		// Resolve the type names once, rather than per component
+		std::vector<std::string> typeNames(header.NumTypes);
+		for (uint32_t ix = 0; ix < header.NumTypes; ix++) {
+			if (static_cast<uint64_t>(types[ix].NameOffset) + types[ix].NameLength <= header.StringsSize) {
+				typeNames[ix] = std::string(strings + types[ix].NameOffset, types[ix].NameLength);
+			}
+		}
+
+		Scene::Sptr result = std::make_shared<Scene>();
+		result->MainCamera = nullptr;
+		result->_objects.clear();
+		result->_objectsByGuid.clear();
+
+		// Decode without exceptions, so a corrupt blob is reported the same way as a bad header
+		nlohmann::json settings = nlohmann::json::from_msgpack(data + header.SettingsOffset, data + header.SettingsOffset + header.SettingsSize, true, false);
+		if (settings.is_discarded()) {
+			LOG_ERROR("Binary scene \"{}\" has corrupt scene settings", path);
+			return nullptr;
+		}
+		result->_LoadSettings(settings);
+
+		result->_objects.reserve(header.NumObjects);
+		for (uint32_t ix = 0; ix < header.NumObjects; ix++) {
+			const BinarySceneObject&    entry     = objects[ix];
+			const BinarySceneTransform& transform = transforms[ix];
+
+			// We can call the GameObject constructor here since Scene is a friend class of GameObjects
+			GameObject::Sptr obj(new GameObject());
+			obj->_scene   = result.get();
+			obj->_selfRef = obj;
+			obj->_guid    = Guid::FromBytes(const_cast<uint8_t*>(entry.Guid));
+			obj->_parent  = GameObject::WeakRef(Guid::FromBytes(const_cast<uint8_t*>(entry.ParentGuid)), result.get());
+			if (static_cast<uint64_t>(entry.NameOffset) + entry.NameLength <= header.StringsSize) {
+				obj->Name = std::string(strings + entry.NameOffset, entry.NameLength);
+			}
+			obj->_position = glm::vec3(transform.Position[0], transform.Position[1], transform.Position[2]);
+			obj->_rotation = glm::quat(transform.Rotation[3], transform.Rotation[0], transform.Rotation[1], transform.Rotation[2]);
+			obj->_scale    = glm::vec3(transform.Scale[0], transform.Scale[1], transform.Scale[2]);
+			obj->HideInHierarchy = entry.HideInHierarchy != 0;
+			obj->_isLocalTransformDirty = true;
+			obj->_isWorldTransformDirty = true;
+
+			for (uint64_t cx = entry.FirstComponent; cx < static_cast<uint64_t>(entry.FirstComponent) + entry.NumComponents && cx < header.NumComponents; cx++) {
+				const BinarySceneComponent& componentEntry = components[cx];
+				if (componentEntry.TypeIndex >= header.NumTypes ||
+					static_cast<uint64_t>(componentEntry.BlobOffset) + componentEntry.BlobSize > header.BlobsSize) {
+					LOG_WARN("Skipping invalid component {} on \"{}\"", cx, obj->Name);
+					continue;
+				}
+
+				const uint8_t* blobStart = blobs + componentEntry.BlobOffset;
+				nlohmann::json blob = nlohmann::json::from_msgpack(blobStart, blobStart + componentEntry.BlobSize, true, false);
+				if (blob.is_discarded()) {
+					LOG_ERROR("Binary scene \"{}\" has corrupt data for component {} on \"{}\"", path, cx, obj->Name);
+					return nullptr;
+				}
+
+				// We need to reference the component registry to load our components
+				IComponent::Sptr component = result->_components.Load(typeNames[componentEntry.TypeIndex], blob, Guid::FromBytes(const_cast<uint8_t*>(componentEntry.Guid)), componentEntry.IsEnabled != 0);
+				if (component == nullptr) {
+					LOG_WARN("Unknown component type \"{}\" on \"{}\"", typeNames[componentEntry.TypeIndex], obj->Name);
+					continue;
+				}
+				obj->_AttachLoadedComponent(component);
+			}
+
+			result->_objects.push_back(obj);
+			result->_objectsByGuid[obj->_guid] = obj;
+		}
+
+		// Re-build the parent hierarchy 
+		result->_RebuildHierarchy();
+
+		// Create and load camera config
+		result->MainCamera = result->_components.GetComponentByGUID<Camera>(Guid(settings["main_camera"]));
+		result->_filePath = path;
+
+		return result;
+	}
+
 	int Scene::NumObjects() const {
 		return static_cast<int>(_objects.size());
 	}
@@ -392,9 +656,11 @@ namespace Gameplay {
 	void Scene::_FlushDeleteQueue() {
 		for (auto& weakPtr : _deletionQueue) {
 			if (weakPtr.expired()) continue;
-			auto& it = std::find(_objects.begin(), _objects.end(), weakPtr.lock());
+			GameObject::Sptr object = weakPtr.lock();
+			auto& it = std::find(_objects.begin(), _objects.end(), object);
 			if (it != _objects.end()) {
 				_objects.erase(it);
+				_objectsByGuid.erase(object->_guid);
 			}
 		}
 		_deletionQueue.clear();
@@ -427,9 +693,13 @@ namespace Gameplay {
 			glDisable(GL_CULL_FACE);
 			glDepthFunc(GL_LEQUAL); 
 
+			// Interned once, so we don't need to look up the names every frame
+			static const UniformHandle u_ClippedView = "u_ClippedView"_uniform;
+			static const UniformHandle u_EnvironmentRotation = "u_EnvironmentRotation"_uniform;
+
 			_skyboxShader->Bind();
-			_skyboxShader->SetUniformMatrix("u_ClippedView", MainCamera->GetProjection() * glm::mat4(glm::mat3(MainCamera->GetView())));
-			_skyboxShader->SetUniformMatrix("u_EnvironmentRotation", _skyboxRotation);
+			_skyboxShader->SetUniformMatrix(u_ClippedView, MainCamera->GetProjection() * glm::mat4(glm::mat3(MainCamera->GetView())));
+			_skyboxShader->SetUniformMatrix(u_EnvironmentRotation, _skyboxRotation);
 			_skyboxTexture->Bind(0);
 			_skyboxMesh->Mesh->Draw();
 
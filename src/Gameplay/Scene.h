@@ -1,4 +1,5 @@
 #pragma once
+#include <unordered_map>
 #include <btBulletDynamicsCommon.h>
 #include "BulletCollision/CollisionDispatch/btGhostObject.h"
 
@@ -100,7 +101,7 @@ namespace Gameplay {
 		/// <summary>
 		/// Searches all render objects in the scene and returns the first
 		/// one who's guid matches the one given, or nullptr if no object
-		/// is found
+		/// is found. This is a constant time lookup into the scene's GUID index
 		/// </summary>
 		/// <param name="id">The guid of the object to find</param>
 		GameObject::Sptr FindObjectByGUID(Guid id) const;
@@ -207,6 +208,20 @@ namespace Gameplay {
 		/// <returns>A new scene loaded from the file</returns>
 		static Scene::Sptr Load(const std::string& path);
 
+		/// <summary>
+		/// Saves this scene to a binary scene file. This is much faster to load than the JSON
+		/// format, but is not human readable, so the JSON should remain the source asset
+		/// </summary>
+		/// <param name="path">The path of the file to write to</param>
+		void SaveBinary(const std::string& path);
+		/// <summary>
+		/// Loads a scene from a binary scene file, as written by SaveBinary. The file is memory
+		/// mapped and read in place
+		/// </summary>
+		/// <param name="path">The path of the file to read from</param>
+		/// <returns>A new scene loaded from the file, or nullptr if the file is not a valid scene</returns>
+		static Scene::Sptr LoadBinary(const std::string& path);
+
 
 		int NumObjects() const;
 		GameObject::Sptr GetObjectByIndex(int index) const;
@@ -242,6 +257,8 @@ namespace Gameplay {
 		// Stores all the objects in our scene
 		std::vector<GameObject::Sptr>  _objects;
 		std::vector<std::weak_ptr<GameObject>>  _deletionQueue;
+		// Maps object GUIDs to the objects in the scene, so we don't need to search _objects
+		std::unordered_map<Guid, std::weak_ptr<GameObject>> _objectsByGuid;
 
 		// Info for rendering our skybox will be stored in the scene itself
 		std::shared_ptr<ShaderProgram>       _skyboxShader;
@@ -285,6 +302,71 @@ namespace Gameplay {
 
 		bool                       _isAwake;
 
+		// Will be put at the start of binary scene files, contains the location of each of the
+		// tables in the file. All offsets are in bytes from the start of the file
+		struct BinarySceneHeader {
+			// A check value so we can ensure that we're loading in the right file type
+			char     HeaderBytes[4] = { 'B', 'S', 'C', 'N' };
+			// The version code, we can use this to create different loaders if our format changes
+			uint16_t Version = 0;
+			uint16_t Reserved = 0;
+			// The number of game objects, object i has it's transform at index i in the transform table
+			uint32_t NumObjects = 0;
+			uint32_t ObjectsOffset = 0;
+			uint32_t TransformsOffset = 0;
+			// The component type names, components refer to these by index
+			uint32_t NumTypes = 0;
+			uint32_t TypesOffset = 0;
+			// The components for all objects, stored in object order
+			uint32_t NumComponents = 0;
+			uint32_t ComponentsOffset = 0;
+			// Packed object and type names, not null terminated
+			uint32_t StringsOffset = 0;
+			uint32_t StringsSize = 0;
+			// Packed MessagePack blobs for the components
+			uint32_t BlobsOffset = 0;
+			uint32_t BlobsSize = 0;
+			// MessagePack blob with the scene level settings (skybox, lights, camera, etc...)
+			uint32_t SettingsOffset = 0;
+			uint32_t SettingsSize = 0;
+		};
+
+		// A single game object in a binary scene file
+		struct BinarySceneObject {
+			uint8_t  Guid[16];
+			// All zero if the object has no parent
+			uint8_t  ParentGuid[16];
+			uint32_t NameOffset;
+			uint32_t NameLength;
+			uint32_t FirstComponent;
+			uint32_t NumComponents;
+			uint32_t HideInHierarchy;
+			uint32_t Reserved;
+		};
+
+		// The local transform of a game object, stored in a separate table from the objects
+		struct BinarySceneTransform {
+			float Position[3];
+			// Stored as x, y, z, w
+			float Rotation[4];
+			float Scale[3];
+		};
+
+		// A component type name in a binary scene file
+		struct BinarySceneType {
+			uint32_t NameOffset;
+			uint32_t NameLength;
+		};
+
+		// A single component in a binary scene file, the type specific data is stored in a blob
+		struct BinarySceneComponent {
+			uint8_t  Guid[16];
+			uint32_t TypeIndex;
+			uint32_t IsEnabled;
+			uint32_t BlobOffset;
+			uint32_t BlobSize;
+		};
+
 		/// <summary>
 		/// Handles configuring our bullet physics stuff
 		/// </summary>
@@ -295,5 +377,18 @@ namespace Gameplay {
 		void _CleanupPhysics();
 
 		void _FlushDeleteQueue();
+
+		/// <summary>
+		/// Loads the scene level settings (default material, skybox, lights) from a JSON blob
+		/// </summary>
+		void _LoadSettings(const nlohmann::json& data);
+		/// <summary>
+		/// Saves the scene level settings to a JSON blob, does not include the game objects
+		/// </summary>
+		nlohmann::json _SaveSettings() const;
+		/// <summary>
+		/// Re-links children to their parents after the scene's objects have been loaded
+		/// </summary>
+		void _RebuildHierarchy();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "StreamingBuffer.h"
+#include "Logging.h"
+
+// These flags need to be the same for both the storage and the mapping
+static const GLbitfield STREAMING_MAP_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+StreamingBuffer::StreamingBuffer(BufferType type, uint32_t frameSize, uint32_t frameCount) :
+	IBuffer(type, BufferUsage::StreamDraw),
+	_mapped(nullptr),
+	_frameSize(0),
+	_frameCount(frameCount > 0 ? frameCount : 1),
+	_frameIndex(0),
+	_cursor(0),
+	_alignment(0),
+	_fences()
+{
+	// Indexed buffers need their ranges to be aligned, anything else just needs to be 4 byte aligned
+	GLint alignment = 4;
+	if (type == BufferType::Uniform) {
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	} else if (type == BufferType::ShaderStorage) {
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	}
+	_alignment = alignment > 0 ? static_cast<uint32_t>(alignment) : 256;
+
+	_frameSize = GetAlignedSize(frameSize > 0 ? frameSize : DEFAULT_FRAME_SIZE);
+	_fences.resize(_frameCount, nullptr);
+	_CreateStorage();
+}
+
+StreamingBuffer::~StreamingBuffer() {
+	_ReleaseStorage();
+}
+
+void StreamingBuffer::BeginFrame(uint32_t requiredSize) {
+	// Immutable storage can't be resized, so we need to make a new buffer if we've outgrown this one
+	if (requiredSize > _frameSize) {
+		uint32_t newSize = _frameSize * 2;
+		while (newSize < requiredSize) {
+			newSize *= 2;
+		}
+		LOG_INFO("Expanding streaming buffer from {} bytes to {} bytes per frame", _frameSize, newSize);
+
+		_ReleaseStorage();
+		glCreateBuffers(1, &_rendererId);
+		_frameSize = newSize;
+		_CreateStorage();
+	}
+
+	_frameIndex = (_frameIndex + 1) % _frameCount;
+	_cursor = 0;
+	_WaitForFrame(_frameIndex);
+}
+
+void StreamingBuffer::EndFrame() {
+	if (_fences[_frameIndex] != nullptr) {
+		glDeleteSync(_fences[_frameIndex]);
+	}
+	_fences[_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+uint32_t StreamingBuffer::Allocate(uint32_t size) {
+	uint32_t alignedSize = GetAlignedSize(size);
+	if (_cursor + alignedSize > _frameSize) {
+		LOG_WARN("Streaming buffer is out of space for this frame, pass the required size to BeginFrame");
+		return INVALID_OFFSET;
+	}
+
+	uint32_t offset = _frameIndex * _frameSize + _cursor;
+	_cursor += alignedSize;
+	return offset;
+}
+
+void StreamingBuffer::BindRange(uint32_t slot, uint32_t offset, uint32_t size) const {
+	glBindBufferRange((GLenum)_type, slot, _rendererId, offset, size);
+}
+
+void StreamingBuffer::LoadData(const void* data, uint32_t elementSize, uint32_t elementCount) {
+	LOG_WARN("LoadData is not supported for streaming buffers, use Allocate and GetPointer instead");
+}
+
+void StreamingBuffer::_CreateStorage() {
+	_size = _frameSize * _frameCount;
+	glNamedBufferStorage(_rendererId, _size, nullptr, STREAMING_MAP_FLAGS);
+	_mapped = reinterpret_cast<uint8_t*>(glMapNamedBufferRange(_rendererId, 0, _size, STREAMING_MAP_FLAGS));
+	LOG_ASSERT(_mapped != nullptr, "Failed to map streaming buffer");
+}
+
+void StreamingBuffer::_ReleaseStorage() {
+	for (uint32_t ix = 0; ix < _frameCount; ix++) {
+		_WaitForFrame(ix);
+	}
+	if (_rendererId != 0) {
+		if (_mapped != nullptr) {
+			glUnmapNamedBuffer(_rendererId);
+			_mapped = nullptr;
+		}
+		glDeleteBuffers(1, &_rendererId);
+		_rendererId = 0;
+	}
+}
+
+void StreamingBuffer::_WaitForFrame(uint32_t frame) {
+	GLsync& fence = _fences[frame];
+	if (fence == nullptr) {
+		return;
+	}
+
+	// Flush on the first attempt so that the fence is guaranteed to be signaled eventually
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (true) {
+		GLenum result = glClientWaitSync(fence, flags, 1000000);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+			break;
+		}
+		flags = 0;
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
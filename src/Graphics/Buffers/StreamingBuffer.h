@@ -0,0 +1,106 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+#include <vector>
+
+/// <summary>
+/// A persistently mapped buffer that is split into several frames worth of space, which are
+/// written to round-robin. The CPU writes directly into the mapped memory for the current
+/// frame while the GPU may still be reading from the previous ones, and a fence is placed at
+/// the end of each frame so that we only wait if the CPU gets a full ring ahead of the GPU.
+///
+/// Data is selected for a draw by binding a range of the buffer, so nothing is uploaded or
+/// renamed by the driver between draws
+/// </summary>
+class StreamingBuffer : public IBuffer {
+public:
+	typedef std::shared_ptr<StreamingBuffer> Sptr;
+
+	static inline Sptr Create(BufferType type, uint32_t frameSize = DEFAULT_FRAME_SIZE, uint32_t frameCount = DEFAULT_FRAME_COUNT) {
+		return std::make_shared<StreamingBuffer>(type, frameSize, frameCount);
+	}
+
+	// The number of bytes available to each frame by default, this will grow as needed
+	static const uint32_t DEFAULT_FRAME_SIZE = 64 * 1024;
+	// Triple buffering lets the CPU write a frame while the GPU is still working on the last two
+	static const uint32_t DEFAULT_FRAME_COUNT = 3;
+	// Returned by Allocate if the frame does not have enough space left
+	static const uint32_t INVALID_OFFSET = 0xFFFFFFFF;
+
+	/// <summary>
+	/// Creates a new streaming buffer
+	/// </summary>
+	/// <param name="type">The type of buffer, ex: Uniform, ShaderStorage or DrawIndirect</param>
+	/// <param name="frameSize">The number of bytes to allocate for each frame</param>
+	/// <param name="frameCount">The number of frames in the ring</param>
+	StreamingBuffer(BufferType type, uint32_t frameSize = DEFAULT_FRAME_SIZE, uint32_t frameCount = DEFAULT_FRAME_COUNT);
+	virtual ~StreamingBuffer();
+
+	/// <summary>
+	/// Moves to the next frame in the ring, waiting for the GPU to finish with it if needed.
+	/// If the frame is too small to hold requiredSize bytes, the buffer will be re-created
+	/// </summary>
+	/// <param name="requiredSize">The number of bytes that will be allocated this frame, use GetAlignedSize for each allocation</param>
+	void BeginFrame(uint32_t requiredSize = 0);
+	/// <summary>
+	/// Places a fence after all the commands that use the current frame, must be called after
+	/// the last draw that reads from this frame's data
+	/// </summary>
+	void EndFrame();
+
+	/// <summary>
+	/// Allocates a block within the current frame, the start of the block will respect the
+	/// driver's offset alignment for the buffer's type
+	/// </summary>
+	/// <param name="size">The size of the block in bytes</param>
+	/// <returns>The offset of the block within the buffer, or INVALID_OFFSET if the frame is full</returns>
+	uint32_t Allocate(uint32_t size);
+	/// <summary>
+	/// Gets a pointer to the mapped memory for a block returned by Allocate. The memory is write
+	/// only, reading from it may be extremely slow
+	/// </summary>
+	/// <param name="offset">The offset returned by Allocate</param>
+	uint8_t* GetPointer(uint32_t offset) const { return _mapped + offset; }
+
+	/// <summary>
+	/// Binds a block within the buffer to an indexed binding slot
+	/// </summary>
+	/// <param name="slot">The binding slot to bind to</param>
+	/// <param name="offset">The offset returned by Allocate</param>
+	/// <param name="size">The size of the block in bytes</param>
+	void BindRange(uint32_t slot, uint32_t offset, uint32_t size) const;
+
+	/// <summary>
+	/// Gets the number of bytes an allocation of the given size will take up within a frame
+	/// </summary>
+	uint32_t GetAlignedSize(uint32_t size) const { return (size + _alignment - 1) / _alignment * _alignment; }
+	uint32_t GetAlignment() const { return _alignment; }
+	uint32_t GetFrameSize() const { return _frameSize; }
+
+	// The contents are written through the mapped pointer, this would replace the whole buffer
+	virtual void LoadData(const void* data, uint32_t elementSize, uint32_t elementCount) override;
+
+protected:
+	uint8_t*              _mapped;
+	uint32_t              _frameSize;
+	uint32_t              _frameCount;
+	uint32_t              _frameIndex;
+	// The next free byte within the current frame, relative to the start of the frame
+	uint32_t              _cursor;
+	uint32_t              _alignment;
+	// One fence per frame in the ring, null if the GPU has nothing pending for that frame
+	std::vector<GLsync>   _fences;
+
+	/// <summary>
+	/// Creates the immutable storage for the buffer and maps it
+	/// </summary>
+	void _CreateStorage();
+	/// <summary>
+	/// Unmaps and deletes the buffer's storage, waiting for all pending frames first
+	/// </summary>
+	void _ReleaseStorage();
+	/// <summary>
+	/// Blocks until the GPU has finished reading from the given frame
+	/// </summary>
+	void _WaitForFrame(uint32_t frame);
+};
@@ -0,0 +1,70 @@
+#include "UniformBufferPool.h"
+#include "Logging.h"
+
+UniformBufferPool::UniformBufferPool(uint32_t initialSize, BufferUsage usage) :
+	IBuffer(BufferType::Uniform, usage),
+	_data(),
+	_used(0),
+	_alignment(0),
+	_freeBlocks()
+{
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	_alignment = alignment > 0 ? static_cast<uint32_t>(alignment) : 256;
+
+	_data.resize(initialSize > 0 ? initialSize : DEFAULT_SIZE, 0);
+	_size = static_cast<uint32_t>(_data.size());
+	glNamedBufferData(_rendererId, _size, _data.data(), (GLenum)_usage);
+}
+
+uint32_t UniformBufferPool::Allocate(uint32_t size) {
+	if (size == 0) {
+		return INVALID_OFFSET;
+	}
+	uint32_t alignedSize = (size + _alignment - 1) / _alignment * _alignment;
+
+	// Re-use a freed block of the same size if we have one
+	auto it = _freeBlocks.find(alignedSize);
+	if (it != _freeBlocks.end() && !it->second.empty()) {
+		uint32_t offset = it->second.back();
+		it->second.pop_back();
+		return offset;
+	}
+
+	// Grow the pool if we need to, since we have a CPU copy we can just re-upload everything
+	if (_used + alignedSize > _data.size()) {
+		size_t newSize = _data.size() * 2;
+		while (_used + alignedSize > newSize) {
+			newSize *= 2;
+		}
+		LOG_INFO("Expanding uniform buffer pool from {} bytes to {} bytes", _data.size(), newSize);
+		_data.resize(newSize, 0);
+		_size = static_cast<uint32_t>(newSize);
+		glNamedBufferData(_rendererId, _size, _data.data(), (GLenum)_usage);
+	}
+
+	uint32_t offset = _used;
+	_used += alignedSize;
+	return offset;
+}
+
+void UniformBufferPool::Free(uint32_t offset, uint32_t size) {
+	if (offset == INVALID_OFFSET || size == 0) {
+		return;
+	}
+	uint32_t alignedSize = (size + _alignment - 1) / _alignment * _alignment;
+	_freeBlocks[alignedSize].push_back(offset);
+}
+
+void UniformBufferPool::Update(uint32_t offset, uint32_t size) {
+	LOG_ASSERT(offset + size <= _data.size(), "Update exceeds the bounds of the uniform buffer pool");
+	glNamedBufferSubData(_rendererId, offset, size, _data.data() + offset);
+}
+
+void UniformBufferPool::BindRange(int slot, uint32_t offset, uint32_t size) const {
+	glBindBufferRange(GL_UNIFORM_BUFFER, slot, _rendererId, offset, size);
+}
+
+void UniformBufferPool::LoadData(const void* data, uint32_t elementSize, uint32_t elementCount) {
+	LOG_WARN("LoadData is not supported for uniform buffer pools, use Allocate and Update instead");
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+/// <summary>
+/// A single large uniform buffer that is split up into many smaller blocks, so that lots of
+/// small uniform blocks (ex: one per material) can share one buffer object and be selected
+/// with glBindBufferRange. A copy of the data is kept on the CPU, so blocks can be written
+/// in place and uploaded with Update
+/// </summary>
+class UniformBufferPool : public IBuffer {
+public:
+	typedef std::shared_ptr<UniformBufferPool> Sptr;
+
+	static inline Sptr Create(uint32_t initialSize = DEFAULT_SIZE, BufferUsage usage = BufferUsage::DynamicDraw) {
+		return std::make_shared<UniformBufferPool>(initialSize, usage);
+	}
+
+	// The size that pools will start at by default, they will grow as needed
+	static const uint32_t DEFAULT_SIZE = 64 * 1024;
+	// Returned by Allocate if the block could not be allocated
+	static const uint32_t INVALID_OFFSET = 0xFFFFFFFF;
+
+	/// <summary>
+	/// Creates a new empty pool
+	/// </summary>
+	/// <param name="initialSize">The number of bytes to allocate up front</param>
+	/// <param name="usage">The buffer's usage hint, default DynamicDraw</param>
+	UniformBufferPool(uint32_t initialSize = DEFAULT_SIZE, BufferUsage usage = BufferUsage::DynamicDraw);
+	virtual ~UniformBufferPool() = default;
+
+	/// <summary>
+	/// Allocates a new block within the pool. The start of the block will respect the driver's
+	/// uniform buffer offset alignment. If the pool is full, it will grow
+	/// </summary>
+	/// <param name="size">The size of the block in bytes</param>
+	/// <returns>The offset of the block within the pool</returns>
+	uint32_t Allocate(uint32_t size);
+	/// <summary>
+	/// Returns a block to the pool, so that it can be re-used by later allocations of the same size
+	/// </summary>
+	/// <param name="offset">The offset returned by Allocate</param>
+	/// <param name="size">The size that was passed to Allocate</param>
+	void Free(uint32_t offset, uint32_t size);
+
+	/// <summary>
+	/// Gets a pointer to the CPU copy of a block. This is only valid until the next call to Allocate
+	/// </summary>
+	/// <param name="offset">The offset of the block within the pool</param>
+	uint8_t* GetData(uint32_t offset) { return _data.data() + offset; }
+	/// <summary>
+	/// Uploads the CPU copy of a range of the pool to OpenGL
+	/// </summary>
+	/// <param name="offset">The offset of the range in bytes</param>
+	/// <param name="size">The size of the range in bytes</param>
+	void Update(uint32_t offset, uint32_t size);
+
+	/// <summary>
+	/// Binds a single block in the pool to a uniform buffer binding slot
+	/// </summary>
+	/// <param name="slot">The uniform buffer binding slot to bind to</param>
+	/// <param name="offset">The offset of the block within the pool</param>
+	/// <param name="size">The size of the block in bytes</param>
+	void BindRange(int slot, uint32_t offset, uint32_t size) const;
+
+	/// <summary>
+	/// Gets the number of bytes that the start of each block is aligned to
+	/// </summary>
+	uint32_t GetAlignment() const { return _alignment; }
+
+	// Pools manage their own contents, these would replace the whole pool
+	virtual void LoadData(const void* data, uint32_t elementSize, uint32_t elementCount) override;
+
+protected:
+	// The CPU copy of the pool's contents
+	std::vector<uint8_t> _data;
+	// The end of the allocated space within the pool
+	uint32_t _used;
+	uint32_t _alignment;
+	// Blocks that have been freed, keyed by their aligned size
+	std::unordered_map<uint32_t, std::vector<uint32_t>> _freeBlocks;
+};
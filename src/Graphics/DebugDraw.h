@@ -145,4 +145,5 @@ protected:
 
 	inline static DebugDrawer* __Instance = nullptr;
 	inline static ShaderProgram::Sptr __Shader = nullptr;
+	inline static const UniformHandle __MVP = "u_MVP"_uniform;
 };
\ No newline at end of file
@@ -32,6 +32,14 @@ ENUM(TextureType, GLenum,
 	_2DMultisample = GL_TEXTURE_2D_MULTISAMPLE
 )
 
+// S3TC isn't part of core OpenGL, but every desktop driver supports it
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 // https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexImage2D.xhtml
 // These are some of our more common available internal formats
 ENUM(InternalFormat, GLint,
@@ -49,7 +57,11 @@ ENUM(InternalFormat, GLint,
 	RGBA8        = GL_RGBA8,
 	SRGBA        = GL_SRGB8_ALPHA8,
 	RGBA16       = GL_RGBA16,
-	RGB32AF      = GL_RGBA32F
+	RGB32AF      = GL_RGBA32F,
+	// Block compressed formats, these can only be filled with glCompressedTextureSubImage
+	BC1          = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+	BC3          = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+	BC5          = GL_COMPRESSED_RG_RGTC2
 	// Note: There are sized internal formats but there is a LOT of them
 )
 
@@ -745,9 +757,12 @@ ENUM(BlendEquation, uint32_t,
 /// </summary>
 /// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glBufferData.xhtml</see>
 ENUM(BufferType, GLenum,
-	Vertex  = GL_ARRAY_BUFFER,
-	Index   = GL_ELEMENT_ARRAY_BUFFER,
-	Uniform = GL_UNIFORM_BUFFER
+	Vertex        = GL_ARRAY_BUFFER,
+	Index         = GL_ELEMENT_ARRAY_BUFFER,
+	Uniform       = GL_UNIFORM_BUFFER,
+	ShaderStorage = GL_SHADER_STORAGE_BUFFER,
+	DrawIndirect  = GL_DRAW_INDIRECT_BUFFER,
+	PixelUnpack   = GL_PIXEL_UNPACK_BUFFER
 )
 
 /// <summary>
@@ -811,6 +826,7 @@ ENUM(AttributeType, GLenum,
 	 UInt    = GL_UNSIGNED_INT,
 	 Float   = GL_FLOAT,
 	 Double  = GL_DOUBLE,
+	 HalfFloat = GL_HALF_FLOAT,
 	 Unknown = GL_NONE
 )
 
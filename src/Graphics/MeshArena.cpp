@@ -0,0 +1,171 @@
+#include "MeshArena.h"
+#include "Logging.h"
+
+// Attributes are compared field by field, since different meshes will have their own copies of the declaration
+static bool AttributesMatch(const BufferAttribute& a, const BufferAttribute& b) {
+	return
+		a.Slot == b.Slot && a.Size == b.Size && a.Type == b.Type && a.Normalized == b.Normalized &&
+		a.Stride == b.Stride && a.Offset == b.Offset;
+}
+
+MeshArena::MeshArena(const VertexArrayObject::VertexDeclaration& vDecl) :
+	_vDecl(vDecl),
+	_stride(vDecl.empty() ? 0 : vDecl[0].Stride),
+	_vertices(nullptr),
+	_indices(nullptr),
+	_vao(nullptr),
+	_vertexCount(0),
+	_vertexCapacity(0),
+	_indexCount(0),
+	_indexCapacity(0),
+	_meshes()
+{
+	_Reserve(INITIAL_VERTICES, INITIAL_INDICES);
+}
+
+bool MeshArena::CanStore(const VertexArrayObject::Sptr& mesh) {
+	if (mesh == nullptr || mesh->GetIndexBuffer() == nullptr || mesh->GetVertexBuffers().size() != 1) {
+		return false;
+	}
+	const VertexArrayObject::VertexBufferBinding* binding = mesh->GetVertexBuffers()[0];
+	return !binding->IsInstanced() && !binding->GetAttributes().empty();
+}
+
+const VertexArrayObject::VertexDeclaration& MeshArena::GetLayout(const VertexArrayObject::Sptr& mesh) {
+	return mesh->GetVertexBuffers()[0]->GetAttributes();
+}
+
+bool MeshArena::IsCompatible(const VertexArrayObject::Sptr& mesh) const {
+	if (!CanStore(mesh)) {
+		return false;
+	}
+	const VertexArrayObject::VertexDeclaration& layout = GetLayout(mesh);
+	if (layout.size() != _vDecl.size()) {
+		return false;
+	}
+	for (size_t ix = 0; ix < layout.size(); ix++) {
+		if (!AttributesMatch(layout[ix], _vDecl[ix])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+const MeshArena::Entry* MeshArena::GetOrAdd(const VertexArrayObject::Sptr& mesh) {
+	// If we've seen this mesh before (and it's not a new mesh that happens to re-use the address), we're done
+	auto it = _meshes.find(mesh.get());
+	if (it != _meshes.end() && !it->second.Location.Lods.empty() && it->second.Source.lock() == mesh) {
+		return &it->second.Location;
+	}
+
+	// Forget about meshes that have been destroyed, so their addresses can't be confused with new meshes.
+	// Their space in the buffers is not re-used, the arena's owner should drop the arena to reclaim it
+	for (auto stale = _meshes.begin(); stale != _meshes.end();) {
+		stale = stale->second.Source.expired() ? _meshes.erase(stale) : std::next(stale);
+	}
+	StoredMesh& stored = _meshes[mesh.get()];
+
+	const VertexBuffer::Sptr& sourceVertices = mesh->GetVertexBuffers()[0]->GetBuffer();
+	const IndexBuffer::Sptr& sourceIndices = mesh->GetIndexBuffer();
+	uint32_t vertexCount = sourceVertices->GetTotalSize() / _stride;
+	uint32_t indexCount = sourceIndices->GetElementCount();
+
+	_Reserve(vertexCount, indexCount);
+
+	// Vertices are already in the right format, so they can be copied without leaving the GPU
+	uint32_t baseVertex = _vertexCount;
+	glCopyNamedBufferSubData(sourceVertices->GetHandle(), _vertices->GetHandle(), 0, (GLintptr)baseVertex * _stride, (GLsizeiptr)vertexCount * _stride);
+	_vertexCount += vertexCount;
+
+	// Meshes can have 8, 16 or 32 bit indices, but the arena always uses 32 bit indices, so we need to
+	// read them back and widen them. Indices are left relative to the mesh, and drawn with a base vertex
+	IndexType indexType = sourceIndices->GetElementType();
+	size_t indexSize = GetIndexTypeSize(indexType);
+	std::vector<uint8_t> rawIndices(indexCount * indexSize);
+	glGetNamedBufferSubData(sourceIndices->GetHandle(), 0, rawIndices.size(), rawIndices.data());
+
+	std::vector<uint32_t> indices(indexCount);
+	for (uint32_t ix = 0; ix < indexCount; ix++) {
+		switch (indexType) {
+			case IndexType::UByte:  indices[ix] = rawIndices[ix]; break;
+			case IndexType::UShort: indices[ix] = reinterpret_cast<const uint16_t*>(rawIndices.data())[ix]; break;
+			default:                indices[ix] = reinterpret_cast<const uint32_t*>(rawIndices.data())[ix]; break;
+		}
+	}
+
+	uint32_t firstIndex = _indexCount;
+	glNamedBufferSubData(_indices->GetHandle(), (GLintptr)firstIndex * sizeof(uint32_t), (GLsizeiptr)indices.size() * sizeof(uint32_t), indices.data());
+	_indexCount += indexCount;
+
+	// Work out the ranges to draw, this needs to match how VertexArrayObject::Draw handles the mesh
+	Entry entry;
+	if (!mesh->GetLods().empty()) {
+		for (const VertexArrayObject::MeshLod& lod : mesh->GetLods()) {
+			if (lod.SubMeshCount > 0) {
+				entry.Lods.emplace_back();
+				for (uint32_t ix = lod.FirstSubMesh; ix < lod.FirstSubMesh + lod.SubMeshCount; ix++) {
+					const VertexArrayObject::SubMesh& subMesh = mesh->GetSubMeshes()[ix];
+					entry.Lods.back().push_back({ firstIndex + subMesh.FirstIndex, subMesh.IndexCount, static_cast<int32_t>(baseVertex) + subMesh.BaseVertex });
+				}
+			} else {
+				entry.Lods.push_back({ { firstIndex + lod.FirstIndex, lod.IndexCount, static_cast<int32_t>(baseVertex) } });
+			}
+		}
+	} else if (!mesh->GetSubMeshes().empty()) {
+		entry.Lods.emplace_back();
+		for (const VertexArrayObject::SubMesh& subMesh : mesh->GetSubMeshes()) {
+			entry.Lods[0].push_back({ firstIndex + subMesh.FirstIndex, subMesh.IndexCount, static_cast<int32_t>(baseVertex) + subMesh.BaseVertex });
+		}
+	} else {
+		entry.Lods.push_back({ { firstIndex, mesh->GetElementCount(), static_cast<int32_t>(baseVertex) } });
+	}
+
+	stored.Source = mesh;
+	stored.Location = entry;
+
+	LOG_TRACE("Added mesh with {} vertices and {} indices to arena, arena now has {} vertices and {} indices", vertexCount, indexCount, _vertexCount, _indexCount);
+	return &stored.Location;
+}
+
+void MeshArena::_Reserve(uint32_t vertices, uint32_t indices) {
+	bool growVertices = _vertexCount + vertices > _vertexCapacity;
+	bool growIndices = _indexCount + indices > _indexCapacity;
+	if (_vao != nullptr && !growVertices && !growIndices) {
+		return;
+	}
+
+	// Grow by doubling, copying the existing contents over on the GPU
+	if (growVertices) {
+		uint32_t capacity = _vertexCapacity > 0 ? _vertexCapacity : 1;
+		while (_vertexCount + vertices > capacity) {
+			capacity *= 2;
+		}
+		VertexBuffer::Sptr buffer = VertexBuffer::Create(BufferUsage::StaticDraw);
+		buffer->LoadData(nullptr, _stride, capacity);
+		if (_vertices != nullptr && _vertexCount > 0) {
+			glCopyNamedBufferSubData(_vertices->GetHandle(), buffer->GetHandle(), 0, 0, (GLsizeiptr)_vertexCount * _stride);
+		}
+		_vertices = buffer;
+		_vertexCapacity = capacity;
+	}
+	if (growIndices) {
+		uint32_t capacity = _indexCapacity > 0 ? _indexCapacity : 1;
+		while (_indexCount + indices > capacity) {
+			capacity *= 2;
+		}
+		IndexBuffer::Sptr buffer = IndexBuffer::Create(BufferUsage::StaticDraw, IndexType::UInt);
+		buffer->LoadData(nullptr, sizeof(uint32_t), capacity, IndexType::UInt);
+		if (_indices != nullptr && _indexCount > 0) {
+			glCopyNamedBufferSubData(_indices->GetHandle(), buffer->GetHandle(), 0, 0, (GLsizeiptr)_indexCount * sizeof(uint32_t));
+		}
+		_indices = buffer;
+		_indexCapacity = capacity;
+	}
+
+	// We make a whole new VAO rather than updating the old one, so that anything holding copies of the
+	// VAO (ex: instanced versions in the RenderLayer) can tell that it has changed
+	_vao = VertexArrayObject::Create();
+	_vao->AddVertexBuffer(_vertices, _vDecl);
+	_vao->SetIndexBuffer(_indices);
+	_vao->SetVDecl(_vDecl);
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// Stores the vertices and indices of many meshes that share a vertex layout in one large
+/// vertex buffer and index buffer, so that they can all be drawn from a single VAO with
+/// glMultiDrawElementsIndirect.
+///
+/// Meshes are copied into the arena the first time they are added, and their space is not
+/// re-used if they are destroyed, so this is intended for static scenery rather than meshes
+/// that are generated at runtime. Owners should drop the arena when it's meshes are no longer
+/// needed (ex: when the scene changes)
+/// </summary>
+class MeshArena {
+public:
+	typedef std::shared_ptr<MeshArena> Sptr;
+
+	static inline Sptr Create(const VertexArrayObject::VertexDeclaration& vDecl) {
+		return std::make_shared<MeshArena>(vDecl);
+	}
+
+	/// <summary>
+	/// A range of the arena's index buffer that makes up part of a mesh
+	/// </summary>
+	struct DrawRange {
+		uint32_t FirstIndex;
+		uint32_t IndexCount;
+		int32_t  BaseVertex;
+	};
+
+	/// <summary>
+	/// The location of a single mesh within the arena, indexed by level of detail. Each LOD may
+	/// be made up of several ranges if the source mesh has sub-meshes
+	/// </summary>
+	struct Entry {
+		std::vector<std::vector<DrawRange>> Lods;
+
+		/// <summary>
+		/// Gets the ranges to draw for a level of detail, clamped to the number of LODs
+		/// </summary>
+		const std::vector<DrawRange>& GetLod(uint32_t lod) const { return Lods[lod < Lods.size() ? lod : Lods.size() - 1]; }
+	};
+
+	/// <summary>
+	/// Creates a new empty arena for meshes with the given vertex layout
+	/// </summary>
+	/// <param name="vDecl">The attributes of the arena's vertex buffer</param>
+	MeshArena(const VertexArrayObject::VertexDeclaration& vDecl);
+	~MeshArena() = default;
+
+	/// <summary>
+	/// Returns true if the mesh can be stored in an arena at all, meaning it is indexed and
+	/// has all it's vertex data in a single vertex buffer
+	/// </summary>
+	static bool CanStore(const VertexArrayObject::Sptr& mesh);
+	/// <summary>
+	/// Gets the attributes of a mesh's vertex buffer, the arena for the mesh should have the same layout
+	/// </summary>
+	static const VertexArrayObject::VertexDeclaration& GetLayout(const VertexArrayObject::Sptr& mesh);
+
+	/// <summary>
+	/// Returns true if the mesh has the same vertex layout as this arena
+	/// </summary>
+	bool IsCompatible(const VertexArrayObject::Sptr& mesh) const;
+
+	/// <summary>
+	/// Gets the location of a mesh within the arena, copying it in if this is the first time the
+	/// mesh has been seen. Note that this may re-create the arena's VAO
+	/// </summary>
+	/// <param name="mesh">The mesh to find, must be compatible with this arena</param>
+	/// <returns>The location of the mesh in the arena, the pointer remains valid for the life of the arena</returns>
+	const Entry* GetOrAdd(const VertexArrayObject::Sptr& mesh);
+
+	/// <summary>
+	/// Gets a VAO that reads from the arena's buffers, all indices in the arena are 32 bit
+	/// </summary>
+	const VertexArrayObject::Sptr& GetVao() const { return _vao; }
+
+	uint32_t GetVertexCount() const { return _vertexCount; }
+	uint32_t GetIndexCount() const { return _indexCount; }
+
+protected:
+	// The number of vertices and indices that the arena starts with space for
+	static const uint32_t INITIAL_VERTICES = 64 * 1024;
+	static const uint32_t INITIAL_INDICES = 256 * 1024;
+
+	VertexArrayObject::VertexDeclaration _vDecl;
+	uint32_t                             _stride;
+
+	VertexBuffer::Sptr      _vertices;
+	IndexBuffer::Sptr       _indices;
+	VertexArrayObject::Sptr _vao;
+
+	uint32_t _vertexCount;
+	uint32_t _vertexCapacity;
+	uint32_t _indexCount;
+	uint32_t _indexCapacity;
+
+	struct StoredMesh {
+		std::weak_ptr<VertexArrayObject> Source;
+		Entry                            Location;
+	};
+	std::unordered_map<VertexArrayObject*, StoredMesh> _meshes;
+
+	/// <summary>
+	/// Makes sure the arena has space for the given number of additional vertices and indices,
+	/// growing the buffers and re-creating the VAO if needed
+	/// </summary>
+	void _Reserve(uint32_t vertices, uint32_t indices);
+};
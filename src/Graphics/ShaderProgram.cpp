@@ -3,20 +3,29 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
+#include <iomanip>
+#include <cstring>
 
 #include "Utils/FileHelpers.h"
 #include "Utils/JsonGlmHelpers.h"
 
 ShaderProgram::ShaderProgram() : 
 	IGraphicsResource(),
-	IResource()
+	IResource(),
+	_varyings(),
+	_interleavedVaryings(true),
+	_uniformOwner(0)
 {
 	_rendererId = glCreateProgram();
 }
 
 ShaderProgram::ShaderProgram(const std::unordered_map<ShaderPartType, std::string>& filePaths) :
 	IGraphicsResource(),
-	IResource()
+	IResource(),
+	_varyings(),
+	_interleavedVaryings(true),
+	_uniformOwner(0)
 {
 	_rendererId = glCreateProgram();
 	for (auto& [type, path] : filePaths) {
@@ -33,11 +42,27 @@ ShaderProgram::~ShaderProgram() {
 }
 
 bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
+	// If we're overwriting, warn before we replace the old source
+	if (_pendingSources.count(type) != 0) {
+		LOG_WARN("Another shader has been attached to this slot, overwriting");
+	}
+	// Compiling is left until we link, since we may not need to if the program is cached
+	_pendingSources[type] = source;
+
+	// Store info about where we got this data from
+	_fileSourceMap[type].IsFilePath = false;
+	_fileSourceMap[type].Source = source;
+
+	return true;
+}
+
+bool ShaderProgram::_CompileShaderPart(const std::string& source, ShaderPartType type) {
 	// Creates a new shader part (VS, FS, GS, etc...)
 	GLuint handle = glCreateShader((GLenum)type);
 
 	// Load the GLSL source and compile it
-	glShaderSource(handle, 1, &source, nullptr);
+	const char* sourcePtr = source.c_str();
+	glShaderSource(handle, 1, &sourcePtr, nullptr);
 	glCompileShader(handle);
 
 	// Get the compilation status for the shader part
@@ -57,6 +82,9 @@ bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
 
 		// Dump error log
 		LOG_ERROR("Failed to compile shader part:\n{}", log);
+		if (_fileSourceMap[type].IsFilePath) {
+			LOG_ERROR("Source File: {}", _fileSourceMap[type].Source);
+		}
 
 		// Clean up our log memory
 		delete[] log;
@@ -68,18 +96,8 @@ bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
 		return false;
 	}
 
-	// If we're overwriting, warn and clean up the old program before we store
-	if (_handles[type] != 0) {
-		LOG_WARN("Another shader has been attached to this slot, overwriting");
-		glDeleteShader(_handles[type]);
-	}
 	_handles[type] = handle;
-
-	// Store info about where we got this data from
-	_fileSourceMap[type].IsFilePath = false;
-	_fileSourceMap[type].Source = source;
-
-	return status != GL_FALSE;
+	return true;
 }
 
 bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type) {
@@ -92,9 +110,6 @@ bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type
 		bool result =  LoadShaderPart(source.c_str(), type);
 		_fileSourceMap[type].IsFilePath = true;
 		_fileSourceMap[type].Source = path;
-		if (result == false) {
-			LOG_ERROR("Source File: {}", path);
-		}
 		return result; 
 	} else {
 		LOG_WARN("Could not open file at \"{}\"", path);
@@ -105,6 +120,27 @@ bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type
 bool ShaderProgram::Link() {
 
 	LOG_TRACE("Starting shader link:");
+
+	// If we've linked these exact sources before, we can skip compiling and linking entirely
+	bool useCache = !__binaryCacheDir.empty() && !_pendingSources.empty();
+	if (useCache) {
+		GLint numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		useCache = numFormats > 0;
+	}
+	uint64_t cacheKey = useCache ? _CalculateCacheKey() : 0;
+	if (useCache && _LoadFromBinaryCache(cacheKey)) {
+		_pendingSources.clear();
+		LOG_TRACE("Loaded program from binary cache ({:016x}), starting introspection", cacheKey);
+		_Introspect();
+		return true;
+	}
+
+	// Compile all the parts we've been given
+	for (auto& [type, source] : _pendingSources) {
+		_CompileShaderPart(source, type);
+	}
+	_pendingSources.clear();
 	
 	// Attach all our shaders
 	for (auto& [type, id] : _handles) {
@@ -114,6 +150,11 @@ bool ShaderProgram::Link() {
 		}
 	}
 
+	// Let the driver know we'll be asking for the binary, so that it keeps it around
+	if (useCache) {
+		glProgramParameteri(_rendererId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
 	// Perform linking
 	glLinkProgram(_rendererId);
 
@@ -148,6 +189,11 @@ bool ShaderProgram::Link() {
 		}
 	} else {
 		LOG_TRACE("Linking complete, starting introspection");
+
+		// Save the program so we can skip all of this next time
+		if (useCache) {
+			_StoreInBinaryCache(cacheKey);
+		}
 	}
 
 	// Perform our uniform introspection to see what uniforms are in the shader
@@ -156,6 +202,126 @@ bool ShaderProgram::Link() {
 	return status != GL_FALSE;
 }
 
+// 64 bit FNV-1a, used for the binary cache keys and checksums
+static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t ix = 0; ix < size; ix++) {
+		hash ^= bytes[ix];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static uint64_t HashString(const std::string& value, uint64_t hash) {
+	// Include the length, so that the boundaries between strings are part of the hash
+	uint64_t length = value.size();
+	hash = HashBytes(&length, sizeof(uint64_t), hash);
+	return HashBytes(value.data(), value.size(), hash);
+}
+
+// Gets the path of the file that stores the given key in the binary cache
+static std::filesystem::path GetCacheEntryPath(const std::string& directory, uint64_t key) {
+	std::stringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+	return std::filesystem::path(directory) / name.str();
+}
+
+uint64_t ShaderProgram::_CalculateCacheKey() const {
+	uint64_t hash = HashBytes(nullptr, 0);
+
+	// A driver update can change the binary format, so the driver is part of the key
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+		const char* value = reinterpret_cast<const char*>(glGetString(name));
+		hash = HashString(value != nullptr ? value : "", hash);
+	}
+
+	// Stages are hashed in a fixed order, since the map's order is not
+	std::vector<ShaderPartType> types;
+	for (auto& [type, source] : _pendingSources) {
+		types.push_back(type);
+	}
+	std::sort(types.begin(), types.end());
+	for (ShaderPartType type : types) {
+		uint32_t typeValue = static_cast<uint32_t>(type);
+		hash = HashBytes(&typeValue, sizeof(uint32_t), hash);
+		hash = HashString(_pendingSources.at(type), hash);
+	}
+
+	for (const std::string& varying : _varyings) {
+		hash = HashString(varying, hash);
+	}
+	hash = HashBytes(&_interleavedVaryings, sizeof(bool), hash);
+
+	return hash;
+}
+
+bool ShaderProgram::_LoadFromBinaryCache(uint64_t key) {
+	std::filesystem::path path = GetCacheEntryPath(__binaryCacheDir, key);
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	// Read and validate the header and binary before we hand them to the driver
+	BinaryCacheHeader header;
+	std::vector<uint8_t> binary;
+	bool valid = false;
+	if (file.read(reinterpret_cast<char*>(&header), sizeof(BinaryCacheHeader)) &&
+		memcmp(header.Magic, BinaryCacheHeader().Magic, 4) == 0 &&
+		header.Version == BinaryCacheHeader().Version &&
+		header.Key == key && header.Size > 0) 
+	{
+		binary.resize(header.Size);
+		valid = file.read(reinterpret_cast<char*>(binary.data()), header.Size) &&
+			HashBytes(binary.data(), binary.size()) == header.Checksum;
+	}
+	file.close();
+
+	// The driver may still reject the binary, for instance if it was updated without the version changing
+	if (valid) {
+		glProgramBinary(_rendererId, header.Format, binary.data(), header.Size);
+		GLint status = 0;
+		glGetProgramiv(_rendererId, GL_LINK_STATUS, &status);
+		valid = status != GL_FALSE;
+	}
+
+	// Remove bad entries so that we don't keep trying to load them
+	if (!valid) {
+		LOG_WARN("Discarding invalid shader cache entry \"{}\"", path.string());
+		std::error_code error;
+		std::filesystem::remove(path, error);
+	}
+	return valid;
+}
+
+void ShaderProgram::_StoreInBinaryCache(uint64_t key) {
+	GLint size = 0;
+	glGetProgramiv(_rendererId, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0) {
+		return;
+	}
+
+	BinaryCacheHeader header;
+	std::vector<uint8_t> binary(size);
+	GLenum format = 0;
+	glGetProgramBinary(_rendererId, size, &size, &format, binary.data());
+	header.Key      = key;
+	header.Format   = format;
+	header.Size     = static_cast<uint32_t>(size);
+	header.Checksum = HashBytes(binary.data(), size);
+
+	std::error_code error;
+	std::filesystem::create_directories(__binaryCacheDir, error);
+	std::filesystem::path path = GetCacheEntryPath(__binaryCacheDir, key);
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		LOG_WARN("Failed to write shader cache entry \"{}\"", path.string());
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryCacheHeader));
+	file.write(reinterpret_cast<const char*>(binary.data()), size);
+}
+
 void ShaderProgram::Bind() {
 	// Simply calls glUseProgram with our shader handle
 	glUseProgram(_rendererId);
@@ -306,11 +472,37 @@ void ShaderProgram::SetUniform(int location, ShaderDataType type, void* data, in
 	}
 }
 
+int ShaderProgram::GetAttributeLocation(const std::string& name) const {
+	auto it = _attributes.find(name);
+	return it != _attributes.end() ? it->second : -1;
+}
+
 int ShaderProgram::__GetUniformLocation(const std::string& name) {
-	// Since the default constructor for UniformInfo sets location to -1,
-	// we can simply index the map and if it doesn't exist, the default
-	// will be used
-	return _uniforms[name].Location;
+	// Use find instead of indexing, so that misses don't add empty uniforms to the map
+	auto it = _uniforms.find(name);
+	return it != _uniforms.end() ? it->second.Location : -1;
+}
+
+int ShaderProgram::GetUniformLocation(const UniformHandle& handle) {
+	// Marks a handle that we haven't looked up yet, -1 is used for uniforms that don't exist
+	const int UNRESOLVED = -2;
+
+	if (!handle.IsValid()) {
+		return -1;
+	}
+	if (handle.GetId() >= _handleLocations.size()) {
+		_handleLocations.resize(handle.GetId() + 1, UNRESOLVED);
+	}
+
+	int& location = _handleLocations[handle.GetId()];
+	if (location == UNRESOLVED) {
+		location = __GetUniformLocation(handle.GetName());
+		// We only warn once per handle, instead of every time it's set
+		if (location == -1) {
+			LOG_WARN("Ignoring uniform \"{}\"", handle.GetName());
+		}
+	}
+	return location;
 }
 
 nlohmann::json ShaderProgram::ToJson() const {
@@ -324,22 +516,50 @@ nlohmann::json ShaderProgram::ToJson() const {
 }
 
 ShaderProgram::Sptr ShaderProgram::FromJson(const nlohmann::json& data) {
-	ShaderProgram::Sptr result = std::make_shared<ShaderProgram>();
-	result->SetDebugName(JsonGet(data, "name", result->_debugName));
+	return FromJson(data, PrepareFromJson(data));
+}
+
+std::shared_ptr<ShaderProgram::PreparedData> ShaderProgram::PrepareFromJson(const nlohmann::json& data) {
+	std::shared_ptr<PreparedData> result = std::make_shared<PreparedData>();
 	for (auto& [key, blob] : data.items()) {
 		// Get the shader part type from the key
 		ShaderPartType type = ParseShaderPartType(key, ShaderPartType::Unknown);
 		// As long as the type is valid
 		if (type != ShaderPartType::Unknown) {
+			PreparedData::Part part;
+			part.Type = type;
 			// If it has a file, we load from file
 			if (blob.contains("path")) {
-				result->LoadShaderPartFromFile(blob["path"].get<std::string>().c_str(), type);
+				part.Path = blob["path"].get<std::string>();
+				if (!std::filesystem::exists(part.Path)) {
+					LOG_WARN("Could not open file at \"{}\"", part.Path);
+					continue;
+				}
+				part.Source = FileHelpers::ReadResolveIncludes(part.Path);
 			}
 			// Otherwise we see if there's a source and load that instead
 			else if (blob.contains("source")) {
-				result->LoadShaderPart(blob["source"].get<std::string>().c_str(), type);
+				part.Source = blob["source"].get<std::string>();
 			}
 			// Otherwise do nothing
+			else {
+				continue;
+			}
+			result->Parts.push_back(part);
+		}
+	}
+	return result;
+}
+
+ShaderProgram::Sptr ShaderProgram::FromJson(const nlohmann::json& data, const std::shared_ptr<PreparedData>& prepared) {
+	ShaderProgram::Sptr result = std::make_shared<ShaderProgram>();
+	result->SetDebugName(JsonGet(data, "name", result->_debugName));
+	for (const PreparedData::Part& part : prepared->Parts) {
+		result->LoadShaderPart(part.Source.c_str(), part.Type);
+		// Remember where the source came from, so we save the path rather than the resolved source
+		if (!part.Path.empty()) {
+			result->_fileSourceMap[part.Type].IsFilePath = true;
+			result->_fileSourceMap[part.Type].Source = part.Path;
 		}
 	}
 	result->Link();
@@ -347,8 +567,42 @@ ShaderProgram::Sptr ShaderProgram::FromJson(const nlohmann::json& data) {
 }
 
 void ShaderProgram::_Introspect() {
+	// Locations may have changed, so the handles need to be looked up again
+	_handleLocations.clear();
+	// Linking resets all uniforms, so whoever set them needs to do so again
+	_uniformOwner = 0;
 	_IntrospectUniforms();
 	_IntrospectUnifromBlocks();
+	_IntrospectAttributes();
+}
+
+void ShaderProgram::_IntrospectAttributes() {
+	_attributes.clear();
+
+	// Query the program for how many active vertex inputs we have
+	int numInputs = 0;
+	glGetProgramInterfaceiv(_rendererId, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES, &numInputs);
+
+	for (int ix = 0; ix < numInputs; ix++) {
+		// We only need the name and location of the input
+		static GLenum pNames[] ={
+			GL_NAME_LENGTH,
+			GL_LOCATION
+		};
+		int props[2];
+		glGetProgramResourceiv(_rendererId, GL_PROGRAM_INPUT, ix, 2, pNames, 2, NULL, props);
+
+		// Built-in inputs like gl_VertexID have no location, skip them
+		if (props[1] == -1)
+			continue;
+
+		std::string name;
+		name.resize(props[0] - 1);
+		glGetProgramResourceName(_rendererId, GL_PROGRAM_INPUT, ix, props[0], NULL, &name[0]);
+
+		LOG_TRACE("\tDetected a new vertex input: {} - {}", props[1], name);
+		_attributes[name] = props[1];
+	}
 }
 
 void ShaderProgram::_IntrospectUniforms() {
@@ -460,17 +714,21 @@ void ShaderProgram::_IntrospectUnifromBlocks() {
 				GL_NAME_LENGTH,
 				GL_TYPE,
 				GL_ARRAY_SIZE,
-				GL_OFFSET
+				GL_OFFSET,
+				GL_ARRAY_STRIDE,
+				GL_MATRIX_STRIDE
 			};
 			// Query data from the program
-			int props[4];
-			glGetProgramResourceiv(_rendererId, GL_UNIFORM, activeVars[v], 4, pNames, 4, NULL, props);
+			int props[6];
+			glGetProgramResourceiv(_rendererId, GL_UNIFORM, activeVars[v], 6, pNames, 6, NULL, props);
 
 			// Store properties into the UniformInfo
 			UniformInfo var = UniformInfo();
 			var.Type = FromGLShaderDataType(props[1]);
 			var.Location = props[3];
 			var.ArraySize = props[2];
+			var.ArrayStride = props[4];
+			var.MatrixStride = props[5];
 
 			// Get the uniform name
 			var.Name.resize(props[0] - 1);
@@ -501,6 +759,11 @@ void ShaderProgram::BindUniformBlockToSlot(const std::string& name, int uboSlot)
 	}
 }
 
+const ShaderProgram::UniformBlockInfo* ShaderProgram::FindUniformBlock(const std::string& name) const {
+	auto it = _uniformBlocks.find(name);
+	return it != _uniformBlocks.end() ? &it->second : nullptr;
+}
+
 bool ShaderProgram::FindUniform(const std::string& name, UniformInfo* out) {
 	for (auto& [key, uniform] : _uniforms) {
 		if (uniform.Name == name) {
@@ -519,5 +782,7 @@ GlResourceType ShaderProgram::GetResourceClass() const {
 
 void ShaderProgram::RegisterVaryings(const char* const* names, int numVaryings, bool interleaved /*= true*/)
 {
+	_varyings.assign(names, names + numVaryings);
+	_interleavedVaryings = interleaved;
 	glTransformFeedbackVaryings(_rendererId, numVaryings, names, interleaved ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS);
 }
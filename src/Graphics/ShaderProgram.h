@@ -11,6 +11,7 @@
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/GlEnums.h"
 #include "Graphics/IGraphicsResource.h"
+#include "Graphics/UniformHandle.h"
 
 /// <summary>
 /// This class will wrap around an OpenGL shader program
@@ -29,8 +30,12 @@ public:
 	struct UniformInfo {
 		ShaderDataType Type;
 		int            ArraySize;
+		// For uniforms in a block, this is the byte offset within the block
 		int            Location;
 		int            Binding;
+		// For uniforms in a block, the bytes between array elements and matrix columns
+		int            ArrayStride;
+		int            MatrixStride;
 		std::string    Name;
 
 		UniformInfo() :
@@ -38,6 +43,8 @@ public:
 			ArraySize(0),
 			Location(-1),
 			Binding(-1),
+			ArrayStride(0),
+			MatrixStride(0),
 			Name("") {}
 	};
 
@@ -71,6 +78,9 @@ public:
 
 	/// <summary>
 	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader)
+	/// 
+	/// Compilation is deferred until Link, so that programs that are in the binary cache never
+	/// need to be compiled. Compile errors will be logged by Link
 	/// </summary>
 	/// <param name="source">The source code of the shader to load</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
@@ -94,6 +104,9 @@ public:
 
 	/// <summary>
 	/// Links the vertex and fragment shader, and allows this shader program to be used
+	/// 
+	/// If the same sources and varyings have been linked before with the same driver, the
+	/// program will be loaded from the binary cache instead of being compiled
 	/// </summary>
 	/// <returns>True if the linking was successful, false if otherwise</returns>
 	bool Link();
@@ -109,6 +122,13 @@ public:
 
 	const std::unordered_map<std::string, UniformInfo>& GetUniforms() const { return _uniforms; }
 
+	/// <summary>
+	/// Gets the location of an active vertex input in this program
+	/// </summary>
+	/// <param name="name">The name of the vertex input, as it appears in the vertex shader</param>
+	/// <returns>The location of the input, or -1 if the program has no such active input</returns>
+	int GetAttributeLocation(const std::string& name) const;
+
 	// Inherited from IGraphicsResource
 
 	virtual GlResourceType GetResourceClass() const override;
@@ -118,6 +138,41 @@ public:
 	virtual nlohmann::json ToJson() const override;
 	static ShaderProgram::Sptr FromJson(const nlohmann::json& data);
 
+	/// <summary>
+	/// The sources for a program, read from disk by PrepareFromJson
+	/// </summary>
+	struct PreparedData {
+		struct Part {
+			ShaderPartType Type;
+			// The source with all #includes resolved
+			std::string    Source;
+			// The file the source was read from, or empty if it came from the JSON blob
+			std::string    Path;
+		};
+		std::vector<Part> Parts;
+	};
+	/// <summary>
+	/// Reads and resolves the includes of all the shader parts in a JSON blob. Does not touch the GL
+	/// context, so this is used by the ResourceManager to load programs on worker threads
+	/// </summary>
+	static std::shared_ptr<PreparedData> PrepareFromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Creates and links a program from a JSON blob, using sources that have already been read
+	/// with PrepareFromJson. Must be called from the main thread
+	/// </summary>
+	static ShaderProgram::Sptr FromJson(const nlohmann::json& data, const std::shared_ptr<PreparedData>& prepared);
+
+	/// <summary>
+	/// Sets the directory that linked program binaries are cached in, or an empty string
+	/// to disable the cache. Defaults to "shader_cache"
+	/// </summary>
+	/// <param name="path">The path of the directory to store program binaries in</param>
+	static void SetBinaryCacheDirectory(const std::string& path) { __binaryCacheDir = path; }
+	/// <summary>
+	/// Gets the directory that linked program binaries are cached in, empty if the cache is disabled
+	/// </summary>
+	static const std::string& GetBinaryCacheDirectory() { return __binaryCacheDir; }
+
 public:
 	bool FindUniform(const std::string& name, UniformInfo* out);
 
@@ -146,6 +201,39 @@ public:
 	/// <param name="transposed"True if matrices should be transposed</param>
 	void SetUniform(int location, ShaderDataType type, void* data, int count = 1, bool transposed = false);
 
+	/// <summary>
+	/// Gets the location of a uniform from an interned handle. After the first lookup for a handle,
+	/// this is an array access
+	/// </summary>
+	/// <param name="handle">The handle of the uniform to find</param>
+	/// <returns>The location of the uniform, or -1 if the program has no such uniform</returns>
+	int GetUniformLocation(const UniformHandle& handle);
+
+	template <typename T>
+	void SetUniform(const UniformHandle& handle, const T& value) {
+		int location = GetUniformLocation(handle);
+		if (location != -1) {
+			SetUniform(location, &value, 1);
+		}
+	}
+	template <typename T>
+	void SetUniform(const UniformHandle& handle, const T* values, int count = 1) {
+		int location = GetUniformLocation(handle);
+		if (location != -1) {
+			SetUniform(location, values, count);
+		}
+	}
+	template <typename T>
+	void SetUniformMatrix(const UniformHandle& handle, const T& value, bool transposed = false) {
+		int location = GetUniformLocation(handle);
+		if (location != -1) {
+			SetUniformMatrix(location, &value, 1, transposed);
+		}
+	}
+
+	// Setting uniforms by name is slower, since it needs to look up the name every time. Prefer
+	// the UniformHandle versions for anything that is set every frame
+
 	template <typename T>
 	void SetUniform(const std::string& name, const T& value) {
 		int location = __GetUniformLocation(name);
@@ -175,15 +263,44 @@ public:
 	}
 	
 	void BindUniformBlockToSlot(const std::string& name, int uboSlot);
+	/// <summary>
+	/// Gets info about a uniform block in this program, including the layout of its uniforms
+	/// </summary>
+	/// <param name="name">The name of the block, as declared in the shader</param>
+	/// <returns>The block info, or nullptr if the program has no such block</returns>
+	const UniformBlockInfo* FindUniformBlock(const std::string& name) const;
+
+	/// <summary>
+	/// Gets the ID of whatever last uploaded a full set of uniforms to this program (ex: a material's
+	/// sort ID), or 0 if nothing has. Uniform values are stored per program, so this lets materials
+	/// that share a program skip uploading values that are already set
+	/// </summary>
+	uint32_t GetUniformOwner() const { return _uniformOwner; }
+	/// <summary>
+	/// Sets the ID of whatever last uploaded a full set of uniforms to this program, see GetUniformOwner
+	/// </summary>
+	void SetUniformOwner(uint32_t owner) { _uniformOwner = owner; }
 
 protected:
 	// Stores all the handles to our shaders until we
 	// are ready to compile them into a program
 	std::unordered_map<ShaderPartType, int> _handles;
+	// Sources (with includes resolved) that have been loaded but not yet compiled
+	std::unordered_map<ShaderPartType, std::string> _pendingSources;
+
+	// The transform feedback varyings registered for this program, these are part of the cache key
+	std::vector<std::string> _varyings;
+	bool                     _interleavedVaryings;
 	
 	// Map access to look up uniform locations and blocks
 	std::unordered_map<std::string, UniformInfo> _uniforms;
 	std::unordered_map<std::string, UniformBlockInfo> _uniformBlocks;
+	// Maps active vertex inputs to their locations
+	std::unordered_map<std::string, int> _attributes;
+	// Uniform locations indexed by UniformHandle ID, filled in as handles are used
+	std::vector<int> _handleLocations;
+	// See GetUniformOwner
+	uint32_t _uniformOwner;
 
 	// Stores information about the source of our shader parts
 	// EX: if a VS shader is loaded from a file, will contain
@@ -208,6 +325,49 @@ protected:
 	/// fed data from a uniform buffer
 	/// </summary>
 	void _IntrospectUnifromBlocks();
+	/// <summary>
+	/// Introspects the vertex inputs (attributes) for the program
+	/// </summary>
+	void _IntrospectAttributes();
 
 	int __GetUniformLocation(const std::string& name);
+
+	/// <summary>
+	/// Compiles a shader stage and stores its handle to be attached when linking
+	/// </summary>
+	/// <returns>True if the shader compiled</returns>
+	bool _CompileShaderPart(const std::string& source, ShaderPartType type);
+
+	/// <summary>
+	/// Calculates the key for this program in the binary cache, which is a hash of the pending
+	/// sources, the varyings, and the driver's vendor, renderer and version
+	/// </summary>
+	uint64_t _CalculateCacheKey() const;
+	/// <summary>
+	/// Tries to load this program from the binary cache. Entries that are corrupt, or that the
+	/// driver rejects (for instance after a driver update) are deleted
+	/// </summary>
+	/// <returns>True if the program was loaded and linked successfully</returns>
+	bool _LoadFromBinaryCache(uint64_t key);
+	/// <summary>
+	/// Stores the binary of this program in the cache, should only be called after a successful link
+	/// </summary>
+	void _StoreInBinaryCache(uint64_t key);
+
+	// Stored at the start of each file in the binary cache
+	struct BinaryCacheHeader {
+		char     Magic[4] = { 'S', 'B', 'I', 'N' };
+		// Should be incremented if this header changes
+		uint32_t Version = 1;
+		// Must match the key of the program, in case of hash collisions on the file name
+		uint64_t Key = 0;
+		// The binary format returned by glGetProgramBinary
+		uint32_t Format = 0;
+		// The size of the program binary that follows the header, in bytes
+		uint32_t Size = 0;
+		// A hash of the program binary, used to detect corrupt files
+		uint64_t Checksum = 0;
+	};
+
+	inline static std::string __binaryCacheDir = "shader_cache";
 };
\ No newline at end of file
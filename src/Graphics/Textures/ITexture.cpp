@@ -1,4 +1,5 @@
 #include "ITexture.h"
+#include "TextureUploader.h"
 
 ITexture::Limits ITexture::__limits = ITexture::Limits();
 bool ITexture::__isStaticInit = false;
@@ -20,6 +21,8 @@ void ITexture::_Recreate()
 }
 
 ITexture::~ITexture() {
+	// Make sure the uploader doesn't try to write to this texture after it's gone
+	TextureUploader::Cancel(this);
 	if (glIsTexture(_rendererId)) {
 		glDeleteTextures(1, &_rendererId);
 		_rendererId = 0;
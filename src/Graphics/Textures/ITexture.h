@@ -48,6 +48,11 @@ public:
 	/// <param name="color">The color to clear to</param>
 	void Clear(const glm::vec4& color);
 
+	/// <summary>
+	/// Gets the OpenGL texture target for this texture, ex: 2D, 3D, Cubemap
+	/// </summary>
+	TextureType GetType() const { return _type; }
+
 	// Inherited from IGraphicsResource
 
 	virtual GlResourceType GetResourceClass() const override;
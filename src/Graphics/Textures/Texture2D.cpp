@@ -4,6 +4,15 @@
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/Base64.h"
+#include "Utils/ThreadPool.h"
+#include "TextureUploader.h"
+#include "TextureArrayPool.h"
+#include "Utils/StringUtils.h"
+
+#include <algorithm>
+#include <filesystem>
+
+std::vector<Texture2D*> Texture2D::__pendingLoads;
 
 /// <summary>
 /// Get the number of mipmap levels required for a texture of the given size
@@ -27,6 +36,7 @@ nlohmann::json Texture2D::ToJson() const {
 
 	if (!_description.Filename.empty()) {
 		result["filename"] = _description.Filename;
+		result["compression"] = ~_description.Compression;
 	}
 	else if (_pixelType != PixelType::Unknown) {
 		result["size_x"] = _description.Width;
@@ -55,6 +65,7 @@ Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
 	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	descr.MaxAnisotropic      = JsonGet(data, "anisotropic", 0.0f);
 	descr.GenerateMipMaps     = JsonGet(data, "generate_mipmaps", false);
+	descr.Compression         = JsonParseEnum(TextureCompression, data, "compression", TextureCompression::Auto);
 
 	Texture2D::Sptr result = std::make_shared<Texture2D>(descr);
 
@@ -76,7 +87,10 @@ Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
 Texture2D::Texture2D(const Texture2DDescription& description) : 
 	ITexture(TextureType::_2D),
 	_description(description),
-	_pixelType(PixelType::Unknown)
+	_pixelType(PixelType::Unknown),
+	_pendingLoad(),
+	_isPlaceholder(false),
+	_isCooked(false)
 {
 	_SetTextureParams();
 	if (!description.Filename.empty()) {
@@ -87,17 +101,54 @@ Texture2D::Texture2D(const Texture2DDescription& description) :
 Texture2D::Texture2D(const std::string& filePath) : 
 	ITexture(TextureType::_2D),
 	_description(Texture2DDescription()),
-	_pixelType(PixelType::Unknown)
+	_pixelType(PixelType::Unknown),
+	_pendingLoad(),
+	_isPlaceholder(false),
+	_isCooked(false)
 {
 	_description.Filename = filePath;
 	_SetTextureParams();
 	_LoadDataFromFile();
 }
 
+Texture2D::~Texture2D() {
+	TextureArrayPool::Release(this);
+
+	// We can't cancel the decode, but we need to make sure the image gets freed
+	if (_pendingLoad.valid()) {
+		__pendingLoads.erase(std::remove(__pendingLoads.begin(), __pendingLoads.end(), this), __pendingLoads.end());
+		DecodedImage image = _pendingLoad.get();
+		if (image.Data != nullptr) {
+			stbi_image_free(image.Data);
+		}
+	}
+}
+
+void Texture2D::WaitForLoad() const {
+	if (_pendingLoad.valid()) {
+		// Finishing the load changes the texture, but to the caller it's as if the texture was always loaded
+		const_cast<Texture2D*>(this)->_FinishLoad();
+	}
+}
+
+void Texture2D::ProcessPendingLoads() {
+	for (size_t ix = 0; ix < __pendingLoads.size(); ) {
+		Texture2D* texture = __pendingLoads[ix];
+		// Finishing a load removes the texture from the list, so only advance if it's still loading
+		if (texture->_pendingLoad.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+			texture->_FinishLoad();
+		} else {
+			ix++;
+		}
+	}
+}
+
 void Texture2D::SetMinFilter(MinFilter value) {
 	if (_description.MultisampleCount == 1) {
 		_description.MinificationFilter = value;
 		glTextureParameteri(_rendererId, GL_TEXTURE_MIN_FILTER, *_description.MinificationFilter);
+		// Arrays are grouped by sampler settings, so we need to move to a different one
+		TextureArrayPool::Release(this);
 	}
 	else {
 		LOG_WARN("Attempted to set minification filter on a multisampled texture, ignoring");
@@ -108,6 +159,7 @@ void Texture2D::SetMagFilter(MagFilter value) {
 	if (_description.MultisampleCount == 1) {
 		_description.MagnificationFilter = value;
 		glTextureParameteri(_rendererId, GL_TEXTURE_MAG_FILTER, *_description.MagnificationFilter);
+		TextureArrayPool::Release(this);
 	} else {
 		LOG_WARN("Attempted to set magnification filter on a multisampled texture, ignoring");
 	}
@@ -117,14 +169,20 @@ void Texture2D::SetAnisoLevel(float value) {
 	if (value != _description.MaxAnisotropic) {
 		_description.MaxAnisotropic = glm::clamp(value, 1.0f, ITexture::GetLimits().MAX_ANISOTROPY);
 		glTextureParameterf(_rendererId, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
+		TextureArrayPool::Release(this);
 
-		if (_description.GenerateMipMaps) {
+		// Cooked textures come with their mips, and compressed formats can't regenerate them anyway
+		if (_description.GenerateMipMaps && !_isCooked) {
 			glGenerateTextureMipmap(_rendererId);
 		}
 	}
 }
 
 void Texture2D::LoadData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* data, uint32_t offsetX, uint32_t offsetY) {
+	// Make sure a background load or a queued upload doesn't overwrite this data later
+	WaitForLoad();
+	TextureUploader::Flush(this);
+
 	// Ensure the rectangle we're setting is within the bounds of the image
 	LOG_ASSERT((width + offsetX) <= _description.Width, "Pixel bounds are outside of the X extents of the image!");
 	LOG_ASSERT((height + offsetY) <= _description.Height, "Pixel bounds are outside of the Y extents of the image!");
@@ -144,59 +202,166 @@ void Texture2D::LoadData(uint32_t width, uint32_t height, PixelFormat format, Pi
 	if (_description.GenerateMipMaps) {
 		glGenerateTextureMipmap(_rendererId);
 	}
+
+	// If we're in a texture array, the copy in our layer needs to be updated
+	TextureArrayPool::Invalidate(this);
 }
 
 void Texture2D::_LoadDataFromFile() {
 	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
 	if (!_description.Filename.empty()) {
-		// Variables that will store properties about our image
-		int width, height, numChannels;
 		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
 
-		// Use STBI to load the image
+		// The flip flag is global to stbi, so we set it here rather than on the worker threads
 		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
 
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			LOG_WARN("STBI Failed to load image from \"{}\"", _description.Filename);
-			return ;
+		if (_description.LoadAsync) {
+			// Decode on the thread pool, and show a single white texel until the image is ready
+			std::string filename = _description.Filename;
+			TextureCompression compression = _description.Compression;
+			bool generateMips = _description.GenerateMipMaps;
+			_pendingLoad = ThreadPool::Get().Enqueue([filename, targetChannels, compression, generateMips]() {
+				return _DecodeImage(filename, targetChannels, compression, generateMips);
+			});
+			__pendingLoads.push_back(this);
+
+			static const uint8_t placeholder[4] = { 255, 255, 255, 255 };
+			glTextureStorage2D(_rendererId, 1, GL_RGBA8, 1, 1);
+			glTextureSubImage2D(_rendererId, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+			_isPlaceholder = true;
+		} else {
+			_UploadImage(_DecodeImage(_description.Filename, targetChannels, _description.Compression, _description.GenerateMipMaps), false);
 		}
+	}
+	
+	SetDebugName(_description.Filename);
+}
 
-		// We should estimate a good format for our data
+void Texture2D::_FinishLoad() {
+	DecodedImage image = _pendingLoad.get();
+	__pendingLoads.erase(std::remove(__pendingLoads.begin(), __pendingLoads.end(), this), __pendingLoads.end());
+	_UploadImage(image, true);
+}
+
+Texture2D::DecodedImage Texture2D::_DecodeImage(const std::string& filename, int targetChannels, TextureCompression compression, bool generateMips) {
+	DecodedImage result;
+	result.Data = nullptr;
 
-		// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
-		if (targetChannels != 0)
-			numChannels = targetChannels;
+	// Cooked files can be loaded directly, and with COOKED_TEXTURES images are swapped out for (or converted to) cooked files
+	std::string extension = std::filesystem::path(filename).extension().string();
+	StringTools::ToLower(extension);
+	if (extension == ".ctex") {
+		result.Cooked = TextureCooker::Load(filename);
+		return result;
+	}
+	#ifdef COOKED_TEXTURES
+	result.Cooked = TextureCooker::LoadOrCook({ filename }, TextureCooker::GetCookedPath(filename), compression, generateMips);
+	if (result.Cooked != nullptr) {
+		return result;
+	}
+	#endif
 
-		// We'll determine a recommended format for the image based on number of channels
-		// We hinted that we wanted a certain number of channels, but we're not guaranteed
-		// that all those channels exist (ex: loading an RGB image but requesting RGBA)
-		InternalFormat internal_format = GetInternalFormatForChannels8(numChannels);
-		PixelFormat    image_format = GetPixelFormatForChannels(numChannels);
+	result.Data = stbi_load(filename.c_str(), &result.Width, &result.Height, &result.NumChannels, targetChannels);
 
-		// This is one of those poorly documented things in OpenGL
-		if ((numChannels * width) % 4 != 0) {
-			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-		}
+	// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
+	if (targetChannels != 0) {
+		result.NumChannels = targetChannels;
+	}
+	return result;
+}
+
+void Texture2D::_UploadImage(const DecodedImage& image, bool stream) {
+	// If we could not load any data, warn and leave the texture as is
+	if (image.Data == nullptr && image.Cooked == nullptr) {
+		LOG_WARN("Failed to load image from \"{}\"", _description.Filename);
+		return;
+	}
+
+	// Texture storage is immutable, so we need a new texture object to replace the placeholder
+	if (_isPlaceholder) {
+		GLuint handle = 0;
+		glDeleteTextures(1, &_rendererId);
+		glCreateTextures(*_type, 1, &handle);
+		_SetRenderId(handle);
+		_isPlaceholder = false;
+	}
+
+	if (image.Cooked != nullptr) {
+		_UploadCooked(*image.Cooked);
+		return;
+	}
+
+	// We'll determine a recommended format for the image based on number of channels
+	// We hinted that we wanted a certain number of channels, but we're not guaranteed
+	// that all those channels exist (ex: loading an RGB image but requesting RGBA)
+	InternalFormat internal_format = GetInternalFormatForChannels8(image.NumChannels);
+	PixelFormat    image_format = GetPixelFormatForChannels(image.NumChannels);
+
+	// This is one of those poorly documented things in OpenGL
+	if ((image.NumChannels * image.Width) % 4 != 0) {
+		LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
+	}
+
+	// Update our description to match what we loaded
+	_description.Format = internal_format;
+	_description.Width = image.Width;
+	_description.Height = image.Height;
 
-		// Update our description to match what we loaded
-		_description.Format = internal_format;
-		_description.Width = width;
-		_description.Height = height;
+	// Allocates our memory
+	_SetTextureParams();
+
+	if (stream) {
+		_description.FormatHint = image_format;
+		_pixelType = PixelType::UByte;
 
-		// Allocates our memory
-		_SetTextureParams();
+		// Storage starts out undefined, so fill every level with white until the texels arrive
+		static const uint8_t white[4] = { 255, 255, 255, 255 };
+		int levels = _description.GenerateMipMaps ? CalcRequiredMipLevels(_description.Width, _description.Height) : 1;
+		for (int level = 0; level < levels; level++) {
+			glClearTexImage(_rendererId, level, GL_RGBA, GL_UNSIGNED_BYTE, white);
+		}
 
+		// The uploader frees the STBI data once it has all been copied to the staging buffer
+		TextureUpload upload;
+		upload.Texture = this;
+		upload.Width = image.Width;
+		upload.Height = image.Height;
+		upload.Format = image_format;
+		upload.Type = PixelType::UByte;
+		upload.Data = std::shared_ptr<uint8_t>(image.Data, stbi_image_free);
+		upload.GenerateMipMaps = _description.GenerateMipMaps;
+		TextureUploader::Enqueue(upload);
+	} else {
 		// Upload data to our texture
-		LoadData(width, height, image_format, PixelType::UByte, data);
+		LoadData(image.Width, image.Height, image_format, PixelType::UByte, image.Data);
 
 		// We now have data in the image, we can clear the STBI data
-		stbi_image_free(data);
+		stbi_image_free(image.Data);
+	}
+}
+
+void Texture2D::_UploadCooked(const CookedTexture& cooked) {
+	// The storage needs to match the levels in the file, the cooker makes the same number of levels that we would
+	_description.Format = cooked.GetInternalFormat();
+	_description.Width = cooked.Width;
+	_description.Height = cooked.Height;
+	_description.GenerateMipMaps = cooked.Levels.size() > 1;
+	_description.FormatHint = PixelFormat::RGBA;
+	_pixelType = PixelType::UByte;
+	_isCooked = true;
+
+	_SetTextureParams();
+
+	// The levels are already in their final format, so this is a straight copy with no decoding or mip generation
+	for (uint32_t level = 0; level < cooked.Levels.size(); level++) {
+		const CookedTexture::Level& info = cooked.Levels[level];
+		if (cooked.IsCompressed()) {
+			glCompressedTextureSubImage2D(_rendererId, level, 0, 0, info.Width, info.Height, *_description.Format, (GLsizei)info.FaceSize, cooked.GetLevelData(level));
+		} else {
+			glTextureSubImage2D(_rendererId, level, 0, 0, info.Width, info.Height, GL_RGBA, GL_UNSIGNED_BYTE, cooked.GetLevelData(level));
+		}
 	}
-	
-	SetDebugName(_description.Filename);
 }
 
 void Texture2D::_SetTextureParams() {
@@ -1,5 +1,9 @@
 #pragma once
 #include "ITexture.h"
+#include "TextureUploader.h"
+#include "Utils/TextureCooker.h"
+#include <future>
+#include <vector>
 
 /// <summary>
 /// Describes all parameters we can manipulate with our 2D Textures
@@ -60,6 +64,18 @@ struct Texture2DDescription {
 	/// </summary>
 	PixelFormat    FormatHint;
 
+	/// <summary>
+	/// True if the image file should be decoded on a worker thread, default true. The texture
+	/// will show a placeholder until the image is uploaded by Texture2D::ProcessPendingLoads
+	/// </summary>
+	bool           LoadAsync;
+
+	/// <summary>
+	/// The block compression to use when the image is cooked, default Auto. Only used when the
+	/// texture is loaded from a .ctex file or COOKED_TEXTURES is defined
+	/// </summary>
+	TextureCompression Compression;
+
 	Texture2DDescription() :
 		Width(0), Height(0),
 		Format(InternalFormat::Unknown),
@@ -71,7 +87,9 @@ struct Texture2DDescription {
 		GenerateMipMaps(true),
 		MultisampleCount(1),
 		Filename(""),
-		FormatHint(PixelFormat::RGBA)
+		FormatHint(PixelFormat::RGBA),
+		LoadAsync(true),
+		Compression(TextureCompression::Auto)
 	{ }
 };
 
@@ -80,7 +98,7 @@ public:
 	DEFINE_RESOURCE(Texture2D)
 
 	// Make sure we mark our destructor as virtual so base class is called
-	virtual ~Texture2D() = default;
+	virtual ~Texture2D();
 
 public:
 	Texture2D(const std::string& filePath);
@@ -89,15 +107,15 @@ public:
 	/// <summary>
 	/// Gets the internal format OpenGL is using for this texture
 	/// </summary>
-	InternalFormat GetFormat() const { return _description.Format; }
+	InternalFormat GetFormat() const { WaitForLoad(); return _description.Format; }
 	/// <summary>
 	/// Gets the width of this texture in pixels
 	/// </summary>
-	uint32_t GetWidth() const { return _description.Width; }
+	uint32_t GetWidth() const { WaitForLoad(); return _description.Width; }
 	/// <summary>
 	/// Gets the height of this texture in pixels
 	/// </summary>
-	uint32_t GetHeight() const { return _description.Height; }
+	uint32_t GetHeight() const { WaitForLoad(); return _description.Height; }
 	/// <summary>
 	/// Gets the sampler wrap mode along the x/s/u axis for this texture
 	/// </summary>
@@ -139,7 +157,24 @@ public:
 	/// Gets this texture's description, which contains basic information about the
 	/// texture's dimensions and creation parameters
 	/// </summary>
-	const Texture2DDescription& GetDescription() const { return _description; }
+	const Texture2DDescription& GetDescription() const { WaitForLoad(); return _description; }
+
+	/// <summary>
+	/// Returns true if this texture's image is still being decoded, or is still being streamed in by the TextureUploader
+	/// </summary>
+	bool IsLoading() const { return _pendingLoad.valid() || TextureUploader::IsPending(this); }
+	/// <summary>
+	/// Blocks until this texture's image has been decoded and it's storage allocated, does nothing if
+	/// the texture is not loading. The texels may still be streaming in afterwards. Must be called from
+	/// the main thread
+	/// </summary>
+	void WaitForLoad() const;
+
+	/// <summary>
+	/// Uploads the images for all textures that have finished decoding on the worker threads. Should
+	/// be called once per frame from the main thread
+	/// </summary>
+	static void ProcessPendingLoads();
 
 	virtual nlohmann::json ToJson() const override;
 	static Texture2D::Sptr FromJson(const nlohmann::json& data);
@@ -148,16 +183,57 @@ protected:
 	Texture2DDescription _description;
 	PixelType _pixelType;
 
+	// The result of decoding an image file with stbi, or of loading a cooked texture
+	struct DecodedImage {
+		uint8_t* Data;
+		int      Width;
+		int      Height;
+		int      NumChannels;
+		// If set, the texture was loaded from a .ctex file and Data is null
+		CookedTexture::Sptr Cooked;
+	};
+	// Will contain the decoded image while loading in the background
+	std::future<DecodedImage> _pendingLoad;
+	// True if the texture is currently a placeholder, and needs a new texture object for the real image
+	bool _isPlaceholder;
+	// True if the texture was loaded from a cooked file, which already contains all the mip levels
+	bool _isCooked;
+
+	// All the textures that are waiting on their images, only accessed from the main thread
+	static std::vector<Texture2D*> __pendingLoads;
+
 	/// <summary>
 	/// Loads this texture from the file specified in the description
 	/// Will overwrite description size
 	/// </summary>
 	void _LoadDataFromFile();
 	/// <summary>
+	/// Takes the result of a background load and uploads it to the texture
+	/// </summary>
+	void _FinishLoad();
+	/// <summary>
+	/// Uploads a decoded image to this texture, allocating the texture's storage and taking ownership of the image
+	/// </summary>
+	/// <param name="image">The image to upload</param>
+	/// <param name="stream">True to stream the texels in over the next few frames with the TextureUploader, false to upload them right away</param>
+	void _UploadImage(const DecodedImage& image, bool stream);
+	/// <summary>
+	/// Uploads every level of a cooked texture, allocating the texture's storage
+	/// </summary>
+	void _UploadCooked(const CookedTexture& cooked);
+	/// <summary>
+	/// Loads an image from disk, either with stbi or from it's cooked version. This is safe to call from worker threads
+	/// </summary>
+	static DecodedImage _DecodeImage(const std::string& filename, int targetChannels, TextureCompression compression, bool generateMips);
+	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
 	void _SetTextureParams();
 
 public:
+	/// <summary>
+	/// Creates a texture from an image file. Unless description.LoadAsync is false, the texture is
+	/// returned right away with a placeholder, and the image is decoded on the thread pool
+	/// </summary>
 	static Texture2D::Sptr LoadFromFile(const std::string& path, const Texture2DDescription& description = Texture2DDescription(), bool forceRgba = true);
 };
@@ -1,4 +1,5 @@
 #include "Texture3D.h"
+#include "TextureUploader.h"
 #include "Utils/Base64.h"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/StringUtils.h"
@@ -48,6 +49,9 @@ void Texture3D::LoadData(uint32_t width, uint32_t height, uint32_t depth, PixelF
 {
 	LOG_ASSERT(((width + offsetX) <= _description.Width) && ((height + offsetY) <= _description.Height) && ((depth + offsetZ) <= _description.Depth), "Pixel bounds are outside of the extents of the image!");
 
+	// Make sure a queued upload doesn't overwrite this data later
+	TextureUploader::Flush(this);
+
 	_description.FormatHint = format;
 	_pixelType = type;
 
@@ -255,11 +259,21 @@ void Texture3D::_LoadCubeFile()
 
 		// Allocate data and configure params
 		_SetTextureParams();
-		// Load data
-		LoadData(lutSize, lutSize, lutSize, PixelFormat::RGB, PixelType::UByte, textureData);
 
-		// Clean up after ourselves
-		delete[] textureData;
+		_description.FormatHint = PixelFormat::RGB;
+		_pixelType = PixelType::UByte;
+
+		// Stream the LUT in slice by slice, the uploader will clean up the texel data once it's done
+		TextureUpload upload;
+		upload.Texture = this;
+		upload.Width = upload.Height = upload.Depth = lutSize;
+		upload.Format = PixelFormat::RGB;
+		upload.Type = PixelType::UByte;
+		upload.Data = std::shared_ptr<uint8_t>(reinterpret_cast<uint8_t*>(textureData), [](uint8_t* data) {
+			delete[] reinterpret_cast<glm::u8vec3*>(data);
+		});
+		upload.GenerateMipMaps = _description.GenerateMipMaps;
+		TextureUploader::Enqueue(upload);
 	}
 	else {
 		LOG_WARN("Failed to load cube file: \"{}\"", _description.Filename);
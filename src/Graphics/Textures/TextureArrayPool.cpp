@@ -0,0 +1,185 @@
+#include "TextureArrayPool.h"
+#include "Texture2D.h"
+#include "Logging.h"
+
+#include <algorithm>
+
+bool TextureArrayPool::TryGetLayer(Texture2D* texture, TextureArrayLayer& out) {
+	// The texel data needs to be in place before we can copy it
+	if (texture == nullptr || texture->IsLoading()) {
+		return false;
+	}
+
+	auto it = __entries.find(texture);
+	if (it == __entries.end()) {
+		const Texture2DDescription& description = texture->GetDescription();
+		if (description.MultisampleCount > 1 || description.Width * description.Height == 0 || description.Format == InternalFormat::Unknown) {
+			return false;
+		}
+
+		// Storage is immutable, so the texture can tell us how many levels it was allocated with
+		GLint levels = 1;
+		glGetTextureParameteriv(texture->GetHandle(), GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+
+		// Find an array with a free layer that can hold the texture, growing or creating one if needed
+		uint32_t arrayIndex = static_cast<uint32_t>(__arrays.size());
+		uint32_t layer = 0;
+		for (uint32_t ix = 0; ix < __arrays.size(); ix++) {
+			TextureArray& array = __arrays[ix];
+			if (!_IsCompatible(array, texture, levels)) {
+				continue;
+			}
+			auto freeLayer = std::find(array.Layers.begin(), array.Layers.end(), nullptr);
+			if (freeLayer != array.Layers.end()) {
+				arrayIndex = ix;
+				layer = static_cast<uint32_t>(freeLayer - array.Layers.begin());
+				break;
+			}
+			size_t capacity = array.Layers.size();
+			if (_Grow(array)) {
+				arrayIndex = ix;
+				layer = static_cast<uint32_t>(capacity);
+				break;
+			}
+		}
+
+		if (arrayIndex == __arrays.size()) {
+			TextureArray array;
+			array.Width               = description.Width;
+			array.Height              = description.Height;
+			array.Levels              = static_cast<uint32_t>(levels);
+			array.Format              = description.Format;
+			array.MinificationFilter  = description.MinificationFilter;
+			array.MagnificationFilter = description.MagnificationFilter;
+			array.HorizontalWrap      = description.HorizontalWrap;
+			array.VerticalWrap        = description.VerticalWrap;
+			array.MaxAnisotropic      = description.MaxAnisotropic;
+			array.Layers.resize(INITIAL_CAPACITY, nullptr);
+			array.Handle = _CreateStorage(array, INITIAL_CAPACITY);
+			__arrays.push_back(array);
+		}
+
+		__arrays[arrayIndex].Layers[layer] = texture;
+
+		Entry entry;
+		entry.ArrayIndex = arrayIndex;
+		entry.Layer = layer;
+		entry.Dirty = true;
+		it = __entries.emplace(texture, entry).first;
+		__generation++;
+	}
+
+	Entry& entry = it->second;
+	const TextureArray& array = __arrays[entry.ArrayIndex];
+	if (entry.Dirty) {
+		_CopyLayer(array, entry.Layer, texture);
+		entry.Dirty = false;
+	}
+
+	out.Handle  = array.Handle;
+	out.ArrayId = entry.ArrayIndex;
+	out.Layer   = entry.Layer;
+	return true;
+}
+
+GLuint TextureArrayPool::GetFallbackHandle() {
+	if (__fallback == 0) {
+		static const uint8_t white[4] = { 255, 255, 255, 255 };
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &__fallback);
+		glTextureStorage3D(__fallback, 1, GL_RGBA8, 1, 1, 1);
+		glTextureSubImage3D(__fallback, 0, 0, 0, 0, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+	}
+	return __fallback;
+}
+
+void TextureArrayPool::Invalidate(const Texture2D* texture) {
+	auto it = __entries.find(texture);
+	if (it != __entries.end()) {
+		it->second.Dirty = true;
+		__generation++;
+	}
+}
+
+void TextureArrayPool::Release(const Texture2D* texture) {
+	auto it = __entries.find(texture);
+	if (it != __entries.end()) {
+		__arrays[it->second.ArrayIndex].Layers[it->second.Layer] = nullptr;
+		__entries.erase(it);
+		__generation++;
+	}
+}
+
+void TextureArrayPool::Uninitialize() {
+	for (const TextureArray& array : __arrays) {
+		glDeleteTextures(1, &array.Handle);
+	}
+	if (__fallback != 0) {
+		glDeleteTextures(1, &__fallback);
+		__fallback = 0;
+	}
+	__arrays.clear();
+	__entries.clear();
+	__generation++;
+}
+
+bool TextureArrayPool::_IsCompatible(const TextureArray& array, const Texture2D* texture, uint32_t levels) {
+	const Texture2DDescription& description = texture->GetDescription();
+	return
+		array.Width               == description.Width &&
+		array.Height              == description.Height &&
+		array.Levels              == levels &&
+		array.Format              == description.Format &&
+		array.MinificationFilter  == description.MinificationFilter &&
+		array.MagnificationFilter == description.MagnificationFilter &&
+		array.HorizontalWrap      == description.HorizontalWrap &&
+		array.VerticalWrap        == description.VerticalWrap &&
+		array.MaxAnisotropic      == description.MaxAnisotropic;
+}
+
+GLuint TextureArrayPool::_CreateStorage(const TextureArray& array, uint32_t capacity) {
+	GLuint handle = 0;
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &handle);
+	glTextureStorage3D(handle, array.Levels, *array.Format, array.Width, array.Height, capacity);
+
+	// The sampler settings are part of the array, which is why they need to match for textures to share one
+	glTextureParameteri(handle, GL_TEXTURE_MIN_FILTER, *array.MinificationFilter);
+	glTextureParameteri(handle, GL_TEXTURE_MAG_FILTER, *array.MagnificationFilter);
+	glTextureParameteri(handle, GL_TEXTURE_WRAP_S, *array.HorizontalWrap);
+	glTextureParameteri(handle, GL_TEXTURE_WRAP_T, *array.VerticalWrap);
+	glTextureParameterf(handle, GL_TEXTURE_MAX_ANISOTROPY, array.MaxAnisotropic);
+	return handle;
+}
+
+bool TextureArrayPool::_Grow(TextureArray& array) {
+	GLint maxLayers = 256;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+	uint32_t capacity = static_cast<uint32_t>(array.Layers.size());
+	uint32_t newCapacity = std::min(capacity * 2, static_cast<uint32_t>(maxLayers));
+	if (newCapacity <= capacity) {
+		return false;
+	}
+	LOG_INFO("Expanding {}x{} texture array from {} layers to {}", array.Width, array.Height, capacity, newCapacity);
+
+	// Array storage is immutable too, so the existing layers are copied over on the GPU
+	GLuint handle = _CreateStorage(array, newCapacity);
+	for (uint32_t level = 0; level < array.Levels; level++) {
+		GLsizei width  = std::max(1u, array.Width >> level);
+		GLsizei height = std::max(1u, array.Height >> level);
+		glCopyImageSubData(array.Handle, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, handle, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, capacity);
+	}
+	glDeleteTextures(1, &array.Handle);
+
+	array.Handle = handle;
+	array.Layers.resize(newCapacity, nullptr);
+	return true;
+}
+
+void TextureArrayPool::_CopyLayer(const TextureArray& array, uint32_t layer, const Texture2D* texture) {
+	// Copies are done a whole level at a time, which also satisfies the block alignment rules for compressed formats
+	for (uint32_t level = 0; level < array.Levels; level++) {
+		GLsizei width  = std::max(1u, array.Width >> level);
+		GLsizei height = std::max(1u, array.Height >> level);
+		glCopyImageSubData(texture->GetHandle(), GL_TEXTURE_2D, level, 0, 0, 0, array.Handle, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1);
+	}
+}
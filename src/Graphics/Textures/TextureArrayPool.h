@@ -0,0 +1,137 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glad/glad.h>
+
+#include "Graphics/GlEnums.h"
+
+class Texture2D;
+
+/// <summary>
+/// Describes where a texture lives in the TextureArrayPool
+/// </summary>
+struct TextureArrayLayer {
+	/// <summary>
+	/// The GL_TEXTURE_2D_ARRAY holding the texture. This changes if the array has to grow, so it
+	/// should be looked up again rather than stored
+	/// </summary>
+	GLuint   Handle;
+	/// <summary>
+	/// Identifies the array the texture is in, this stays the same for as long as the pool exists
+	/// </summary>
+	uint32_t ArrayId;
+	/// <summary>
+	/// The layer of the array the texture was copied into
+	/// </summary>
+	uint32_t Layer;
+};
+
+/// <summary>
+/// Groups Texture2Ds with the same size, format, mip count and sampler settings into shared
+/// GL_TEXTURE_2D_ARRAYs, so that shaders can select a texture with a layer index instead of
+/// needing it bound to it's own texture unit. Materials use this for sampler2DArray parameters,
+/// which lets objects whose materials only differ by texture be drawn in a single batch.
+///
+/// Textures are copied into their layer on the GPU with glCopyImageSubData the first time they
+/// are requested after they have finished loading, and again after their contents are changed
+/// with LoadData. Textures that are rendered to should not be used with the pool, since it can't
+/// tell when their contents change
+/// </summary>
+class TextureArrayPool {
+public:
+	TextureArrayPool() = delete;
+
+	// The number of layers a new array is created with, arrays double in size when they fill up
+	static const uint32_t INITIAL_CAPACITY = 4;
+	// An array ID that will never be given to a real array
+	static const uint32_t INVALID_ARRAY_ID = 0xFFFFFFFF;
+
+	/// <summary>
+	/// Gets the layer holding a texture, adding the texture to the pool if it is not in it yet.
+	/// Must be called from the main thread
+	/// </summary>
+	/// <param name="texture">The texture to look up</param>
+	/// <param name="out">Receives the texture's array and layer</param>
+	/// <returns>False if the texture is still loading, or can't be stored in an array (ex: multisampled)</returns>
+	static bool TryGetLayer(Texture2D* texture, TextureArrayLayer& out);
+
+	/// <summary>
+	/// Gets a 1 layer array holding a single white texel, to bind in place of textures that
+	/// are not in the pool yet
+	/// </summary>
+	static GLuint GetFallbackHandle();
+
+	/// <summary>
+	/// Marks a texture's layer as out of date, so it is copied again the next time it is requested
+	/// </summary>
+	static void Invalidate(const Texture2D* texture);
+	/// <summary>
+	/// Frees the layer holding a texture, called when textures are destroyed
+	/// </summary>
+	static void Release(const Texture2D* texture);
+
+	/// <summary>
+	/// Gets a counter that is incremented whenever a texture is added to, removed from or updated in
+	/// the pool. Anything caching layers or array handles should look them up again when this changes
+	/// </summary>
+	static uint32_t GetGeneration() { return __generation; }
+	/// <summary>
+	/// Gets the number of arrays, and the number of textures stored in them
+	/// </summary>
+	static size_t GetArrayCount() { return __arrays.size(); }
+	static size_t GetTextureCount() { return __entries.size(); }
+
+	/// <summary>
+	/// Deletes all the arrays, should be called while the GL context still exists
+	/// </summary>
+	static void Uninitialize();
+
+protected:
+	// A single GL_TEXTURE_2D_ARRAY, and the textures stored in it's layers
+	struct TextureArray {
+		GLuint         Handle;
+		uint32_t       Width;
+		uint32_t       Height;
+		uint32_t       Levels;
+		InternalFormat Format;
+		MinFilter      MinificationFilter;
+		MagFilter      MagnificationFilter;
+		WrapMode       HorizontalWrap;
+		WrapMode       VerticalWrap;
+		float          MaxAnisotropic;
+		// The texture in each layer, or nullptr for free layers. The size is the array's capacity
+		std::vector<const Texture2D*> Layers;
+	};
+
+	// Where a texture is stored in the pool
+	struct Entry {
+		uint32_t ArrayIndex;
+		uint32_t Layer;
+		// True if the texture has changed since it was copied into it's layer
+		bool     Dirty;
+	};
+
+	inline static std::vector<TextureArray>                   __arrays;
+	inline static std::unordered_map<const Texture2D*, Entry> __entries;
+	inline static GLuint                                      __fallback = 0;
+	inline static uint32_t                                    __generation = 0;
+
+	/// <summary>
+	/// Returns true if a texture can be stored in the given array
+	/// </summary>
+	static bool _IsCompatible(const TextureArray& array, const Texture2D* texture, uint32_t levels);
+	/// <summary>
+	/// Allocates the storage for an array and applies it's sampler settings
+	/// </summary>
+	static GLuint _CreateStorage(const TextureArray& array, uint32_t capacity);
+	/// <summary>
+	/// Doubles the number of layers in an array, copying the existing layers into the new storage
+	/// </summary>
+	/// <returns>False if the array is already at the maximum number of layers</returns>
+	static bool _Grow(TextureArray& array);
+	/// <summary>
+	/// Copies every mip level of a texture into a layer of an array
+	/// </summary>
+	static void _CopyLayer(const TextureArray& array, uint32_t layer, const Texture2D* texture);
+};
@@ -2,6 +2,8 @@
 #include <filesystem>
 #include "stb_image.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/StringUtils.h"
 
 TextureCube::TextureCube(const std::string& baseFilename) :
 	ITexture(TextureType::Cubemap),
@@ -31,6 +33,7 @@ nlohmann::json TextureCube::ToJson() const
 	nlohmann::json result;
 	result["filter_min"] = ~_description.MinificationFilter;
 	result["filter_mag"] = ~_description.MagnificationFilter;
+	result["compression"] = ~_description.Compression;
 	
 	if (!_description.FaceFileNames.empty()) {
 		result["face_filenames"] = nlohmann::json();
@@ -50,6 +53,7 @@ TextureCube::Sptr TextureCube::FromJson(const nlohmann::json& data)
 	descr.MinificationFilter  = JsonParseEnum(MinFilter, data, "filter_min", MinFilter::NearestMipNearest);
 	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	descr.Filename       = JsonGet<std::string>(data, "base_filename", "");
+	descr.Compression    = JsonParseEnum(TextureCompression, data, "compression", TextureCompression::Auto);
 	if (data.contains("face_filenames") && data["face_filenames"].is_object()) {
 		for (auto& [key, value] : data["face_filenames"].items()) {
 			CubeMapFace face = ParseCubeMapFace(key, CubeMapFace::Unknown);
@@ -63,6 +67,21 @@ TextureCube::Sptr TextureCube::FromJson(const nlohmann::json& data)
 
 void TextureCube::_LoadFromDescription()
 {
+	// A cooked cubemap has all 6 faces in the one file
+	if (_description.FaceFileNames.empty() && !_description.Filename.empty()) {
+		std::string extension = std::filesystem::path(_description.Filename).extension().string();
+		StringTools::ToLower(extension);
+		if (extension == ".ctex") {
+			CookedTexture::Sptr cooked = TextureCooker::Load(_description.Filename);
+			if (cooked != nullptr && cooked->Faces == 6 && cooked->Width == cooked->Height) {
+				_UploadCooked(*cooked);
+			} else {
+				LOG_ERROR("\"{}\" is not a valid cooked cubemap, aborting load", _description.Filename);
+			}
+			return;
+		}
+	}
+
 	// If we weren't passed face filenames but WERE passed a base filename, try and get the 6 face files
 	if (_description.FaceFileNames.empty() && !_description.Filename.empty()) {
 		// Get the file path and it's directory to extract the root file name w/o extension
@@ -100,6 +119,20 @@ void TextureCube::_LoadFromDescription()
 
 void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames)
 {
+	#ifdef COOKED_TEXTURES
+	// The cooked file sits next to the first face, and holds all 6 faces
+	std::vector<std::string> sources;
+	for (int ix = 0; ix < 6; ix++) {
+		sources.push_back(faceFilenames.at((CubeMapFace)ix));
+	}
+	stbi_set_flip_vertically_on_load(true);
+	CookedTexture::Sptr cooked = TextureCooker::LoadOrCook(sources, TextureCooker::GetCookedPath(sources[0], true), _description.Compression, false);
+	if (cooked != nullptr && cooked->Width == cooked->Height) {
+		_UploadCooked(*cooked);
+		return;
+	}
+	#endif
+
 	// Will store all of our texture data, back to back in memory
 	uint8_t* datastore = nullptr;
 	// The size of a single face's texture, in bytes
@@ -108,28 +141,49 @@ void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>
 	// The number of channels that we're expecting
 	int numChannels = 0;
 
-	// Load all 6 faces
+	// Decode all 6 faces at once on the thread pool, the flip flag is global to stbi so set it beforehand
+	struct FaceImage {
+		uint8_t* Data;
+		int      Width;
+		int      Height;
+		int      NumChannels;
+	};
+	FaceImage faces[6];
+	stbi_set_flip_vertically_on_load(true);
+	ThreadPool::Get().ParallelFor(6, [&](size_t ix) {
+		FaceImage& image = faces[ix];
+		image.Data = stbi_load(faceFilenames.at((CubeMapFace)ix).c_str(), &image.Width, &image.Height, &image.NumChannels, 0);
+	});
+
+	// Frees any faces we haven't copied into the data store yet, for when we need to abort
+	auto freeFaces = [&](int first) {
+		for (int iy = first; iy < 6; iy++) {
+			if (faces[iy].Data != nullptr) {
+				stbi_image_free(faces[iy].Data);
+			}
+		}
+	};
+
+	// Validate the faces and pack them into the data store
 	for (int ix = 0; ix < 6; ix++) {
 		CubeMapFace face = (CubeMapFace)ix;
 		
-		const std::string& filename = _description.FaceFileNames[face];
-		int fileWidth, fileHeight, fileNumChannels;
-
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(filename.c_str(), &fileWidth, &fileHeight, &fileNumChannels, 0);
+		const std::string& filename = faceFilenames.at(face);
+		uint8_t* data = faces[ix].Data;
+		int fileWidth = faces[ix].Width, fileHeight = faces[ix].Height, fileNumChannels = faces[ix].NumChannels;
 
 		// If we could not load any data, warn and return null
 		if (data == nullptr) {
-			if (data != nullptr) { delete[] datastore; }
+			delete[] datastore;
+			freeFaces(ix + 1);
 			LOG_ERROR("STBI Failed to load image from \"{}\"", filename);
 			return;
 		}
 		// If the texture is not square, warn and abort
 		if (fileWidth != fileHeight) {
-			if (data != nullptr) { delete[] datastore; }
+			delete[] datastore;
+			freeFaces(ix);
 			LOG_ERROR("Image loaded from \"{}\" was not square", filename);
-			stbi_image_free(data);
 			return;
 		}
 		// If the dataStore is empty, this is the first texture we loaded
@@ -156,8 +210,8 @@ void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>
 		// If this is NOT the first image, and it does not match previous images, abort
 		else if (fileWidth != _description.Size || fileNumChannels != numChannels) {
 			delete[] datastore;
+			freeFaces(ix);
 			LOG_WARN("Image \"{}\" did not match size or format of texture cube", filename);
-			stbi_image_free(data);
 			return;
 		}
 
@@ -177,11 +231,29 @@ void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>
 	delete[] datastore;
 }
 
-void TextureCube::_SetTextureParams(){
+void TextureCube::_UploadCooked(const CookedTexture& cooked) {
+	_description.Size = cooked.Width;
+	_description.Format = cooked.GetInternalFormat();
+	_description.FormatHint = PixelFormat::RGBA;
+
+	_SetTextureParams(static_cast<int>(cooked.Levels.size()));
+
+	// Each level has it's 6 faces back to back, which is how DSA expects cubemap data
+	for (uint32_t level = 0; level < cooked.Levels.size(); level++) {
+		const CookedTexture::Level& info = cooked.Levels[level];
+		if (cooked.IsCompressed()) {
+			glCompressedTextureSubImage3D(_rendererId, level, 0, 0, 0, info.Width, info.Height, 6, *_description.Format, (GLsizei)(info.FaceSize * 6), cooked.GetLevelData(level));
+		} else {
+			glTextureSubImage3D(_rendererId, level, 0, 0, 0, info.Width, info.Height, 6, GL_RGBA, GL_UNSIGNED_BYTE, cooked.GetLevelData(level));
+		}
+	}
+}
+
+void TextureCube::_SetTextureParams(int levels){
 	// Make sure the size is greater than zero and that we have a format specified before trying to set parameters
 	if (_description.Size > 0 && _description.Format != InternalFormat::Unknown) {
 		// Allocates the memory for our texture
-		glTextureStorage2D(_rendererId, 1, (GLenum)_description.Format, _description.Size, _description.Size);
+		glTextureStorage2D(_rendererId, levels, (GLenum)_description.Format, _description.Size, _description.Size);
 
 		// Set up our texture parameters
 		glTextureParameteri(_rendererId, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
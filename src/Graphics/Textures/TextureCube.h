@@ -1,6 +1,7 @@
 #pragma once
 #include <EnumToString.h>
 #include "ITexture.h"
+#include "Utils/TextureCooker.h"
 
 /*
 0 	GL_TEXTURE_CUBE_MAP_POSITIVE_X
@@ -60,6 +61,12 @@ struct TextureCubeDescription {
 	/// </summary>
 	PixelFormat    FormatHint;
 
+	/// <summary>
+	/// The block compression to use when the faces are cooked, default Auto. Only used when
+	/// COOKED_TEXTURES is defined
+	/// </summary>
+	TextureCompression Compression;
+
 	/// <summary>
 	/// Creates a default (empty) cubemap description
 	/// </summary>
@@ -69,7 +76,8 @@ struct TextureCubeDescription {
 		MinificationFilter(MinFilter::NearestMipLinear),
 		MagnificationFilter(MagFilter::Linear),
 		Filename(""),
-		FormatHint(PixelFormat::RGBA)
+		FormatHint(PixelFormat::RGBA),
+		Compression(TextureCompression::Auto)
 	{ }
 };
 
@@ -116,9 +124,14 @@ protected:
 
 	virtual void _LoadFromDescription();
 	virtual void _LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames);
+	/// <summary>
+	/// Uploads every level of all 6 faces of a cooked texture, allocating the texture's storage
+	/// </summary>
+	void _UploadCooked(const CookedTexture& cooked);
 
 	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
-	void _SetTextureParams();
+	/// <param name="levels">The number of mip levels to allocate</param>
+	void _SetTextureParams(int levels = 1);
 };
\ No newline at end of file
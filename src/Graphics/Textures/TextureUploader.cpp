@@ -0,0 +1,149 @@
+#include "TextureUploader.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <cstring>
+
+void TextureUploader::Enqueue(const TextureUpload& upload) {
+	LOG_ASSERT(upload.Texture != nullptr, "Texture uploads need a target texture");
+	LOG_ASSERT(upload.Texture->GetType() == TextureType::_2D || upload.Texture->GetType() == TextureType::_3D, "Only 2D and 3D textures can be streamed");
+	LOG_ASSERT(upload.Data != nullptr, "Texture uploads need data to upload");
+
+	PendingUpload pending;
+	pending.Upload = upload;
+	uint32_t rowSize = static_cast<uint32_t>(GetTexelSize(upload.Format, upload.Type)) * upload.Width;
+	if (upload.Texture->GetType() == TextureType::_3D) {
+		pending.UnitSize = rowSize * upload.Height;
+		pending.UnitCount = upload.Depth;
+	} else {
+		pending.UnitSize = rowSize;
+		pending.UnitCount = upload.Height;
+	}
+	pending.NextUnit = 0;
+
+	if (pending.UnitSize * pending.UnitCount == 0) {
+		return;
+	}
+	__pendingBytes += (size_t)pending.UnitSize * pending.UnitCount;
+	__queue.push_back(pending);
+}
+
+void TextureUploader::Update() {
+	__bytesLastFrame = 0;
+	if (__queue.empty()) {
+		return;
+	}
+
+	if (__staging == nullptr) {
+		__staging = StreamingBuffer::Create(BufferType::PixelUnpack, __frameBudget);
+	}
+
+	// Make sure at least one unit of the oldest upload fits, even if it's bigger than the budget
+	uint32_t frameSize = std::max(__frameBudget, __staging->GetAlignedSize(__queue.front().UnitSize));
+	__staging->BeginFrame(frameSize);
+
+	// Rows are tightly packed in the staging buffer
+	GLint unpackAlignment = 4;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, __staging->GetHandle());
+
+	uint32_t remaining = frameSize;
+	while (!__queue.empty()) {
+		PendingUpload& pending = __queue.front();
+
+		uint32_t count = std::min(pending.UnitCount - pending.NextUnit, remaining / pending.UnitSize);
+		while (count > 0 && __staging->GetAlignedSize(count * pending.UnitSize) > remaining) {
+			count--;
+		}
+		if (count == 0) {
+			break;
+		}
+
+		uint32_t size = count * pending.UnitSize;
+		uint32_t offset = __staging->Allocate(size);
+		if (offset == StreamingBuffer::INVALID_OFFSET) {
+			break;
+		}
+		memcpy(__staging->GetPointer(offset), pending.Upload.Data.get() + (size_t)pending.NextUnit * pending.UnitSize, size);
+
+		// With a pixel unpack buffer bound, the data pointer is an offset into the buffer
+		_Issue(pending, count, reinterpret_cast<const void*>(static_cast<uintptr_t>(offset)));
+		remaining -= __staging->GetAlignedSize(size);
+		__bytesLastFrame += size;
+
+		if (pending.NextUnit == pending.UnitCount) {
+			__queue.pop_front();
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+	// The fence goes after the copies, so this part of the ring is free once they've completed
+	__staging->EndFrame();
+}
+
+void TextureUploader::Flush(const ITexture* texture) {
+	if (!IsPending(texture)) {
+		return;
+	}
+
+	GLint unpackAlignment = 4;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// Nothing is bound to the pixel unpack target outside of Update, so this reads from client memory
+	for (auto it = __queue.begin(); it != __queue.end(); ) {
+		if (it->Upload.Texture == texture) {
+			_Issue(*it, it->UnitCount - it->NextUnit, it->Upload.Data.get() + (size_t)it->NextUnit * it->UnitSize);
+			it = __queue.erase(it);
+		} else {
+			it++;
+		}
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+}
+
+void TextureUploader::Cancel(const ITexture* texture) {
+	for (auto it = __queue.begin(); it != __queue.end(); ) {
+		if (it->Upload.Texture == texture) {
+			__pendingBytes -= (size_t)(it->UnitCount - it->NextUnit) * it->UnitSize;
+			it = __queue.erase(it);
+		} else {
+			it++;
+		}
+	}
+}
+
+bool TextureUploader::IsPending(const ITexture* texture) {
+	return std::any_of(__queue.begin(), __queue.end(), [texture](const PendingUpload& pending) {
+		return pending.Upload.Texture == texture;
+	});
+}
+
+void TextureUploader::Uninitialize() {
+	__queue.clear();
+	__pendingBytes = 0;
+	__staging = nullptr;
+}
+
+void TextureUploader::_Issue(PendingUpload& pending, uint32_t count, const void* pixels) {
+	const TextureUpload& upload = pending.Upload;
+	GLuint handle = upload.Texture->GetHandle();
+
+	if (upload.Texture->GetType() == TextureType::_3D) {
+		glTextureSubImage3D(handle, 0, upload.OffsetX, upload.OffsetY, upload.OffsetZ + pending.NextUnit, upload.Width, upload.Height, count, *upload.Format, *upload.Type, pixels);
+	} else {
+		glTextureSubImage2D(handle, 0, upload.OffsetX, upload.OffsetY + pending.NextUnit, upload.Width, count, *upload.Format, *upload.Type, pixels);
+	}
+
+	pending.NextUnit += count;
+	__pendingBytes -= (size_t)count * pending.UnitSize;
+
+	// Mip maps are only generated once, after the last part of the image is in place
+	if (pending.NextUnit == pending.UnitCount && upload.GenerateMipMaps) {
+		glGenerateTextureMipmap(handle);
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <memory>
+#include <deque>
+#include <cstdint>
+
+#include "Graphics/Textures/ITexture.h"
+#include "Graphics/Buffers/StreamingBuffer.h"
+
+/// <summary>
+/// Describes a block of texels to copy into a 2D or 3D texture
+/// </summary>
+struct TextureUpload {
+	/// <summary>
+	/// The texture to upload to, it's handle is looked up when each part of the upload is issued
+	/// </summary>
+	ITexture*   Texture;
+	uint32_t    Width;
+	uint32_t    Height;
+	uint32_t    Depth;
+	uint32_t    OffsetX;
+	uint32_t    OffsetY;
+	uint32_t    OffsetZ;
+	PixelFormat Format;
+	PixelType   Type;
+	/// <summary>
+	/// The texels to upload, rows must be tightly packed. The uploader holds on to this until
+	/// the last part of the upload has been copied into the staging buffer
+	/// </summary>
+	std::shared_ptr<uint8_t> Data;
+	/// <summary>
+	/// True if mip maps should be generated once the whole upload has been issued
+	/// </summary>
+	bool        GenerateMipMaps;
+
+	TextureUpload() :
+		Texture(nullptr),
+		Width(0), Height(0), Depth(1),
+		OffsetX(0), OffsetY(0), OffsetZ(0),
+		Format(PixelFormat::RGBA),
+		Type(PixelType::UByte),
+		Data(nullptr),
+		GenerateMipMaps(false)
+	{ }
+};
+
+/// <summary>
+/// Streams texel data into textures through a persistently mapped ring of pixel unpack buffers.
+/// Uploads are queued with Enqueue, and once per frame Update copies as much of the queue as the
+/// frame budget allows into the ring and issues glTextureSubImage from there, so the driver never
+/// has to copy out of client memory on the main thread.
+///
+/// Uploads are split by rows (or by slices for 3D textures), so large images stream in over
+/// several frames instead of causing one long frame
+/// </summary>
+class TextureUploader {
+public:
+	TextureUploader() = delete;
+
+	// The number of bytes that will be uploaded each frame by default
+	static const uint32_t DEFAULT_FRAME_BUDGET = 4 * 1024 * 1024;
+
+	/// <summary>
+	/// Queues texels to be uploaded to a texture over the next few frames. Only 2D and 3D textures
+	/// are supported, and the texture's storage must already be allocated
+	/// </summary>
+	static void Enqueue(const TextureUpload& upload);
+
+	/// <summary>
+	/// Issues up to a frame budget's worth of queued uploads, should be called once per frame
+	/// from the main thread
+	/// </summary>
+	static void Update();
+
+	/// <summary>
+	/// Immediately issues everything that is still queued for a texture, ignoring the frame budget.
+	/// Used before writing to a texture directly, so that queued data can't overwrite it later
+	/// </summary>
+	static void Flush(const ITexture* texture);
+	/// <summary>
+	/// Drops everything that is still queued for a texture, called when textures are destroyed
+	/// </summary>
+	static void Cancel(const ITexture* texture);
+	/// <summary>
+	/// Returns true if the texture has data that has not been uploaded yet
+	/// </summary>
+	static bool IsPending(const ITexture* texture);
+
+	/// <summary>
+	/// Sets the maximum number of bytes to upload per frame. At least one row (or slice) of the
+	/// oldest upload is always issued, so uploads will make progress even with a tiny budget
+	/// </summary>
+	static void SetFrameBudget(uint32_t bytes) { __frameBudget = bytes; }
+	static uint32_t GetFrameBudget() { return __frameBudget; }
+	/// <summary>
+	/// Gets the number of bytes that are queued but have not been uploaded yet
+	/// </summary>
+	static size_t GetPendingBytes() { return __pendingBytes; }
+	/// <summary>
+	/// Gets the number of bytes that were uploaded by the last call to Update
+	/// </summary>
+	static uint32_t GetBytesLastFrame() { return __bytesLastFrame; }
+
+	/// <summary>
+	/// Releases the staging buffer and drops anything left in the queue
+	/// </summary>
+	static void Uninitialize();
+
+protected:
+	struct PendingUpload {
+		TextureUpload Upload;
+		// Units are rows for 2D textures, and slices for 3D textures
+		uint32_t      UnitSize;
+		uint32_t      UnitCount;
+		uint32_t      NextUnit;
+	};
+
+	inline static std::deque<PendingUpload> __queue;
+	inline static StreamingBuffer::Sptr     __staging = nullptr;
+	inline static uint32_t                  __frameBudget = DEFAULT_FRAME_BUDGET;
+	inline static uint32_t                  __bytesLastFrame = 0;
+	inline static size_t                    __pendingBytes = 0;
+
+	/// <summary>
+	/// Issues the texture upload for a range of units
+	/// </summary>
+	/// <param name="pending">The upload to issue part of</param>
+	/// <param name="count">The number of units to issue, starting at NextUnit</param>
+	/// <param name="pixels">An offset into the bound pixel unpack buffer, or a pointer to client memory if none is bound</param>
+	static void _Issue(PendingUpload& pending, uint32_t count, const void* pixels);
+};
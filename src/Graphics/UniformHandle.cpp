@@ -0,0 +1,59 @@
+#include "Graphics/UniformHandle.h"
+#include <mutex>
+#include <deque>
+#include <unordered_map>
+#include <cstring>
+#include "Logging.h"
+
+// The names that have been interned, indexed by ID, and a lookup of their hashes. This is a function
+// static so that handles can safely be created during static initialization in other files
+struct UniformRegistry {
+	std::mutex                                  Mutex;
+	// A deque so that references to names stay valid as more are added
+	std::deque<std::string>                     Names;
+	std::unordered_multimap<uint32_t, uint32_t> Ids;
+
+	static UniformRegistry& Get() {
+		static UniformRegistry instance;
+		return instance;
+	}
+};
+
+UniformHandle::UniformHandle(const UniformName& name) :
+	_id(_Intern(name.Name, strlen(name.Name), name.Hash))
+{ }
+
+UniformHandle UniformHandle::FromString(const std::string& name) {
+	UniformHandle result;
+	result._id = _Intern(name.c_str(), name.size(), UniformName::HashString(name.c_str(), name.size()));
+	return result;
+}
+
+const std::string& UniformHandle::GetName() const {
+	static const std::string empty = "";
+	if (_id == INVALID_ID) {
+		return empty;
+	}
+	UniformRegistry& registry = UniformRegistry::Get();
+	std::lock_guard<std::mutex> lock(registry.Mutex);
+	return registry.Names[_id];
+}
+
+uint32_t UniformHandle::_Intern(const char* name, size_t length, uint32_t hash) {
+	UniformRegistry& registry = UniformRegistry::Get();
+	std::lock_guard<std::mutex> lock(registry.Mutex);
+
+	// Different names can share a hash, so we still need to compare the strings
+	auto range = registry.Ids.equal_range(hash);
+	for (auto it = range.first; it != range.second; it++) {
+		const std::string& existing = registry.Names[it->second];
+		if (existing.size() == length && memcmp(existing.data(), name, length) == 0) {
+			return it->second;
+		}
+	}
+
+	uint32_t id = static_cast<uint32_t>(registry.Names.size());
+	registry.Names.emplace_back(name, length);
+	registry.Ids.emplace(hash, id);
+	return id;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/// <summary>
+/// A uniform name along with its 32 bit FNV-1a hash. When created from a string literal with the
+/// _uniform suffix, the hash is calculated at compile time
+/// </summary>
+struct UniformName {
+	const char* Name;
+	uint32_t    Hash;
+
+	constexpr UniformName(const char* name, size_t length) :
+		Name(name),
+		Hash(HashString(name, length)) {}
+
+	static constexpr uint32_t HashString(const char* name, size_t length) {
+		uint32_t hash = 2166136261u;
+		for (size_t ix = 0; ix < length; ix++) {
+			hash ^= static_cast<uint8_t>(name[ix]);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+};
+
+/// <summary>
+/// Creates a UniformName from a string literal, ex: "u_Gravity"_uniform
+/// </summary>
+constexpr UniformName operator""_uniform(const char* name, size_t length) {
+	return UniformName(name, length);
+}
+
+/// <summary>
+/// An interned uniform name. Every unique name is given a small integer ID the first time a handle
+/// is created for it, which shader programs use to index a flat table of uniform locations. This
+/// means setting a uniform by handle does not need to build or hash a string
+///
+/// Interning takes a lock, so handles should be created once and stored, for instance:
+/// static const UniformHandle u_Gravity = "u_Gravity"_uniform;
+/// </summary>
+class UniformHandle {
+public:
+	static const uint32_t INVALID_ID = 0xFFFFFFFF;
+
+	UniformHandle() : _id(INVALID_ID) {}
+	UniformHandle(const UniformName& name);
+
+	/// <summary>
+	/// Interns a uniform name that isn't known at compile time, this is the slow path
+	/// </summary>
+	static UniformHandle FromString(const std::string& name);
+
+	/// <summary>
+	/// Gets the interned ID of this handle, which is an index into ShaderProgram's location table
+	/// </summary>
+	uint32_t GetId() const { return _id; }
+	/// <summary>
+	/// Gets the name that this handle was interned from
+	/// </summary>
+	const std::string& GetName() const;
+
+	bool IsValid() const { return _id != INVALID_ID; }
+
+	bool operator ==(const UniformHandle& other) const { return _id == other._id; }
+	bool operator !=(const UniformHandle& other) const { return _id != other._id; }
+
+protected:
+	uint32_t _id;
+
+	static uint32_t _Intern(const char* name, size_t length, uint32_t hash);
+};
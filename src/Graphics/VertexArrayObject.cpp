@@ -8,7 +8,9 @@ VertexArrayObject::VertexArrayObject() :
 	_handle(0),
 	_vertexCount(0),
 	_elementCount(0),
-	_vertexBuffers(std::vector<VertexBufferBinding*>())
+	_vertexBuffers(std::vector<VertexBufferBinding*>()),
+	_positionTransform(glm::mat4(1.0f)),
+	_hasPositionTransform(false)
 {
 	glCreateVertexArrays(1, &_handle);
 }
@@ -43,7 +45,8 @@ VertexArrayObject::VertexBufferBinding* VertexArrayObject::AddVertexBuffer(const
 			_elementCount = _vertexCount;
 		}
 	} 
-	else if (buffer->GetElementCount() != _vertexCount) {
+	// Instanced buffers are sized by the number of instances, not vertices
+	else if (!instanced && buffer->GetElementCount() != _vertexCount) {
 		LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 	}
 
@@ -77,7 +80,7 @@ void VertexArrayObject::ReplaceVertexBuffer(VertexBufferBinding* binding, const
 	});
 
 	if (it != _vertexBuffers.end()) {
-		if (buffer->GetElementCount() != _vertexCount) {
+		if (!binding->Instanced && buffer->GetElementCount() != _vertexCount) {
 			LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 		}
 
@@ -101,31 +104,99 @@ void VertexArrayObject::ReplaceVertexBuffer(VertexBufferBinding* binding, const
 
 }
 
-void VertexArrayObject::Draw(DrawMode mode) {
-	Bind();
-	if (_indexBuffer == nullptr) {
+void VertexArrayObject::SetLods(const std::vector<MeshLod>& lods) {
+	_lods = lods;
+	// The full mesh is only the first LOD, not the entire index buffer
+	if (!_lods.empty()) {
+		_elementCount = _lods[0].IndexCount;
+	}
+}
+
+void VertexArrayObject::Draw(DrawMode mode, bool bind, uint32_t lod) {
+	if (bind) {
+		Bind();
+	}
+	if (_indexBuffer != nullptr && !_lods.empty()) {
+		const MeshLod& range = _lods[lod < _lods.size() ? lod : _lods.size() - 1];
+		size_t indexSize = GetIndexTypeSize(_indexBuffer->GetElementType());
+		if (range.SubMeshCount > 0) {
+			for (uint32_t ix = range.FirstSubMesh; ix < range.FirstSubMesh + range.SubMeshCount; ix++) {
+				const SubMesh& subMesh = _subMeshes[ix];
+				glDrawElementsBaseVertex((GLenum)mode, subMesh.IndexCount, (GLenum)_indexBuffer->GetElementType(),
+										 (void*)(subMesh.FirstIndex * indexSize), subMesh.BaseVertex);
+			}
+		} else {
+			glDrawElements((GLenum)mode, range.IndexCount, (GLenum)_indexBuffer->GetElementType(), (void*)(range.FirstIndex * indexSize));
+		}
+	} else if (_indexBuffer == nullptr) {
 		uint32_t elements = _elementCount == 0 ? _vertexBuffers[0]->Buffer->GetElementCount() : _elementCount;
 		glDrawArrays((GLenum)mode, 0, elements);
+	} else if (!_subMeshes.empty()) {
+		// Sub-meshes can store their indices relative to their own vertices, so they can use 16 bit indices
+		size_t indexSize = GetIndexTypeSize(_indexBuffer->GetElementType());
+		for (const SubMesh& subMesh : _subMeshes) {
+			glDrawElementsBaseVertex((GLenum)mode, subMesh.IndexCount, (GLenum)_indexBuffer->GetElementType(),
+									 (void*)(subMesh.FirstIndex * indexSize), subMesh.BaseVertex);
+		}
 	} else {
 		uint32_t elements = _elementCount == 0 ? _indexBuffer->GetElementCount() : _elementCount;
 		glDrawElements((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr);
 	}
-	Unbind();
+	if (bind) {
+		Unbind();
+	}
 }
 
-void VertexArrayObject::DrawInstanced(uint32_t instanceCount, DrawMode mode /*= DrawMode::TriangleList*/)
+void VertexArrayObject::DrawInstanced(uint32_t instanceCount, DrawMode mode /*= DrawMode::TriangleList*/, bool bind /*= true*/, uint32_t baseInstance /*= 0*/, uint32_t lod /*= 0*/)
 {
-	Bind();
-	if (_indexBuffer == nullptr) {
+	if (bind) {
+		Bind();
+	}
+	if (_indexBuffer != nullptr && !_lods.empty()) {
+		const MeshLod& range = _lods[lod < _lods.size() ? lod : _lods.size() - 1];
+		size_t indexSize = GetIndexTypeSize(_indexBuffer->GetElementType());
+		if (range.SubMeshCount > 0) {
+			for (uint32_t ix = range.FirstSubMesh; ix < range.FirstSubMesh + range.SubMeshCount; ix++) {
+				const SubMesh& subMesh = _subMeshes[ix];
+				glDrawElementsInstancedBaseVertexBaseInstance((GLenum)mode, subMesh.IndexCount, (GLenum)_indexBuffer->GetElementType(),
+															  (void*)(subMesh.FirstIndex * indexSize), instanceCount, subMesh.BaseVertex, baseInstance);
+			}
+		} else {
+			glDrawElementsInstancedBaseInstance((GLenum)mode, range.IndexCount, (GLenum)_indexBuffer->GetElementType(),
+												(void*)(range.FirstIndex * indexSize), instanceCount, baseInstance);
+		}
+	}
+	else if (_indexBuffer == nullptr) {
 		uint32_t elements = _elementCount == 0 ? _vertexBuffers[0]->Buffer->GetElementCount() : _elementCount;
-		glDrawArraysInstanced((GLenum)mode, 0, elements, instanceCount);
+		glDrawArraysInstancedBaseInstance((GLenum)mode, 0, elements, instanceCount, baseInstance);
+	}
+	else if (!_subMeshes.empty()) {
+		size_t indexSize = GetIndexTypeSize(_indexBuffer->GetElementType());
+		for (const SubMesh& subMesh : _subMeshes) {
+			glDrawElementsInstancedBaseVertexBaseInstance((GLenum)mode, subMesh.IndexCount, (GLenum)_indexBuffer->GetElementType(),
+														  (void*)(subMesh.FirstIndex * indexSize), instanceCount, subMesh.BaseVertex, baseInstance);
+		}
 	}
 	else {
 		uint32_t elements = _elementCount == 0 ? _indexBuffer->GetElementCount() : _elementCount;
-		glDrawElementsInstanced((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr, instanceCount);
+		glDrawElementsInstancedBaseInstance((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr, instanceCount, baseInstance);
+	}
+	if (bind) {
+		Unbind();
+	}
+
+}
+
+void VertexArrayObject::MultiDrawIndirect(uint32_t commandOffset, uint32_t commandCount, DrawMode mode /*= DrawMode::TriangleList*/, bool bind /*= true*/)
+{
+	LOG_ASSERT(_indexBuffer != nullptr, "Indirect draws require an index buffer");
+	if (bind) {
+		Bind();
+	}
+	glMultiDrawElementsIndirect((GLenum)mode, (GLenum)_indexBuffer->GetElementType(), (const void*)(size_t)commandOffset, commandCount, 0);
+	if (bind) {
+		Unbind();
 	}
-	Unbind();
-	
 }
 
 void VertexArrayObject::Bind() {
@@ -177,6 +248,12 @@ VertexArrayObject::Sptr VertexArrayObject::Clone() const
 	}
 
 	result->SetVDecl(_vDecl);
+	result->SetBounds(_bounds);
+	result->SetSubMeshes(_subMeshes);
+	result->SetLods(_lods);
+	if (_hasPositionTransform) {
+		result->SetPositionTransform(_positionTransform);
+	}
 
 	return result;
 }
@@ -9,6 +9,7 @@
 #include "Graphics/Buffers/IndexBuffer.h"
 #include "Graphics/GlEnums.h"
 #include "Graphics/IGraphicsResource.h"
+#include "Utils/Bounds.h"
 
 /// <summary>
 /// This structure will represent the parameters passed to the glVertexAttribPointer commands
@@ -50,6 +51,18 @@ struct BufferAttribute {
 		Slot(slot), Size(size), Type(type), Stride(stride), Offset(offset), Usage(usage), Normalized(normalized) { }
 };
 
+/// <summary>
+/// The layout of a single draw read by glMultiDrawElementsIndirect, see
+/// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glMultiDrawElementsIndirect.xhtml
+/// </summary>
+struct DrawElementsIndirectCommand {
+	uint32_t IndexCount;
+	uint32_t InstanceCount;
+	uint32_t FirstIndex;
+	int32_t  BaseVertex;
+	uint32_t BaseInstance;
+};
+
 /// <summary>
 /// The Vertex Array Object wraps around an OpenGL VAO and basically represents all of the data for a mesh
 /// </summary>
@@ -119,20 +132,40 @@ public:
 	/// <param name="usage">The attribute usage hint to search for</param>
 	/// <returns>A const pointer to the binding, or nullptr if none is found</returns>
 	VertexBufferBinding* GetBufferBinding(AttribUsage usage);
+	/// <summary>
+	/// Gets all the vertex buffers that are bound to this VAO
+	/// </summary>
+	const std::vector<VertexBufferBinding*>& GetVertexBuffers() const { return _vertexBuffers; }
 
 	/// <summary>
 	/// Renders this VAO, using the specified draw mode
 	/// </summary>
 	/// <param name="mode">The draw mode for primitives in this VAO</param>
-	void Draw(DrawMode mode = DrawMode::TriangleList);
+	/// <param name="bind">If false, assumes that the caller has already bound this VAO, and will leave it bound after drawing</param>
+	/// <param name="lod">The level of detail to draw, clamped to the number of LODs in the VAO</param>
+	void Draw(DrawMode mode = DrawMode::TriangleList, bool bind = true, uint32_t lod = 0);
 
 	/// <summary>
 	/// Renders this VAO with the given instance count, using the specified draw mode. 
-	/// Internally this will call glDrawArraysInstanced or glDrawElementsInstanced
+	/// Internally this will call glDrawArraysInstancedBaseInstance or glDrawElementsInstancedBaseInstance
 	/// </summary>
 	/// <param name="instanceCount">The number of instances to render</param>
 	/// <param name="mode">The primitive mode for rendering the mesh</param>
-	void DrawInstanced(uint32_t instanceCount, DrawMode mode = DrawMode::TriangleList);
+	/// <param name="bind">If false, assumes that the caller has already bound this VAO, and will leave it bound after drawing</param>
+	/// <param name="baseInstance">The index of the first instance to read from instanced buffers</param>
+	/// <param name="lod">The level of detail to draw, clamped to the number of LODs in the VAO</param>
+	void DrawInstanced(uint32_t instanceCount, DrawMode mode = DrawMode::TriangleList, bool bind = true, uint32_t baseInstance = 0, uint32_t lod = 0);
+
+	/// <summary>
+	/// Renders a list of DrawElementsIndirectCommands from the buffer bound to GL_DRAW_INDIRECT_BUFFER
+	/// with glMultiDrawElementsIndirect. The VAO's LODs and sub-meshes are ignored, the commands
+	/// describe which ranges of the index buffer to draw
+	/// </summary>
+	/// <param name="commandOffset">The offset in bytes of the first command within the indirect buffer</param>
+	/// <param name="commandCount">The number of commands to draw</param>
+	/// <param name="mode">The primitive mode for rendering the mesh</param>
+	/// <param name="bind">If false, assumes that the caller has already bound this VAO, and will leave it bound after drawing</param>
+	void MultiDrawIndirect(uint32_t commandOffset, uint32_t commandCount, DrawMode mode = DrawMode::TriangleList, bool bind = true);
 
 	/// <summary>
 	/// Binds this VAO as the source of data for draw operations
@@ -151,6 +184,82 @@ public:
 	void SetVDecl(const VertexDeclaration& vDecl);
 	const VertexDeclaration& GetVDecl();
 
+	/// <summary>
+	/// Sets the local space bounds of the vertices in this VAO, should be set by whatever
+	/// generates the vertex data (ex: MeshBuilder::Bake)
+	/// </summary>
+	void SetBounds(const Bounds& bounds) { _bounds = bounds; }
+	/// <summary>
+	/// Gets the local space bounds of the vertices in this VAO, will be invalid if the
+	/// bounds were never calculated
+	/// </summary>
+	const Bounds& GetBounds() const { return _bounds; }
+
+	/// <summary>
+	/// Sets a transform that maps the positions stored in the vertex buffer into the mesh's local
+	/// space. This is used by meshes with quantized positions (ex: VertexPackedPosNormTexColTangents),
+	/// and should be applied before the model transform when rendering
+	/// </summary>
+	void SetPositionTransform(const glm::mat4& transform) { _positionTransform = transform; _hasPositionTransform = true; }
+	/// <summary>
+	/// Gets the transform from the positions in the vertex buffer to local space, this is the identity
+	/// matrix unless the positions are quantized
+	/// </summary>
+	const glm::mat4& GetPositionTransform() const { return _positionTransform; }
+	/// <summary>
+	/// Returns true if the positions in this VAO need to be transformed by GetPositionTransform
+	/// </summary>
+	bool HasPositionTransform() const { return _hasPositionTransform; }
+
+	/// <summary>
+	/// Represents a range of the index buffer that can be drawn on it's own (ex: a part of
+	/// a model that uses a different material)
+	/// </summary>
+	struct SubMesh {
+		uint32_t FirstIndex;
+		uint32_t IndexCount;
+		int32_t  BaseVertex;
+		uint32_t VertexCount;
+	};
+
+	/// <summary>
+	/// Sets the sub-mesh ranges for this VAO, if no sub-meshes are set the VAO is treated as a single mesh
+	/// </summary>
+	void SetSubMeshes(const std::vector<SubMesh>& subMeshes) { _subMeshes = subMeshes; }
+	/// <summary>
+	/// Gets the sub-mesh ranges for this VAO, will be empty if the VAO is a single mesh
+	/// </summary>
+	const std::vector<SubMesh>& GetSubMeshes() const { return _subMeshes; }
+
+	/// <summary>
+	/// Represents a simplified version of the mesh, stored as a range of the index buffer that uses
+	/// the same vertices as the full mesh. LOD 0 is always the full mesh. If the mesh has been split
+	/// for 16 bit indices, each LOD is drawn as a range of the sub-meshes instead
+	/// </summary>
+	struct MeshLod {
+		uint32_t FirstIndex;
+		uint32_t IndexCount;
+		// How far the simplified surface may be from the full mesh, in local space units
+		float    Error;
+		// The sub-meshes that make up this LOD, if SubMeshCount is 0 the LOD is drawn as a single range
+		uint32_t FirstSubMesh;
+		uint32_t SubMeshCount;
+	};
+
+	/// <summary>
+	/// Sets the levels of detail for this VAO, ordered from most to least detailed. If LODs are set,
+	/// the index buffer is treated as a list of LODs rather than a single mesh
+	/// </summary>
+	void SetLods(const std::vector<MeshLod>& lods);
+	/// <summary>
+	/// Gets the levels of detail for this VAO, will be empty if the VAO has no simplified versions
+	/// </summary>
+	const std::vector<MeshLod>& GetLods() const { return _lods; }
+	/// <summary>
+	/// Gets the number of levels of detail that can be drawn, this is always at least 1
+	/// </summary>
+	uint32_t GetLodCount() const { return _lods.empty() ? 1 : static_cast<uint32_t>(_lods.size()); }
+
 protected:
 	
 	// The index buffer bound to this VAO
@@ -162,6 +271,16 @@ protected:
 	// defined in VertexTypes.cpp
 	VertexDeclaration _vDecl;
 
+	// The local space bounds of our vertex positions
+	Bounds _bounds;
+	// Ranges of the index buffer that make up the parts of the mesh
+	std::vector<SubMesh> _subMeshes;
+	// Ranges of the index buffer for each level of detail
+	std::vector<MeshLod> _lods;
+	// Maps quantized positions back to local space
+	glm::mat4 _positionTransform;
+	bool      _hasPositionTransform;
+
 	uint32_t _vertexCount;
 	uint32_t _elementCount;
 
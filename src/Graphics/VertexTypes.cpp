@@ -1,4 +1,6 @@
 #include "VertexTypes.h"
+#include <GLM/gtc/packing.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
 #pragma warning( push )
 
 VertexPosCol* VPC = nullptr;
@@ -7,6 +9,7 @@ VertexPosNormCol* VPNC = nullptr;
 VertexPosNormTex* VPNT = nullptr;
 VertexPosNormTexCol* VPNTC = nullptr;
 VertexPosNormTexColTangents* VPNTCT = nullptr;
+VertexPackedPosNormTexColTangents* VPPNTCT = nullptr;
 
 const std::vector<BufferAttribute> VertexPosCol::V_DECL = {
 	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosCol), (size_t)&VPC->Position, AttribUsage::Position),
@@ -41,4 +44,92 @@ const std::vector<BufferAttribute> VertexPosNormTexColTangents::V_DECL ={
 	BufferAttribute(4, 3, AttributeType::Float, sizeof(VertexPosNormTexColTangents), (size_t)&VPNTCT->Tangent, AttribUsage::Tangent),
 	BufferAttribute(5, 3, AttributeType::Float, sizeof(VertexPosNormTexColTangents), (size_t)&VPNTCT->BiTangent, AttribUsage::BiTangent)
 };
-#pragma warning(pop)
\ No newline at end of file
+const std::vector<BufferAttribute> VertexPackedPosNormTexColTangents::V_DECL ={
+	BufferAttribute(0, 3, AttributeType::UShort, sizeof(VertexPackedPosNormTexColTangents), (size_t)&VPPNTCT->Position, AttribUsage::Position, true),
+	BufferAttribute(1, 4, AttributeType::UByte, sizeof(VertexPackedPosNormTexColTangents), (size_t)&VPPNTCT->Color, AttribUsage::Color, true),
+	BufferAttribute(2, 4, AttributeType::Short, sizeof(VertexPackedPosNormTexColTangents), (size_t)&VPPNTCT->Normal, AttribUsage::Normal, true),
+	BufferAttribute(3, 2, AttributeType::HalfFloat, sizeof(VertexPackedPosNormTexColTangents), (size_t)&VPPNTCT->UV, AttribUsage::Texture),
+	BufferAttribute(4, 4, AttributeType::Short, sizeof(VertexPackedPosNormTexColTangents), (size_t)&VPPNTCT->Tangent, AttribUsage::Tangent, true)
+};
+#pragma warning(pop)
+
+namespace {
+	// Encodes a unit vector into the [-1, 1] square by projecting it onto an octahedron and
+	// folding the bottom half over the top. See Cigolle et al, "A Survey of Efficient
+	// Representations for Independent Unit Vectors" (JCGT 2014)
+	glm::vec2 OctEncode(const glm::vec3& n) {
+		float sum = glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+		if (sum == 0.0f) {
+			return glm::vec2(0.0f);
+		}
+		glm::vec2 result = glm::vec2(n.x, n.y) / sum;
+		if (n.z < 0.0f) {
+			glm::vec2 sign = glm::vec2(result.x >= 0.0f ? 1.0f : -1.0f, result.y >= 0.0f ? 1.0f : -1.0f);
+			result = (1.0f - glm::abs(glm::vec2(result.y, result.x))) * sign;
+		}
+		return result;
+	}
+
+	// Matches OctDecode in vs_common.glsl
+	glm::vec3 OctDecode(const glm::vec2& e) {
+		glm::vec3 n = glm::vec3(e.x, e.y, 1.0f - glm::abs(e.x) - glm::abs(e.y));
+		float t = glm::max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		return glm::normalize(n);
+	}
+}
+
+VertexPackedPosNormTexColTangents::VertexPackedPosNormTexColTangents() :
+	Position{ 0, 0, 0, 0 },
+	Normal{ 0, 0, 0, 0 },
+	Tangent{ 0, 0, 0, 0 },
+	UV{ 0, 0 },
+	Color{ 0, 0, 0, 255 }
+{ }
+
+VertexPackedPosNormTexColTangents VertexPackedPosNormTexColTangents::Pack(const VertexPosNormTexColTangents& vertex, const BoundingBox& bounds) {
+	VertexPackedPosNormTexColTangents result;
+
+	// Store the position relative to the box, flat axes are all stored as 0
+	glm::vec3 extents = bounds.Max - bounds.Min;
+	for (int ix = 0; ix < 3; ix++) {
+		float t = extents[ix] > 0.0f ? (vertex.Position[ix] - bounds.Min[ix]) / extents[ix] : 0.0f;
+		result.Position[ix] = glm::packUnorm1x16(t);
+	}
+
+	glm::vec2 normal  = OctEncode(vertex.Normal);
+	glm::vec2 tangent = OctEncode(vertex.Tangent);
+	// Determine whether the bitangent is cross(N, T) or -cross(N, T)
+	float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.BiTangent) < 0.0f ? -1.0f : 1.0f;
+	result.Normal[0]  = static_cast<int16_t>(glm::packSnorm1x16(normal.x));
+	result.Normal[1]  = static_cast<int16_t>(glm::packSnorm1x16(normal.y));
+	result.Tangent[0] = static_cast<int16_t>(glm::packSnorm1x16(tangent.x));
+	result.Tangent[1] = static_cast<int16_t>(glm::packSnorm1x16(tangent.y));
+	result.Tangent[2] = static_cast<int16_t>(glm::packSnorm1x16(handedness));
+
+	result.UV[0] = glm::packHalf1x16(vertex.UV.x);
+	result.UV[1] = glm::packHalf1x16(vertex.UV.y);
+
+	for (int ix = 0; ix < 4; ix++) {
+		result.Color[ix] = glm::packUnorm1x8(vertex.Color[ix]);
+	}
+
+	return result;
+}
+
+VertexPosNormTexColTangents VertexPackedPosNormTexColTangents::Unpack(const BoundingBox& bounds) const {
+	VertexPosNormTexColTangents result;
+	result.Position = glm::vec3(GetPositionTransform(bounds) * glm::vec4(
+		glm::unpackUnorm1x16(Position[0]), glm::unpackUnorm1x16(Position[1]), glm::unpackUnorm1x16(Position[2]), 1.0f));
+	result.Normal    = OctDecode(glm::vec2(glm::unpackSnorm1x16(Normal[0]), glm::unpackSnorm1x16(Normal[1])));
+	result.Tangent   = OctDecode(glm::vec2(glm::unpackSnorm1x16(Tangent[0]), glm::unpackSnorm1x16(Tangent[1])));
+	result.BiTangent = glm::cross(result.Normal, result.Tangent) * glm::unpackSnorm1x16(Tangent[2]);
+	result.UV        = glm::vec2(glm::unpackHalf1x16(UV[0]), glm::unpackHalf1x16(UV[1]));
+	result.Color     = glm::vec4(glm::unpackUnorm1x8(Color[0]), glm::unpackUnorm1x8(Color[1]), glm::unpackUnorm1x8(Color[2]), glm::unpackUnorm1x8(Color[3]));
+	return result;
+}
+
+glm::mat4 VertexPackedPosNormTexColTangents::GetPositionTransform(const BoundingBox& bounds) {
+	return glm::scale(glm::translate(glm::mat4(1.0f), bounds.Min), bounds.Max - bounds.Min);
+}
\ No newline at end of file
@@ -116,4 +116,43 @@ struct VertexPosNormTexColTangents {
 	{}
 
 	static const std::vector<BufferAttribute> V_DECL;
-};
\ No newline at end of file
+};
+
+/// <summary>
+/// A compressed version of VertexPosNormTexColTangents, which takes 32 bytes instead of 72
+/// - Position is quantized to unorm16 within the mesh's bounding box, the VAO's position transform
+///   (see GetPositionTransform) maps it back into local space
+/// - Normal and Tangent are octahedral encoded snorm16. The bitangent is rebuilt in the vertex shader
+///   from the normal, tangent and the handedness stored in Tangent[2]
+/// - UV is stored as half floats, and Color as unorm8
+/// The w component of Normal and Tangent is always 0, which is how vs_common.glsl tells packed
+/// vertices apart from float ones
+/// </summary>
+struct VertexPackedPosNormTexColTangents {
+	uint16_t Position[4];
+	int16_t  Normal[4];
+	int16_t  Tangent[4];
+	uint16_t UV[2];
+	uint8_t  Color[4];
+
+	VertexPackedPosNormTexColTangents();
+
+	/// <summary>
+	/// Compresses a vertex into the packed format
+	/// </summary>
+	/// <param name="vertex">The vertex to compress</param>
+	/// <param name="bounds">The box to quantize the position within, usually the mesh's bounds</param>
+	static VertexPackedPosNormTexColTangents Pack(const VertexPosNormTexColTangents& vertex, const BoundingBox& bounds);
+	/// <summary>
+	/// Decompresses this vertex, the result will be close to but not exactly the same as the packed vertex
+	/// </summary>
+	/// <param name="bounds">The box the position was quantized within</param>
+	VertexPosNormTexColTangents Unpack(const BoundingBox& bounds) const;
+
+	/// <summary>
+	/// Gets the transform that maps positions quantized within the given box back to local space
+	/// </summary>
+	static glm::mat4 GetPositionTransform(const BoundingBox& bounds);
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
@@ -0,0 +1,146 @@
+#include "Utils/Bounds.h"
+#include <limits>
+
+BoundingBox::BoundingBox() :
+	Min(glm::vec3(std::numeric_limits<float>::max())),
+	Max(glm::vec3(std::numeric_limits<float>::lowest()))
+{ }
+
+BoundingBox::BoundingBox(const glm::vec3& min, const glm::vec3& max) :
+	Min(min),
+	Max(max)
+{ }
+
+void BoundingBox::Encapsulate(const glm::vec3& point) {
+	Min = glm::min(Min, point);
+	Max = glm::max(Max, point);
+}
+
+void BoundingBox::Encapsulate(const BoundingBox& other) {
+	if (other.IsValid()) {
+		Min = glm::min(Min, other.Min);
+		Max = glm::max(Max, other.Max);
+	}
+}
+
+BoundingBox BoundingBox::Transform(const glm::mat4& transform) const {
+	if (!IsValid()) {
+		return *this;
+	}
+
+	// Rather than transforming all 8 corners, we transform the center and project the
+	// extents onto each world axis using the absolute value of the rotation/scale part
+	// See Arvo, "Transforming Axis-Aligned Bounding Boxes" (Graphics Gems, 1990)
+	glm::vec3 center  = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+	glm::vec3 extents = GetExtents();
+	glm::vec3 newExtents =
+		glm::abs(glm::vec3(transform[0])) * extents.x +
+		glm::abs(glm::vec3(transform[1])) * extents.y +
+		glm::abs(glm::vec3(transform[2])) * extents.z;
+
+	return BoundingBox(center - newExtents, center + newExtents);
+}
+
+BoundingSphere BoundingSphere::Transform(const glm::mat4& transform) const {
+	if (!IsValid()) {
+		return *this;
+	}
+
+	// The radius is scaled by the largest scale along any of the axes
+	float scale = glm::max(glm::max(
+		glm::length(glm::vec3(transform[0])),
+		glm::length(glm::vec3(transform[1]))),
+		glm::length(glm::vec3(transform[2])));
+
+	return BoundingSphere(glm::vec3(transform * glm::vec4(Center, 1.0f)), Radius * scale);
+}
+
+Bounds Bounds::Transform(const glm::mat4& transform) const {
+	Bounds result;
+	result.Box = Box.Transform(transform);
+	result.Sphere = Sphere.Transform(transform);
+	return result;
+}
+
+Bounds Bounds::FromPoints(const glm::vec3* points, size_t count, size_t stride) {
+	Bounds result;
+	if (points == nullptr || count == 0) {
+		return result;
+	}
+
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(points);
+
+	// First pass determines the box
+	for (size_t ix = 0; ix < count; ix++) {
+		result.Box.Encapsulate(*reinterpret_cast<const glm::vec3*>(data + ix * stride));
+	}
+
+	// Second pass finds the furthest point from the center of the box
+	glm::vec3 center = result.Box.GetCenter();
+	float radiusSq = 0.0f;
+	for (size_t ix = 0; ix < count; ix++) {
+		glm::vec3 offset = *reinterpret_cast<const glm::vec3*>(data + ix * stride) - center;
+		radiusSq = glm::max(radiusSq, glm::dot(offset, offset));
+	}
+	result.Sphere = BoundingSphere(center, glm::sqrt(radiusSq));
+
+	return result;
+}
+
+Frustum Frustum::FromViewProjection(const glm::mat4& viewProjection) {
+	Frustum result;
+
+	// GLM is column major, so we grab the rows of the matrix first
+	glm::mat4 m = glm::transpose(viewProjection);
+
+	result.Planes[0] = m[3] + m[0]; // Left
+	result.Planes[1] = m[3] - m[0]; // Right
+	result.Planes[2] = m[3] + m[1]; // Bottom
+	result.Planes[3] = m[3] - m[1]; // Top
+	result.Planes[4] = m[3] + m[2]; // Near
+	result.Planes[5] = m[3] - m[2]; // Far
+
+	// Normalize the planes so that distances are in world units
+	for (int ix = 0; ix < 6; ix++) {
+		result.Planes[ix] /= glm::length(glm::vec3(result.Planes[ix]));
+	}
+
+	return result;
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const {
+	for (int ix = 0; ix < 6; ix++) {
+		// If the center is further than the radius behind any plane, the sphere is outside
+		if (glm::dot(glm::vec3(Planes[ix]), sphere.Center) + Planes[ix].w < -sphere.Radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::Intersects(const BoundingBox& box) const {
+	for (int ix = 0; ix < 6; ix++) {
+		const glm::vec3 normal = glm::vec3(Planes[ix]);
+
+		// Find the corner of the box that is furthest along the plane's normal
+		glm::vec3 positive = glm::vec3(
+			normal.x >= 0.0f ? box.Max.x : box.Min.x,
+			normal.y >= 0.0f ? box.Max.y : box.Min.y,
+			normal.z >= 0.0f ? box.Max.z : box.Min.z
+		);
+
+		// If even that corner is behind the plane, the whole box is outside
+		if (glm::dot(normal, positive) + Planes[ix].w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::Intersects(const Bounds& bounds) const {
+	// Objects without bounds are never culled
+	if (!bounds.IsValid()) {
+		return true;
+	}
+	return Intersects(bounds.Sphere) && Intersects(bounds.Box);
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <cstdint>
+#include "GLM/glm.hpp"
+
+/// <summary>
+/// Represents an axis aligned bounding box
+/// </summary>
+struct BoundingBox {
+	glm::vec3 Min;
+	glm::vec3 Max;
+
+	/// <summary>
+	/// Creates an empty (invalid) bounding box, encapsulating any point will make it valid
+	/// </summary>
+	BoundingBox();
+	BoundingBox(const glm::vec3& min, const glm::vec3& max);
+
+	/// <summary>
+	/// Returns true if this box contains at least one point
+	/// </summary>
+	bool IsValid() const { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+
+	/// <summary>
+	/// Gets the point in the middle of the box
+	/// </summary>
+	glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+	/// <summary>
+	/// Gets the half-size of the box along each axis
+	/// </summary>
+	glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+	/// <summary>
+	/// Grows the box to contain the given point
+	/// </summary>
+	void Encapsulate(const glm::vec3& point);
+	/// <summary>
+	/// Grows the box to contain another box
+	/// </summary>
+	void Encapsulate(const BoundingBox& other);
+
+	/// <summary>
+	/// Calculates the axis aligned box that contains this box after it has been transformed
+	/// </summary>
+	/// <param name="transform">The affine transform to apply to the box</param>
+	BoundingBox Transform(const glm::mat4& transform) const;
+
+	bool operator ==(const BoundingBox& other) const { return Min == other.Min && Max == other.Max; }
+	bool operator !=(const BoundingBox& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// Represents a bounding sphere
+/// </summary>
+struct BoundingSphere {
+	glm::vec3 Center;
+	float     Radius;
+
+	BoundingSphere() : Center(glm::vec3(0.0f)), Radius(-1.0f) {}
+	BoundingSphere(const glm::vec3& center, float radius) : Center(center), Radius(radius) {}
+
+	/// <summary>
+	/// Returns true if this sphere has been calculated from at least one point
+	/// </summary>
+	bool IsValid() const { return Radius >= 0.0f; }
+
+	/// <summary>
+	/// Calculates a sphere that contains this sphere after it has been transformed.
+	/// For non-uniform scales, this will use the largest scaling axis
+	/// </summary>
+	/// <param name="transform">The affine transform to apply to the sphere</param>
+	BoundingSphere Transform(const glm::mat4& transform) const;
+
+	bool operator ==(const BoundingSphere& other) const { return Center == other.Center && Radius == other.Radius; }
+	bool operator !=(const BoundingSphere& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// Stores both the bounding box and bounding sphere for a mesh or object. The sphere is
+/// centered on the box, but it's radius is calculated from the actual points so it is
+/// usually tighter than the box's corners
+/// </summary>
+struct Bounds {
+	BoundingBox    Box;
+	BoundingSphere Sphere;
+
+	/// <summary>
+	/// Returns true if these bounds contain at least one point
+	/// </summary>
+	bool IsValid() const { return Box.IsValid(); }
+
+	/// <summary>
+	/// Transforms both the box and the sphere by the given affine transform
+	/// </summary>
+	Bounds Transform(const glm::mat4& transform) const;
+
+	/// <summary>
+	/// Calculates the bounds from an array of points, which may be interleaved with other data
+	/// </summary>
+	/// <param name="points">A pointer to the first point in the array</param>
+	/// <param name="count">The number of points in the array</param>
+	/// <param name="stride">The number of bytes between the start of each point, default is tightly packed</param>
+	static Bounds FromPoints(const glm::vec3* points, size_t count, size_t stride = sizeof(glm::vec3));
+
+	bool operator ==(const Bounds& other) const { return Box == other.Box && Sphere == other.Sphere; }
+	bool operator !=(const Bounds& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// Represents the 6 planes of a camera's view volume, can be used to test whether
+/// objects are visible to the camera
+/// </summary>
+struct Frustum {
+	/// <summary>
+	/// The planes of the frustum (left, right, bottom, top, near, far), stored as
+	/// (normal.x, normal.y, normal.z, distance), with the normals pointing inwards
+	/// </summary>
+	glm::vec4 Planes[6];
+
+	/// <summary>
+	/// Extracts the frustum planes from a view projection matrix, the resulting planes are in world space
+	/// </summary>
+	/// <see>https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf</see>
+	/// <param name="viewProjection">The combined view projection matrix of the camera</param>
+	static Frustum FromViewProjection(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Returns true if the sphere is at least partially inside the frustum
+	/// </summary>
+	bool Intersects(const BoundingSphere& sphere) const;
+	/// <summary>
+	/// Returns true if the box is at least partially inside the frustum. May return
+	/// true for some boxes that are just outside the corners of the frustum
+	/// </summary>
+	bool Intersects(const BoundingBox& box) const;
+	/// <summary>
+	/// Tests the bounds against the frustum, using the cheaper sphere test first
+	/// </summary>
+	bool Intersects(const Bounds& bounds) const;
+};
@@ -0,0 +1,87 @@
+#include "Utils/MappedFile.h"
+#include <Logging.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filename) :
+	_data(nullptr),
+	_size(0),
+	_fileHandle(nullptr),
+	_mappingHandle(nullptr)
+{
+	#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		LOG_ERROR("Could not open file '{}'", filename);
+		return;
+	}
+	_fileHandle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		LOG_ERROR("Could not map empty file '{}'", filename);
+		return;
+	}
+	_size = static_cast<size_t>(size.QuadPart);
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		LOG_ERROR("Could not create file mapping for '{}'", filename);
+		return;
+	}
+	_mappingHandle = mapping;
+
+	_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0) {
+		LOG_ERROR("Could not open file '{}'", filename);
+		return;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		LOG_ERROR("Could not map empty file '{}'", filename);
+		close(file);
+		return;
+	}
+	_size = static_cast<size_t>(info.st_size);
+
+	// The mapping keeps it's own reference to the file, so we can close our descriptor right away
+	void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	_data = data == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(data);
+	#endif
+
+	if (_data == nullptr) {
+		LOG_ERROR("Could not map file '{}' into memory", filename);
+		_size = 0;
+	}
+}
+
+MappedFile::~MappedFile() {
+	#ifdef _WIN32
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mappingHandle != nullptr) {
+		CloseHandle(_mappingHandle);
+	}
+	if (_fileHandle != nullptr) {
+		CloseHandle(_fileHandle);
+	}
+	#else
+	if (_data != nullptr) {
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+	#endif
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Maps a file into memory for read only access. This lets us read large binary files
+/// without copying them into our own buffers, pages are loaded in by the OS as we touch them.
+/// The mapping is released when this object is destroyed
+/// </summary>
+class MappedFile {
+public:
+	MAKE_PTRS(MappedFile);
+	NO_COPY(MappedFile);
+	NO_MOVE(MappedFile);
+
+	/// <summary>
+	/// Opens and maps the given file, check IsOpen to see if the mapping was successful
+	/// </summary>
+	/// <param name="filename">The path of the file to map</param>
+	MappedFile(const std::string& filename);
+	~MappedFile();
+
+	/// <summary>
+	/// Returns true if the file was opened and mapped into memory
+	/// </summary>
+	bool IsOpen() const { return _data != nullptr; }
+	/// <summary>
+	/// Gets a pointer to the start of the file's contents
+	/// </summary>
+	const uint8_t* GetData() const { return _data; }
+	/// <summary>
+	/// Gets the size of the file, in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+
+private:
+	const uint8_t* _data;
+	size_t         _size;
+
+	// Platform specific handles for the file and the mapping
+	void* _fileHandle;
+	void* _mappingHandle;
+};
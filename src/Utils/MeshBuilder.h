@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include "Graphics/VertexArrayObject.h"
+#include "Utils/MeshOptimizer.h"
 
 /// <summary>
 /// A utility class that lets us add vertices and indices, then bake it into a final mesh, using interleaved
@@ -13,7 +14,9 @@ class MeshBuilder
 public:
 	MeshBuilder() :
 		_vertices(std::vector<VertType>()),
-		_indices(std::vector<uint32_t>()) {}
+		_indices(std::vector<uint32_t>()),
+		_subMeshes(std::vector<VertexArrayObject::SubMesh>()),
+		_lods(std::vector<VertexArrayObject::MeshLod>()) {}
 	~MeshBuilder() = default;
 
 	/// <summary>
@@ -116,6 +119,181 @@ public:
 	/// </summary>
 	size_t GetTriangleCount() const { return _indices.size() > 0 ? _indices.size() / 3 : _vertices.size() / 3; }
 
+	/// <summary>
+	/// Re-orders the triangles and vertices in this mesh for the GPU's vertex cache, and optionally
+	/// to reduce overdraw (see MeshOptimizer). This is fairly expensive, so it should be done once
+	/// when converting a mesh instead of every time it is loaded. Does nothing for meshes without
+	/// indices
+	/// </summary>
+	/// <param name="optimizeOverdraw">True to also sort clusters of triangles to reduce overdraw</param>
+	void Optimize(bool optimizeOverdraw = true) {
+		if (_indices.size() == 0 || _vertices.size() == 0 || _lods.size() > 0) {
+			return;
+		}
+
+		std::vector<uint32_t> clusters;
+		MeshOptimizer::OptimizeVertexCache(_indices, _vertices.size(), MeshOptimizer::DEFAULT_CACHE_SIZE, &clusters);
+		if (optimizeOverdraw) {
+			MeshOptimizer::OptimizeOverdraw(_indices, clusters, &_vertices[0].Position, _vertices.size(), sizeof(VertType));
+		}
+
+		// Move the vertices into the order they are first used
+		std::vector<uint32_t> remap = MeshOptimizer::OptimizeVertexFetch(_indices, _vertices.size());
+		std::vector<VertType> vertices(_vertices.size());
+		for (size_t ix = 0; ix < _vertices.size(); ix++) {
+			vertices[remap[ix]] = _vertices[ix];
+		}
+		_vertices = std::move(vertices);
+	}
+
+	/// <summary>
+	/// Generates simplified versions of this mesh (see MeshOptimizer::Simplify), which are appended to
+	/// the index buffer and share the mesh's vertices. Each LOD aims for the given fraction of the
+	/// previous LOD's triangles, generation stops early if the mesh can't be simplified much further.
+	/// Should be done after Optimize, since the vertex order can no longer change once LODs exist, and
+	/// before SplitForShortIndices
+	/// </summary>
+	/// <param name="maxLods">The most LODs to generate, including the full mesh</param>
+	/// <param name="reduction">The fraction of triangles to keep for each LOD</param>
+	/// <returns>The number of LODs in the mesh, including the full mesh</returns>
+	uint32_t GenerateLods(uint32_t maxLods = 4, float reduction = 0.5f) {
+		if (_indices.size() == 0 || _vertices.size() == 0 || _subMeshes.size() > 0 || _lods.size() > 0) {
+			return static_cast<uint32_t>(_lods.size() > 0 ? _lods.size() : 1);
+		}
+
+		uint32_t fullCount = static_cast<uint32_t>(_indices.size());
+		std::vector<VertexArrayObject::MeshLod> lods;
+		lods.push_back({ 0, fullCount, 0.0f });
+
+		std::vector<uint32_t> lodIndices;
+		size_t target = fullCount;
+		while (lods.size() < maxLods) {
+			target = static_cast<size_t>(target * reduction) / 3 * 3;
+			if (target < 3) {
+				break;
+			}
+
+			// Always simplify from the full mesh, so that errors don't build up between LODs
+			std::vector<uint32_t> full(_indices.begin(), _indices.begin() + fullCount);
+			float error = 0.0f;
+			std::vector<uint32_t> simplified = MeshOptimizer::Simplify(full, &_vertices[0].Position, _vertices.size(), sizeof(VertType), target, &error);
+
+			// Not worth keeping a LOD that barely saves anything over the last one
+			if (simplified.size() == 0 || simplified.size() > lods.back().IndexCount * 0.8f) {
+				break;
+			}
+			MeshOptimizer::OptimizeVertexCache(simplified, _vertices.size());
+
+			uint32_t firstIndex = static_cast<uint32_t>(fullCount + lodIndices.size());
+			lods.push_back({ firstIndex, static_cast<uint32_t>(simplified.size()), error });
+			lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.end());
+			target = simplified.size();
+		}
+
+		if (lods.size() > 1) {
+			_indices.insert(_indices.end(), lodIndices.begin(), lodIndices.end());
+			_lods = std::move(lods);
+		}
+		return static_cast<uint32_t>(_lods.size() > 0 ? _lods.size() : 1);
+	}
+
+	/// <summary>
+	/// Gets the levels of detail for this mesh, will be empty unless GenerateLods has been called
+	/// </summary>
+	const std::vector<VertexArrayObject::MeshLod>& GetLods() const { return _lods; }
+
+	/// <summary>
+	/// If this mesh has too many vertices for 16 bit indices, splits it into sub-meshes that are each small
+	/// enough to use them (see MeshOptimizer::SplitForShortIndices). The split is only done if the memory
+	/// saved on indices is more than the memory used by vertices that need to be duplicated. Should be done
+	/// after Optimize and GenerateLods, and after all vertices and indices have been added. Each LOD gets
+	/// its own range of sub-meshes, which re-use the full mesh's vertices where they can
+	/// </summary>
+	/// <returns>True if the mesh was split</returns>
+	bool SplitForShortIndices() {
+		if (_vertices.size() <= MeshOptimizer::MAX_SHORT_INDEX_VERTICES || _indices.size() == 0) {
+			return false;
+		}
+
+		// The full detail mesh is split first, since the other LODs are built from the same vertices
+		size_t fullCount = _lods.empty() ? _indices.size() : _lods[0].IndexCount;
+		std::vector<uint32_t> indices(_indices.begin(), _indices.begin() + fullCount);
+		std::vector<VertexArrayObject::SubMesh> subMeshes;
+		std::vector<uint32_t> sources = MeshOptimizer::SplitForShortIndices(indices, _vertices.size(), subMeshes);
+
+		std::vector<VertexArrayObject::MeshLod> lods = _lods;
+		if (!lods.empty()) {
+			std::vector<VertexArrayObject::SubMesh> fullSubMeshes = subMeshes;
+			lods[0].FirstSubMesh = 0;
+			lods[0].SubMeshCount = static_cast<uint32_t>(subMeshes.size());
+			for (size_t lx = 1; lx < lods.size(); lx++) {
+				std::vector<uint32_t> lodIndices(_indices.begin() + lods[lx].FirstIndex, _indices.begin() + lods[lx].FirstIndex + lods[lx].IndexCount);
+				std::vector<VertexArrayObject::SubMesh> lodSubMeshes;
+				MeshOptimizer::SplitLodForShortIndices(lodIndices, _vertices.size(), fullSubMeshes, sources, lodSubMeshes);
+
+				lods[lx].FirstIndex   = static_cast<uint32_t>(indices.size());
+				lods[lx].FirstSubMesh = static_cast<uint32_t>(subMeshes.size());
+				lods[lx].SubMeshCount = static_cast<uint32_t>(lodSubMeshes.size());
+				for (VertexArrayObject::SubMesh& subMesh : lodSubMeshes) {
+					subMesh.FirstIndex += lods[lx].FirstIndex;
+					subMeshes.push_back(subMesh);
+				}
+				indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+			}
+		}
+
+		size_t currentSize = _vertices.size() * sizeof(VertType) + _indices.size() * sizeof(uint32_t);
+		size_t splitSize   = sources.size() * sizeof(VertType) + indices.size() * sizeof(uint16_t);
+		if (splitSize >= currentSize) {
+			return false;
+		}
+
+		std::vector<VertType> vertices;
+		vertices.reserve(sources.size());
+		for (uint32_t source : sources) {
+			vertices.push_back(_vertices[source]);
+		}
+		_vertices  = std::move(vertices);
+		_indices   = std::move(indices);
+		_subMeshes = std::move(subMeshes);
+		_lods      = std::move(lods);
+		return true;
+	}
+
+	/// <summary>
+	/// Gets the sub-mesh ranges for this mesh, will be empty unless SplitForShortIndices has split the mesh.
+	/// The indices of each sub-mesh are relative to it's BaseVertex
+	/// </summary>
+	const std::vector<VertexArrayObject::SubMesh>& GetSubMeshes() const { return _subMeshes; }
+
+	/// <summary>
+	/// Gets the smallest index type that can store all the indices in this mesh. 8 bit indices are
+	/// not used, since many GPUs don't support them natively
+	/// </summary>
+	IndexType GetNarrowestIndexType() const {
+		if (_subMeshes.size() > 0) {
+			for (const auto& subMesh : _subMeshes) {
+				if (subMesh.VertexCount > MeshOptimizer::MAX_SHORT_INDEX_VERTICES) {
+					return IndexType::UInt;
+				}
+			}
+			return IndexType::UShort;
+		}
+		return _vertices.size() <= MeshOptimizer::MAX_SHORT_INDEX_VERTICES ? IndexType::UShort : IndexType::UInt;
+	}
+
+	/// <summary>
+	/// Gets a copy of the indices in this mesh as 16 bit integers, should only be used if
+	/// GetNarrowestIndexType returns UShort
+	/// </summary>
+	std::vector<uint16_t> GetShortIndices() const {
+		std::vector<uint16_t> result(_indices.size());
+		for (size_t ix = 0; ix < _indices.size(); ix++) {
+			result[ix] = static_cast<uint16_t>(_indices[ix]);
+		}
+		return result;
+	}
+
 	/// <summary>
 	/// Creates and returns a VertexArraybject from the current data
 	/// </summary>
@@ -124,10 +302,16 @@ public:
 		VertexBuffer::Sptr vbo = VertexBuffer::Create();
 		vbo->LoadData(GetVertexDataPtr(), _vertices.size());
 
+		// Use 16 bit indices whenever we can, to halve the size of the index buffer
 		IndexBuffer::Sptr ebo = nullptr;
 		if (_indices.size() > 0) {
 			ebo = IndexBuffer::Create();
-			ebo->LoadData(GetIndexDataPtr(), _indices.size());
+			if (GetNarrowestIndexType() == IndexType::UShort) {
+				std::vector<uint16_t> indices = GetShortIndices();
+				ebo->LoadData(indices.data(), static_cast<uint32_t>(indices.size()));
+			} else {
+				ebo->LoadData(GetIndexDataPtr(), static_cast<uint32_t>(_indices.size()));
+			}
 		}
 
 		// Create VAO and attach the buffers
@@ -137,6 +321,13 @@ public:
 
 		// Store our vertex type in the VAO's vertex declaration
 		result->SetVDecl(VertType::V_DECL);
+		result->SetSubMeshes(_subMeshes);
+		result->SetLods(_lods);
+
+		// Calculate the bounds of the mesh while we still have the vertices on the CPU
+		if (_vertices.size() > 0) {
+			result->SetBounds(Bounds::FromPoints(&_vertices[0].Position, _vertices.size(), sizeof(VertType)));
+		}
 
 		return result;
 	}
@@ -147,6 +338,8 @@ public:
 	void Reset() {
 		_vertices.clear();
 		_indices.clear();
+		_subMeshes.clear();
+		_lods.clear();
 	}
 
 	/// <summary>
@@ -169,4 +362,6 @@ protected:
 	
 	std::vector<VertType> _vertices;
 	std::vector<uint32_t> _indices;
+	std::vector<VertexArrayObject::SubMesh> _subMeshes;
+	std::vector<VertexArrayObject::MeshLod> _lods;
 };
@@ -0,0 +1,658 @@
+#include "Utils/MeshOptimizer.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <cstring>
+#include <cmath>
+
+namespace {
+	const uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+	// Gets the position of a vertex from a possibly interleaved array
+	inline const glm::vec3& GetPosition(const glm::vec3* positions, size_t stride, uint32_t index) {
+		return *reinterpret_cast<const glm::vec3*>(reinterpret_cast<const uint8_t*>(positions) + stride * index);
+	}
+
+	// A symmetric 4x4 matrix that measures the sum of squared distances from a point to a set of
+	// planes, stored as the 10 unique elements. Doubles are used since the sums lose precision.
+	// Weight is the number of planes, so we can turn the sum into an average distance
+	struct Quadric {
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0;
+		double c = 0;
+		double Weight = 0;
+
+		static Quadric FromPlane(const glm::vec3& normal, float distance) {
+			Quadric q;
+			q.a00 = normal.x * normal.x; q.a01 = normal.x * normal.y; q.a02 = normal.x * normal.z;
+			q.a11 = normal.y * normal.y; q.a12 = normal.y * normal.z; q.a22 = normal.z * normal.z;
+			q.b0  = normal.x * distance; q.b1  = normal.y * distance; q.b2  = normal.z * distance;
+			q.c   = static_cast<double>(distance) * distance;
+			q.Weight = 1.0;
+			return q;
+		}
+
+		void operator +=(const Quadric& other) {
+			a00 += other.a00; a01 += other.a01; a02 += other.a02;
+			a11 += other.a11; a12 += other.a12; a22 += other.a22;
+			b0  += other.b0;  b1  += other.b1;  b2  += other.b2;
+			c   += other.c;
+			Weight += other.Weight;
+		}
+
+		double Evaluate(const glm::vec3& p) const {
+			double x = p.x, y = p.y, z = p.z;
+			double result =
+				a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z +
+				a11 * y * y + 2.0 * a12 * y * z + a22 * z * z +
+				2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return result > 0.0 ? result : 0.0;
+		}
+	};
+
+	// A candidate for collapsing one vertex onto another
+	struct Collapse {
+		uint32_t From;
+		uint32_t To;
+		double   Cost;
+		// The root mean squared distance from the moved vertex to its planes
+		double   Error;
+	};
+
+	// Packs a pair of vertex indices into a key for an edge, so that both directions give the same key
+	inline uint64_t EdgeKey(uint32_t a, uint32_t b) {
+		return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+	}
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* clusters) {
+	size_t triangleCount = indices.size() / 3;
+	if (clusters != nullptr) {
+		clusters->clear();
+	}
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// Build the vertex to triangle adjacency, stored as one flat array with offsets per vertex
+	std::vector<uint32_t> liveCount(vertexCount, 0);
+	for (uint32_t index : indices) {
+		liveCount[index]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		adjacencyOffsets[ix + 1] = adjacencyOffsets[ix] + liveCount[ix];
+	}
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t ix = 0; ix < indices.size(); ix++) {
+		adjacency[fill[indices[ix]]++] = static_cast<uint32_t>(ix / 3);
+	}
+
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool>     emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	uint32_t time   = cacheSize + 1;
+	uint32_t cursor = 0;
+
+	// When we run out of good candidates, we go back to recently used vertices that still have
+	// triangles, and if there are none of those we take the next vertex in input order
+	auto skipDeadEnd = [&]() -> uint32_t {
+		while (!deadEnds.empty()) {
+			uint32_t vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveCount[vertex] > 0) {
+				return vertex;
+			}
+		}
+		while (cursor < vertexCount) {
+			if (liveCount[cursor] > 0) {
+				return cursor;
+			}
+			cursor++;
+		}
+		return INVALID_INDEX;
+	};
+
+	uint32_t fanningVertex = skipDeadEnd();
+	while (fanningVertex != INVALID_INDEX) {
+		candidates.clear();
+
+		// Emit all the remaining triangles around the fanning vertex
+		for (uint32_t ix = adjacencyOffsets[fanningVertex]; ix < adjacencyOffsets[fanningVertex + 1]; ix++) {
+			uint32_t triangle = adjacency[ix];
+			if (emitted[triangle]) {
+				continue;
+			}
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t vertex = indices[triangle * 3 + corner];
+				result.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveCount[vertex]--;
+				if (time - cacheTime[vertex] > cacheSize) {
+					cacheTime[vertex] = time++;
+				}
+			}
+			emitted[triangle] = true;
+		}
+
+		// Pick the candidate that will still be in the cache after its remaining triangles are
+		// emitted, preferring the one that has been in the cache the longest
+		uint32_t next = INVALID_INDEX;
+		int bestPriority = -1;
+		for (uint32_t vertex : candidates) {
+			if (liveCount[vertex] > 0) {
+				int priority = 0;
+				if (time - cacheTime[vertex] + 2 * liveCount[vertex] <= cacheSize) {
+					priority = static_cast<int>(time - cacheTime[vertex]);
+				}
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					next = vertex;
+				}
+			}
+		}
+
+		// If we hit a dead end, the next triangles will start a new cluster
+		if (next == INVALID_INDEX) {
+			next = skipDeadEnd();
+			if (clusters != nullptr && next != INVALID_INDEX) {
+				clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+			}
+		}
+		fanningVertex = next;
+	}
+
+	if (clusters != nullptr) {
+		clusters->insert(clusters->begin(), 0);
+	}
+	indices = std::move(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusters, const glm::vec3* positions, size_t vertexCount, size_t stride, float threshold, uint32_t cacheSize) {
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// Split the clusters into smaller ones wherever the cache has warmed up enough that starting
+	// again with a cold cache won't push the ACMR over our limit
+	float acmrLimit = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount, cacheSize).ACMR * threshold;
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	std::vector<uint32_t> splits;
+	for (size_t ix = 0; ix < clusters.size(); ix++) {
+		size_t start = clusters[ix];
+		size_t end   = ix + 1 < clusters.size() ? clusters[ix + 1] : triangleCount;
+		splits.push_back(static_cast<uint32_t>(start));
+
+		uint32_t misses = 0;
+		uint32_t triangles = 0;
+		for (size_t triangle = start; triangle < end; triangle++) {
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t vertex = indices[triangle * 3 + corner];
+				if (time - cacheTime[vertex] > cacheSize) {
+					cacheTime[vertex] = time++;
+					misses++;
+				}
+			}
+			triangles++;
+
+			if (triangle + 1 < end && static_cast<float>(misses) / triangles <= acmrLimit) {
+				splits.push_back(static_cast<uint32_t>(triangle + 1));
+				// Bumping the time past the cache size is the same as flushing the cache
+				time += cacheSize + 1;
+				misses = 0;
+				triangles = 0;
+			}
+		}
+	}
+
+	// Find the area weighted center and normal of each cluster, as well as of the whole mesh
+	struct Cluster {
+		uint32_t  Start;
+		uint32_t  End;
+		glm::vec3 Center;
+		glm::vec3 Normal;
+		float     Area;
+		float     SortKey;
+	};
+	std::vector<Cluster> sorted(splits.size());
+	glm::vec3 meshCenter = glm::vec3(0.0f);
+	float     meshArea   = 0.0f;
+	for (size_t ix = 0; ix < splits.size(); ix++) {
+		Cluster& cluster = sorted[ix];
+		cluster.Start  = splits[ix];
+		cluster.End    = ix + 1 < splits.size() ? splits[ix + 1] : static_cast<uint32_t>(triangleCount);
+		cluster.Center = glm::vec3(0.0f);
+		cluster.Normal = glm::vec3(0.0f);
+		cluster.Area   = 0.0f;
+		for (uint32_t triangle = cluster.Start; triangle < cluster.End; triangle++) {
+			const glm::vec3& a = GetPosition(positions, stride, indices[triangle * 3 + 0]);
+			const glm::vec3& b = GetPosition(positions, stride, indices[triangle * 3 + 1]);
+			const glm::vec3& c = GetPosition(positions, stride, indices[triangle * 3 + 2]);
+			glm::vec3 normal = glm::cross(b - a, c - a);
+			float area = glm::length(normal);
+			cluster.Center += (a + b + c) * (area / 3.0f);
+			cluster.Normal += normal;
+			cluster.Area   += area;
+		}
+		meshCenter += cluster.Center;
+		meshArea   += cluster.Area;
+		if (cluster.Area > 0.0f) {
+			cluster.Center /= cluster.Area;
+		}
+	}
+	if (meshArea > 0.0f) {
+		meshCenter /= meshArea;
+	}
+
+	// Clusters that are further out along their normal are more likely to occlude the rest of
+	// the mesh, so they get drawn first
+	for (Cluster& cluster : sorted) {
+		float normalLength = glm::length(cluster.Normal);
+		cluster.SortKey = normalLength > 0.0f ? glm::dot(cluster.Center - meshCenter, cluster.Normal / normalLength) : 0.0f;
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+		return a.SortKey > b.SortKey;
+	});
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (const Cluster& cluster : sorted) {
+		result.insert(result.end(), indices.begin() + cluster.Start * 3, indices.begin() + cluster.End * 3);
+	}
+	indices = std::move(result);
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount) {
+	std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+	uint32_t nextIndex = 0;
+	for (uint32_t& index : indices) {
+		if (remap[index] == INVALID_INDEX) {
+			remap[index] = nextIndex++;
+		}
+		index = remap[index];
+	}
+
+	// Keep any vertices that the indices don't use, but move them out of the way
+	for (uint32_t& index : remap) {
+		if (index == INVALID_INDEX) {
+			index = nextIndex++;
+		}
+	}
+	return remap;
+}
+
+std::vector<uint32_t> MeshOptimizer::SplitForShortIndices(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<VertexArrayObject::SubMesh>& subMeshes, uint32_t maxVertices) {
+	subMeshes.clear();
+	std::vector<uint32_t> sources;
+	if (indices.size() < 3) {
+		return sources;
+	}
+
+	// Maps each original vertex to its index within the current sub-mesh
+	std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+	std::vector<uint32_t> used;
+
+	VertexArrayObject::SubMesh current;
+	current.FirstIndex  = 0;
+	current.IndexCount  = 0;
+	current.BaseVertex  = 0;
+	current.VertexCount = 0;
+
+	for (size_t ix = 0; ix + 2 < indices.size(); ix += 3) {
+		// Count how many vertices this triangle would add to the current sub-mesh
+		uint32_t a = indices[ix], b = indices[ix + 1], c = indices[ix + 2];
+		uint32_t added = (remap[a] == INVALID_INDEX ? 1 : 0) + (remap[b] == INVALID_INDEX && b != a ? 1 : 0) + (remap[c] == INVALID_INDEX && c != a && c != b ? 1 : 0);
+
+		// Start a new sub-mesh if this triangle won't fit in the current one
+		if (current.VertexCount + added > maxVertices) {
+			subMeshes.push_back(current);
+			for (uint32_t vertex : used) {
+				remap[vertex] = INVALID_INDEX;
+			}
+			used.clear();
+			current.FirstIndex  = static_cast<uint32_t>(ix);
+			current.IndexCount  = 0;
+			current.BaseVertex  = static_cast<int32_t>(sources.size());
+			current.VertexCount = 0;
+		}
+
+		for (size_t corner = ix; corner < ix + 3; corner++) {
+			uint32_t vertex = indices[corner];
+			if (remap[vertex] == INVALID_INDEX) {
+				remap[vertex] = current.VertexCount++;
+				sources.push_back(vertex);
+				used.push_back(vertex);
+			}
+			indices[corner] = remap[vertex];
+		}
+		current.IndexCount += 3;
+	}
+	subMeshes.push_back(current);
+
+	return sources;
+}
+
+void MeshOptimizer::SplitLodForShortIndices(std::vector<uint32_t>& indices, size_t vertexCount, const std::vector<VertexArrayObject::SubMesh>& baseSubMeshes,
+	std::vector<uint32_t>& sources, std::vector<VertexArrayObject::SubMesh>& subMeshes, uint32_t maxVertices)
+{
+	subMeshes.clear();
+
+	// Find the base sub-meshes each original vertex was copied into, and its index within them
+	std::vector<std::vector<std::pair<uint32_t, uint32_t>>> locations(vertexCount);
+	for (uint32_t sx = 0; sx < baseSubMeshes.size(); sx++) {
+		const VertexArrayObject::SubMesh& subMesh = baseSubMeshes[sx];
+		for (uint32_t local = 0; local < subMesh.VertexCount; local++) {
+			locations[sources[subMesh.BaseVertex + local]].emplace_back(sx, local);
+		}
+	}
+	auto findLocal = [&](uint32_t vertex, uint32_t subMesh) {
+		for (const auto& [sx, local] : locations[vertex]) {
+			if (sx == subMesh) {
+				return local;
+			}
+		}
+		return INVALID_INDEX;
+	};
+
+	// Sort the triangles into the first base sub-mesh that has all of their vertices, keeping their order
+	std::vector<std::vector<uint32_t>> buckets(baseSubMeshes.size());
+	std::vector<uint32_t> leftover;
+	for (size_t ix = 0; ix + 2 < indices.size(); ix += 3) {
+		uint32_t a = indices[ix], b = indices[ix + 1], c = indices[ix + 2];
+		bool placed = false;
+		for (const auto& [sx, localA] : locations[a]) {
+			uint32_t localB = findLocal(b, sx);
+			uint32_t localC = findLocal(c, sx);
+			if (localB != INVALID_INDEX && localC != INVALID_INDEX) {
+				buckets[sx].insert(buckets[sx].end(), { localA, localB, localC });
+				placed = true;
+				break;
+			}
+		}
+		if (!placed) {
+			leftover.insert(leftover.end(), { a, b, c });
+		}
+	}
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (uint32_t sx = 0; sx < buckets.size(); sx++) {
+		if (buckets[sx].empty()) {
+			continue;
+		}
+		VertexArrayObject::SubMesh subMesh = baseSubMeshes[sx];
+		subMesh.FirstIndex = static_cast<uint32_t>(result.size());
+		subMesh.IndexCount = static_cast<uint32_t>(buckets[sx].size());
+		subMeshes.push_back(subMesh);
+		result.insert(result.end(), buckets[sx].begin(), buckets[sx].end());
+	}
+
+	// Triangles that straddle the base sub-meshes are split on their own, with new vertices
+	if (!leftover.empty()) {
+		std::vector<VertexArrayObject::SubMesh> extra;
+		std::vector<uint32_t> extraSources = SplitForShortIndices(leftover, vertexCount, extra, maxVertices);
+
+		uint32_t firstIndex = static_cast<uint32_t>(result.size());
+		int32_t  baseVertex = static_cast<int32_t>(sources.size());
+		for (VertexArrayObject::SubMesh& subMesh : extra) {
+			subMesh.FirstIndex += firstIndex;
+			subMesh.BaseVertex += baseVertex;
+			subMeshes.push_back(subMesh);
+		}
+		result.insert(result.end(), leftover.begin(), leftover.end());
+		sources.insert(sources.end(), extraSources.begin(), extraSources.end());
+	}
+
+	indices = std::move(result);
+}
+
+std::vector<uint32_t> MeshOptimizer::Simplify(const std::vector<uint32_t>& indices, const glm::vec3* positions, size_t vertexCount, size_t stride, size_t targetIndexCount, float* error) {
+	std::vector<uint32_t> result = indices;
+	double maxError = 0.0;
+	if (error != nullptr) {
+		*error = 0.0f;
+	}
+	if (result.size() <= targetIndexCount || vertexCount == 0) {
+		return result;
+	}
+
+	// Find vertices that share a position (ex: seams where the UVs or normals are split), so that
+	// we can find the borders of the surface instead of the borders of each UV island
+	std::vector<uint32_t> positionId(vertexCount);
+	std::vector<uint32_t> wedgeCount(vertexCount, 0);
+	{
+		std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+		for (uint32_t ix = 0; ix < vertexCount; ix++) {
+			const glm::vec3& p = GetPosition(positions, stride, ix);
+			uint32_t bits[3];
+			memcpy(bits, &p, sizeof(bits));
+			uint64_t hash = (static_cast<uint64_t>(bits[0]) * 73856093ull) ^ (static_cast<uint64_t>(bits[1]) * 19349663ull) ^ (static_cast<uint64_t>(bits[2]) * 83492791ull);
+			std::vector<uint32_t>& bucket = buckets[hash];
+			positionId[ix] = ix;
+			for (uint32_t other : bucket) {
+				if (memcmp(&GetPosition(positions, stride, other), &p, sizeof(glm::vec3)) == 0) {
+					positionId[ix] = other;
+					break;
+				}
+			}
+			if (positionId[ix] == ix) {
+				bucket.push_back(ix);
+			}
+			wedgeCount[positionId[ix]]++;
+		}
+	}
+
+	// Vertices on seams, borders and non-manifold edges are locked in place
+	std::vector<bool> locked(vertexCount, false);
+	{
+		std::unordered_map<uint64_t, uint32_t> edgeUses;
+		edgeUses.reserve(result.size());
+		for (size_t ix = 0; ix < result.size(); ix += 3) {
+			for (int edge = 0; edge < 3; edge++) {
+				uint32_t a = positionId[result[ix + edge]];
+				uint32_t b = positionId[result[ix + (edge + 1) % 3]];
+				edgeUses[EdgeKey(a, b)]++;
+			}
+		}
+		for (size_t ix = 0; ix < result.size(); ix += 3) {
+			for (int edge = 0; edge < 3; edge++) {
+				uint32_t a = result[ix + edge];
+				uint32_t b = result[ix + (edge + 1) % 3];
+				if (edgeUses[EdgeKey(positionId[a], positionId[b])] != 2) {
+					locked[a] = true;
+					locked[b] = true;
+				}
+			}
+		}
+		for (uint32_t ix = 0; ix < vertexCount; ix++) {
+			if (wedgeCount[positionId[ix]] > 1) {
+				locked[ix] = true;
+			}
+		}
+	}
+
+	// Each vertex's quadric is the sum of the planes of the triangles around it
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t ix = 0; ix < result.size(); ix += 3) {
+		const glm::vec3& a = GetPosition(positions, stride, result[ix + 0]);
+		const glm::vec3& b = GetPosition(positions, stride, result[ix + 1]);
+		const glm::vec3& c = GetPosition(positions, stride, result[ix + 2]);
+		glm::vec3 normal = glm::cross(b - a, c - a);
+		float length = glm::length(normal);
+		if (length == 0.0f) {
+			continue;
+		}
+		normal /= length;
+		Quadric plane = Quadric::FromPlane(normal, -glm::dot(normal, a));
+		quadrics[result[ix + 0]] += plane;
+		quadrics[result[ix + 1]] += plane;
+		quadrics[result[ix + 2]] += plane;
+	}
+
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<bool>     touched(vertexCount);
+	std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+	std::vector<uint32_t> triangles;
+	std::vector<Collapse> collapses;
+
+	// Collapse edges in passes, each pass picks the cheapest collapses that don't touch the same triangles
+	while (result.size() > targetIndexCount) {
+		// Build the vertex to triangle adjacency for the current mesh
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (uint32_t index : result) {
+			triangleOffsets[index + 1]++;
+		}
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			triangleOffsets[ix + 1] += triangleOffsets[ix];
+		}
+		triangles.resize(result.size());
+		std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		for (size_t ix = 0; ix < result.size(); ix++) {
+			triangles[fill[result[ix]]++] = static_cast<uint32_t>(ix / 3);
+		}
+
+		// Find the cheapest direction to collapse each edge in
+		// Interior edges are seen by both of their triangles, the duplicate is skipped when applying
+		collapses.clear();
+		for (size_t ix = 0; ix < result.size(); ix += 3) {
+			for (int edge = 0; edge < 3; edge++) {
+				uint32_t a = result[ix + edge];
+				uint32_t b = result[ix + (edge + 1) % 3];
+				Quadric combined = quadrics[a];
+				combined += quadrics[b];
+				double costAToB = locked[a] ? std::numeric_limits<double>::max() : combined.Evaluate(GetPosition(positions, stride, b));
+				double costBToA = locked[b] ? std::numeric_limits<double>::max() : combined.Evaluate(GetPosition(positions, stride, a));
+				if (costAToB == std::numeric_limits<double>::max() && costBToA == std::numeric_limits<double>::max()) {
+					continue;
+				}
+				double weight = combined.Weight > 0.0 ? combined.Weight : 1.0;
+				collapses.push_back(costAToB <= costBToA ?
+					Collapse{ a, b, costAToB, std::sqrt(costAToB / weight) } :
+					Collapse{ b, a, costBToA, std::sqrt(costBToA / weight) });
+			}
+		}
+		if (collapses.empty()) {
+			break;
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+			return a.Cost < b.Cost;
+		});
+
+		// Apply as many collapses as we can in this pass, while keeping each one independent
+		for (uint32_t ix = 0; ix < vertexCount; ix++) {
+			remap[ix] = ix;
+		}
+		std::fill(touched.begin(), touched.end(), false);
+		size_t trianglesLeft = result.size() / 3;
+		size_t targetTriangles = targetIndexCount / 3;
+		size_t applied = 0;
+		for (const Collapse& collapse : collapses) {
+			if (trianglesLeft <= targetTriangles) {
+				break;
+			}
+			if (touched[collapse.From] || touched[collapse.To]) {
+				continue;
+			}
+
+			// Make sure that moving the vertex won't flip any of the triangles around it
+			const glm::vec3& target = GetPosition(positions, stride, collapse.To);
+			bool blocked = false;
+			uint32_t removed = 0;
+			for (uint32_t iy = triangleOffsets[collapse.From]; iy < triangleOffsets[collapse.From + 1] && !blocked; iy++) {
+				const uint32_t* triangle = &result[triangles[iy] * 3];
+				if (triangle[0] == collapse.To || triangle[1] == collapse.To || triangle[2] == collapse.To) {
+					removed++;
+					continue;
+				}
+				for (int corner = 0; corner < 3; corner++) {
+					if (touched[triangle[corner]]) {
+						blocked = true;
+					}
+				}
+				const glm::vec3& a = GetPosition(positions, stride, triangle[0]);
+				const glm::vec3& b = GetPosition(positions, stride, triangle[1]);
+				const glm::vec3& c = GetPosition(positions, stride, triangle[2]);
+				glm::vec3 before = glm::cross(b - a, c - a);
+				glm::vec3 newA = triangle[0] == collapse.From ? target : a;
+				glm::vec3 newB = triangle[1] == collapse.From ? target : b;
+				glm::vec3 newC = triangle[2] == collapse.From ? target : c;
+				glm::vec3 after = glm::cross(newB - newA, newC - newA);
+				if (glm::dot(before, after) <= 0.0f && glm::dot(before, before) > 0.0f) {
+					blocked = true;
+				}
+			}
+			if (blocked || removed == 0) {
+				continue;
+			}
+
+			// Lock the neighbourhood of the collapse for the rest of the pass, since the triangles
+			// around it are about to change
+			for (uint32_t iy = triangleOffsets[collapse.From]; iy < triangleOffsets[collapse.From + 1]; iy++) {
+				const uint32_t* triangle = &result[triangles[iy] * 3];
+				touched[triangle[0]] = true;
+				touched[triangle[1]] = true;
+				touched[triangle[2]] = true;
+			}
+			remap[collapse.From] = collapse.To;
+			quadrics[collapse.To] += quadrics[collapse.From];
+			maxError = std::max(maxError, collapse.Error);
+			trianglesLeft -= removed;
+			applied++;
+		}
+		if (applied == 0) {
+			break;
+		}
+
+		// Apply the collapses, and remove any triangles that have become degenerate
+		size_t write = 0;
+		for (size_t ix = 0; ix < result.size(); ix += 3) {
+			uint32_t a = remap[result[ix + 0]];
+			uint32_t b = remap[result[ix + 1]];
+			uint32_t c = remap[result[ix + 2]];
+			if (a != b && b != c && a != c) {
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+		}
+		result.resize(write);
+	}
+
+	if (error != nullptr) {
+		*error = static_cast<float>(maxError);
+	}
+	return result;
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+	VertexCacheStats result;
+	if (indexCount < 3) {
+		return result;
+	}
+
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	uint32_t uniqueVertices = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		uint32_t vertex = indices[ix];
+		if (cacheTime[vertex] == 0) {
+			uniqueVertices++;
+		}
+		if (time - cacheTime[vertex] > cacheSize) {
+			cacheTime[vertex] = time++;
+			result.VerticesTransformed++;
+		}
+	}
+
+	result.ACMR = static_cast<float>(result.VerticesTransformed) / (indexCount / 3);
+	result.ATVR = static_cast<float>(result.VerticesTransformed) / uniqueVertices;
+	return result;
+}
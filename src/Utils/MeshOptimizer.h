@@ -0,0 +1,131 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "GLM/glm.hpp"
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// Stores the results of simulating the post-transform vertex cache for an index buffer
+/// </summary>
+struct VertexCacheStats {
+	// The number of vertices that missed the cache and had to be run through the vertex shader
+	uint32_t VerticesTransformed = 0;
+	// Average cache miss ratio, the number of vertices transformed per triangle. 0.5 is the best
+	// possible for large regular meshes, 3.0 is the worst
+	float    ACMR = 0.0f;
+	// Average transform to vertex ratio, the number of vertices transformed per unique vertex in
+	// the mesh. 1.0 is the best possible
+	float    ATVR = 0.0f;
+};
+
+/// <summary>
+/// Tools for re-ordering the triangles and vertices of a triangle list so that it is faster for
+/// the GPU to render. These are too slow to run every time a mesh is loaded, and are meant to be
+/// run once when a mesh is converted to our binary format
+///
+/// The usual order is OptimizeVertexCache, then OptimizeOverdraw, then OptimizeVertexFetch
+/// (see MeshBuilder::Optimize)
+/// </summary>
+class MeshOptimizer {
+public:
+	// The size of the FIFO cache we optimize for and simulate, most GPUs behave roughly like this
+	static const uint32_t DEFAULT_CACHE_SIZE = 16;
+	// How much worse the ACMR of a cluster can get in exchange for splitting it for overdraw
+	static constexpr float DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+	// The most vertices a sub-mesh can have and still use 16 bit indices, 0xFFFF is left free
+	// so it can be used as a primitive restart index
+	static const uint32_t MAX_SHORT_INDEX_VERTICES = 65535;
+
+	MeshOptimizer() = delete;
+
+	/// <summary>
+	/// Re-orders the triangles in an index buffer to make better use of the post-transform vertex
+	/// cache, using the Tipsify algorithm from Sander, Nehab and Barczak, "Fast Triangle Reordering
+	/// for Vertex Locality and Reduced Overdraw" (SIGGRAPH 2007)
+	/// </summary>
+	/// <param name="indices">The triangle list indices to re-order in place</param>
+	/// <param name="vertexCount">The number of vertices referenced by the indices</param>
+	/// <param name="cacheSize">The size of the vertex cache to optimize for</param>
+	/// <param name="clusters">If not null, will receive the index of the first triangle of each cluster, where the output jumps to a disconnected part of the mesh</param>
+	static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE, std::vector<uint32_t>* clusters = nullptr);
+
+	/// <summary>
+	/// Re-orders clusters of triangles so that outward facing parts of the mesh are drawn first,
+	/// which reduces overdraw from most view directions. Clusters are further split where the
+	/// vertex cache is warm enough that splitting won't hurt the ACMR by more than the threshold.
+	/// Should be called on the output of OptimizeVertexCache
+	/// </summary>
+	/// <param name="indices">The triangle list indices to re-order in place</param>
+	/// <param name="clusters">The cluster start triangles from OptimizeVertexCache</param>
+	/// <param name="positions">A pointer to the position of the first vertex</param>
+	/// <param name="vertexCount">The number of vertices referenced by the indices</param>
+	/// <param name="stride">The number of bytes between the start of each position</param>
+	/// <param name="threshold">How much the ACMR is allowed to increase, 1.0 will only split at existing clusters</param>
+	/// <param name="cacheSize">The size of the vertex cache to simulate</param>
+	static void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusters, const glm::vec3* positions, size_t vertexCount, size_t stride = sizeof(glm::vec3), float threshold = DEFAULT_OVERDRAW_THRESHOLD, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+	/// <summary>
+	/// Calculates a new order for the vertices so that they are stored in the order they are first
+	/// used by the indices, which makes vertex fetching more cache friendly. The indices are
+	/// updated to the new order, the caller is responsible for moving the vertices
+	/// </summary>
+	/// <param name="indices">The triangle list indices to update in place</param>
+	/// <param name="vertexCount">The number of vertices referenced by the indices</param>
+	/// <returns>A table mapping each old vertex index to its new index. Unused vertices are moved to the end</returns>
+	static std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount);
+
+	/// <summary>
+	/// Splits a triangle list into sub-meshes that each use few enough vertices to be drawn with 16 bit
+	/// indices. Each sub-mesh gets its own contiguous range of vertices, vertices that are shared
+	/// between sub-meshes are duplicated. Works best after OptimizeVertexFetch, since the vertices used
+	/// by each part of the mesh will already be close together
+	/// </summary>
+	/// <param name="indices">The triangle list indices, will be updated to be relative to each sub-mesh's BaseVertex</param>
+	/// <param name="vertexCount">The number of vertices referenced by the indices</param>
+	/// <param name="subMeshes">Will receive the sub-mesh ranges</param>
+	/// <param name="maxVertices">The most vertices a single sub-mesh can use</param>
+	/// <returns>The original index of each vertex in the new vertex buffer. Vertices that are not used are removed</returns>
+	static std::vector<uint32_t> SplitForShortIndices(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<VertexArrayObject::SubMesh>& subMeshes, uint32_t maxVertices = MAX_SHORT_INDEX_VERTICES);
+	/// <summary>
+	/// Splits a simplified version of a mesh whose full detail version has already been split with
+	/// SplitForShortIndices. Triangles are drawn from the full mesh's sub-meshes wherever one of them
+	/// already has all three of their vertices, and only the triangles that don't fit anywhere get
+	/// new sub-meshes with their own copies of the vertices
+	/// </summary>
+	/// <param name="indices">The LOD's triangle list indices into the original vertices, will be grouped by sub-mesh and made relative to each sub-mesh's BaseVertex</param>
+	/// <param name="vertexCount">The number of original vertices</param>
+	/// <param name="baseSubMeshes">The sub-meshes of the full detail mesh</param>
+	/// <param name="sources">The table returned by SplitForShortIndices, vertices for any new sub-meshes are appended to it</param>
+	/// <param name="subMeshes">Will receive the LOD's sub-mesh ranges, FirstIndex is relative to the start of indices</param>
+	/// <param name="maxVertices">The most vertices a single sub-mesh can use</param>
+	static void SplitLodForShortIndices(std::vector<uint32_t>& indices, size_t vertexCount, const std::vector<VertexArrayObject::SubMesh>& baseSubMeshes,
+		std::vector<uint32_t>& sources, std::vector<VertexArrayObject::SubMesh>& subMeshes, uint32_t maxVertices = MAX_SHORT_INDEX_VERTICES);
+
+	/// <summary>
+	/// Simplifies a triangle list by collapsing edges in order of their quadric error (Garland and
+	/// Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997). Vertices only ever
+	/// collapse onto other existing vertices, so the result can share the original vertex buffer.
+	/// Vertices on open borders or attribute seams (where more than one vertex shares a position)
+	/// are never moved, so the result will not crack, but meshes with many seams will not
+	/// simplify as far
+	/// </summary>
+	/// <param name="indices">The triangle list indices to simplify</param>
+	/// <param name="positions">A pointer to the position of the first vertex</param>
+	/// <param name="vertexCount">The number of vertices referenced by the indices</param>
+	/// <param name="stride">The number of bytes between the start of each position</param>
+	/// <param name="targetIndexCount">The number of indices to aim for, the result may have more if the mesh can't be simplified further</param>
+	/// <param name="error">If not null, will receive an estimate of how far the surface has moved, in the same units as the positions</param>
+	/// <returns>The indices of the simplified mesh</returns>
+	static std::vector<uint32_t> Simplify(const std::vector<uint32_t>& indices, const glm::vec3* positions, size_t vertexCount, size_t stride, size_t targetIndexCount, float* error = nullptr);
+
+	/// <summary>
+	/// Simulates a FIFO post-transform vertex cache to measure how many times the vertex shader
+	/// will be run for an index buffer
+	/// </summary>
+	/// <param name="indices">A pointer to the triangle list indices</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="vertexCount">The number of vertices referenced by the indices</param>
+	/// <param name="cacheSize">The size of the vertex cache to simulate</param>
+	static VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+};
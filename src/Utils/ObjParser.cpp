@@ -0,0 +1,607 @@
+#include "Utils/ObjParser.h"
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <algorithm>
+
+#include "Utils/MappedFile.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/StringUtils.h"
+#include "Logging.h"
+
+// We construct a key using a bitmask of the attribute indices, this lets us quickly look up a combination
+// of attributes to see if it's already been added
+// Note that this limits us to 2,097,150 unique attributes for positions, normals and textures
+static const uint64_t VERTEX_KEY_MASK = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
+
+inline uint64_t MakeVertexKey(const glm::ivec3& vertex) {
+	// Shift up by one so that missing attributes (-1) become 0
+	return ((static_cast<uint64_t>(vertex.x + 1) & VERTEX_KEY_MASK) << 42) |
+		((static_cast<uint64_t>(vertex.y + 1) & VERTEX_KEY_MASK) << 21) |
+		(static_cast<uint64_t>(vertex.z + 1) & VERTEX_KEY_MASK);
+}
+
+// Converts a 1 based OBJ index into a zero based index, -1 if the index was not present (0)
+// The OBJ format can have negative values, which are a reference from the last added attributes
+inline int ResolveIndex(int index, size_t count) {
+	return index < 0 ? static_cast<int>(count) + index : index - 1;
+}
+
+// Whitespace that can separate tokens within a line
+inline bool IsSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* SkipSpaces(const char* ptr, const char* end) {
+	while (ptr < end && IsSpace(*ptr)) {
+		ptr++;
+	}
+	return ptr;
+}
+
+// Returns a pointer to the first character of the next line
+inline const char* SkipLine(const char* ptr, const char* end) {
+	const char* newline = static_cast<const char*>(memchr(ptr, '\n', end - ptr));
+	return newline == nullptr ? end : newline + 1;
+}
+
+inline const char* SkipToken(const char* ptr, const char* end) {
+	while (ptr < end && !IsSpace(*ptr) && *ptr != '\n') {
+		ptr++;
+	}
+	return ptr;
+}
+
+inline const char* ParseFloat(const char* ptr, const char* end, float& value) {
+	ptr = SkipSpaces(ptr, end);
+	// from_chars does not accept a leading plus sign
+	if (ptr < end && *ptr == '+') {
+		ptr++;
+	}
+	std::from_chars_result result = std::from_chars(ptr, end, value);
+	if (result.ec != std::errc()) {
+		value = 0.0f;
+		return SkipToken(ptr, end);
+	}
+	return result.ptr;
+}
+
+inline const char* ParseIndex(const char* ptr, const char* end, int& value) {
+	std::from_chars_result result = std::from_chars(ptr, end, value);
+	if (result.ec != std::errc()) {
+		value = 0;
+		return ptr;
+	}
+	return result.ptr;
+}
+
+void ObjData::Clear() {
+	Positions.clear();
+	Normals.clear();
+	UVs.clear();
+	Vertices.clear();
+	Indices.clear();
+}
+
+// Files smaller than this are not worth splitting up between threads
+static const size_t MIN_PARALLEL_FILE_SIZE = 4 * 1024 * 1024;
+
+// Tokenizes the lines in [begin, end) and forwards the records to a handler, which should implement
+// Position(vec3), Normal(vec3), UV(vec2), FaceVertex(int, int, int) with the raw OBJ indices, and FaceEnd()
+// Both the serial and parallel parsers use this, so they will always read the same data from a file
+template <typename Handler>
+static void ParseLines(const char* begin, const char* end, Handler& handler) {
+	const char* ptr = begin;
+	while (ptr < end) {
+		ptr = SkipSpaces(ptr, end);
+		if (ptr >= end) { break; }
+
+		const char c0 = ptr[0];
+		const char c1 = ptr + 1 < end ? ptr[1] : '\n';
+		const char c2 = ptr + 2 < end ? ptr[2] : '\n';
+
+		// The v command defines a vertex's position
+		if (c0 == 'v' && IsSpace(c1)) {
+			glm::vec3 position;
+			ptr = ParseFloat(ptr + 1, end, position.x);
+			ptr = ParseFloat(ptr, end, position.y);
+			ptr = ParseFloat(ptr, end, position.z);
+			handler.Position(position);
+		}
+		// The vn command defines a vertex normal
+		else if (c0 == 'v' && c1 == 'n' && IsSpace(c2)) {
+			glm::vec3 normal;
+			ptr = ParseFloat(ptr + 2, end, normal.x);
+			ptr = ParseFloat(ptr, end, normal.y);
+			ptr = ParseFloat(ptr, end, normal.z);
+			handler.Normal(normal);
+		}
+		// The vt command defines a texture coordinate
+		else if (c0 == 'v' && c1 == 't' && IsSpace(c2)) {
+			glm::vec2 uv;
+			ptr = ParseFloat(ptr + 2, end, uv.x);
+			ptr = ParseFloat(ptr, end, uv.y);
+			handler.UV(uv);
+		}
+		// The f command defines a polygon in the mesh
+		else if (c0 == 'f' && IsSpace(c1)) {
+			ptr++;
+			while (true) {
+				ptr = SkipSpaces(ptr, end);
+				if (ptr >= end || *ptr == '\n' || *ptr == '#') { break; }
+
+				// Load in the indices, split up by slashes (v, v/vt, v//vn or v/vt/vn)
+				int position = 0, uv = 0, normal = 0;
+				const char* next = ParseIndex(ptr, end, position);
+				if (next == ptr) {
+					// Not a valid face vertex, skip over it
+					ptr = SkipToken(ptr, end);
+					continue;
+				}
+				ptr = next;
+				if (ptr < end && *ptr == '/') {
+					ptr++;
+					if (ptr < end && *ptr != '/') {
+						ptr = ParseIndex(ptr, end, uv);
+					}
+					if (ptr < end && *ptr == '/') {
+						ptr = ParseIndex(ptr + 1, end, normal);
+					}
+				}
+				handler.FaceVertex(position, uv, normal);
+			}
+			handler.FaceEnd();
+		}
+
+		// Ignore comments, unsupported commands and anything left on the line
+		ptr = SkipLine(ptr, end);
+	}
+}
+
+// Counts the records in [begin, end) so that we can reserve space for them
+struct ObjRecordCounts {
+	size_t Positions = 0;
+	size_t Normals   = 0;
+	size_t UVs       = 0;
+	size_t Faces     = 0;
+
+	ObjRecordCounts(const char* begin, const char* end) {
+		for (const char* line = begin; line < end; line = SkipLine(line, end)) {
+			if (end - line < 2) { continue; }
+			if (line[0] == 'v') {
+				if (IsSpace(line[1])) { Positions++; }
+				else if (line[1] == 'n') { Normals++; }
+				else if (line[1] == 't') { UVs++; }
+			} else if (line[0] == 'f' && IsSpace(line[1])) {
+				Faces++;
+			}
+		}
+	}
+};
+
+// Handler for the single threaded parser, de-duplicates vertices and builds the triangles as faces are read
+struct SerialObjHandler {
+	ObjData& Result;
+	// Maps a key generated from obj indices to a vertex index that
+	// has been added to the mesh already
+	std::unordered_map<uint64_t, uint32_t> VertexMap;
+	uint32_t First = 0, Previous = 0;
+	int      Count = 0;
+
+	SerialObjHandler(ObjData& result) : Result(result) {}
+
+	void Position(const glm::vec3& value) { Result.Positions.push_back(value); }
+	void Normal(const glm::vec3& value) { Result.Normals.push_back(value); }
+	void UV(const glm::vec2& value) { Result.UVs.push_back(value); }
+
+	void FaceVertex(int position, int uv, int normal) {
+		glm::ivec3 vertex = glm::ivec3(
+			ResolveIndex(position, Result.Positions.size()),
+			ResolveIndex(uv, Result.UVs.size()),
+			ResolveIndex(normal, Result.Normals.size())
+		);
+
+		// Find the index associated with the combination of attributes, or add a new vertex
+		uint32_t index;
+		uint64_t key = MakeVertexKey(vertex);
+		auto it = VertexMap.find(key);
+		if (it != VertexMap.end()) {
+			index = it->second;
+		} else {
+			index = static_cast<uint32_t>(Result.Vertices.size());
+			Result.Vertices.push_back(vertex);
+			VertexMap.emplace(key, index);
+		}
+
+		// Split polygons into a triangle fan, for quads this gives us (0, 1, 2) and (0, 2, 3)
+		if (Count == 0) {
+			First = index;
+		} else if (Count >= 2) {
+			Result.Indices.push_back(First);
+			Result.Indices.push_back(Previous);
+			Result.Indices.push_back(index);
+		}
+		Previous = index;
+		Count++;
+	}
+
+	void FaceEnd() { Count = 0; }
+};
+
+// Handler for a single chunk of the file in the parallel parser. Attributes are stored as they are read, and
+// face vertices are resolved relative to the start of the chunk, since we don't know how many attributes came
+// before us yet. Vertices are de-duplicated after all the chunks have been parsed
+struct ChunkObjHandler {
+	// Flags for face vertex attributes that are relative to the start of the chunk (negative OBJ indices)
+	static const uint8_t RELATIVE_POSITION = 1 << 0;
+	static const uint8_t RELATIVE_UV       = 1 << 1;
+	static const uint8_t RELATIVE_NORMAL   = 1 << 2;
+
+	std::vector<glm::vec3>  Positions;
+	std::vector<glm::vec3>  Normals;
+	std::vector<glm::vec2>  UVs;
+	std::vector<glm::ivec3> FaceVertices;
+	std::vector<uint8_t>    FaceVertexFlags;
+	// The number of vertices in each face, in the order they were read
+	std::vector<uint32_t>   FaceSizes;
+	uint32_t                CurrentFaceSize = 0;
+	size_t                  NumIndices = 0;
+
+	// Offsets of this chunk's data in the merged arrays, calculated after parsing
+	size_t FirstPosition = 0, FirstNormal = 0, FirstUV = 0, FirstFaceVertex = 0, FirstIndex = 0;
+
+	void Position(const glm::vec3& value) { Positions.push_back(value); }
+	void Normal(const glm::vec3& value) { Normals.push_back(value); }
+	void UV(const glm::vec2& value) { UVs.push_back(value); }
+
+	void FaceVertex(int position, int uv, int normal) {
+		uint8_t flags = 0;
+		flags |= position < 0 ? RELATIVE_POSITION : 0;
+		flags |= uv       < 0 ? RELATIVE_UV       : 0;
+		flags |= normal   < 0 ? RELATIVE_NORMAL   : 0;
+		FaceVertices.push_back(glm::ivec3(
+			ResolveIndex(position, Positions.size()),
+			ResolveIndex(uv, UVs.size()),
+			ResolveIndex(normal, Normals.size())
+		));
+		FaceVertexFlags.push_back(flags);
+		CurrentFaceSize++;
+	}
+
+	void FaceEnd() {
+		FaceSizes.push_back(CurrentFaceSize);
+		NumIndices += CurrentFaceSize >= 3 ? (CurrentFaceSize - 2) * 3 : 0;
+		CurrentFaceSize = 0;
+	}
+};
+
+// Mixes the bits of a vertex key so that we can spread keys evenly between shards
+inline uint64_t HashVertexKey(uint64_t key) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+	return key;
+}
+
+static void ParseParallel(const char* begin, const char* end, ObjData& result, uint32_t numThreads) {
+	ThreadPool& pool = ThreadPool::Get();
+
+	// Split the file into chunks at line boundaries, we use a few chunks per thread so that
+	// threads that finish early can pick up more work
+	const size_t numChunks = static_cast<size_t>(numThreads) * 4;
+	const size_t chunkSize = (end - begin) / numChunks + 1;
+	std::vector<const char*> chunkStarts;
+	chunkStarts.push_back(begin);
+	while (chunkStarts.back() < end) {
+		const char* next = chunkStarts.back() + chunkSize;
+		chunkStarts.push_back(next >= end ? end : SkipLine(next, end));
+	}
+	std::vector<ChunkObjHandler> chunks(chunkStarts.size() - 1);
+
+	// Tokenize all the chunks in parallel
+	pool.ParallelFor(chunks.size(), [&](size_t ix) {
+		ObjRecordCounts counts(chunkStarts[ix], chunkStarts[ix + 1]);
+		ChunkObjHandler& chunk = chunks[ix];
+		chunk.Positions.reserve(counts.Positions);
+		chunk.Normals.reserve(counts.Normals);
+		chunk.UVs.reserve(counts.UVs);
+		chunk.FaceSizes.reserve(counts.Faces);
+		chunk.FaceVertices.reserve(counts.Faces * 3);
+		chunk.FaceVertexFlags.reserve(counts.Faces * 3);
+		ParseLines(chunkStarts[ix], chunkStarts[ix + 1], chunk);
+	});
+
+	// Determine where each chunk's data goes in the merged arrays
+	size_t numPositions = 0, numNormals = 0, numUVs = 0, numFaceVertices = 0, numIndices = 0;
+	for (auto& chunk : chunks) {
+		chunk.FirstPosition   = numPositions;
+		chunk.FirstNormal     = numNormals;
+		chunk.FirstUV         = numUVs;
+		chunk.FirstFaceVertex = numFaceVertices;
+		chunk.FirstIndex      = numIndices;
+		numPositions    += chunk.Positions.size();
+		numNormals      += chunk.Normals.size();
+		numUVs          += chunk.UVs.size();
+		numFaceVertices += chunk.FaceVertices.size();
+		numIndices      += chunk.NumIndices;
+	}
+	result.Positions.resize(numPositions);
+	result.Normals.resize(numNormals);
+	result.UVs.resize(numUVs);
+	result.Indices.resize(numIndices);
+
+	// Copy the attributes into place, and resolve the face vertices to absolute indices
+	const uint32_t numShards = numThreads;
+	std::vector<glm::ivec3> faceVertices(numFaceVertices);
+	std::vector<uint64_t>   keys(numFaceVertices);
+	std::vector<uint8_t>    shards(numFaceVertices);
+	pool.ParallelFor(chunks.size(), [&](size_t ix) {
+		ChunkObjHandler& chunk = chunks[ix];
+		std::copy(chunk.Positions.begin(), chunk.Positions.end(), result.Positions.begin() + chunk.FirstPosition);
+		std::copy(chunk.Normals.begin(), chunk.Normals.end(), result.Normals.begin() + chunk.FirstNormal);
+		std::copy(chunk.UVs.begin(), chunk.UVs.end(), result.UVs.begin() + chunk.FirstUV);
+
+		for (size_t vx = 0; vx < chunk.FaceVertices.size(); vx++) {
+			glm::ivec3 vertex = chunk.FaceVertices[vx];
+			uint8_t    flags  = chunk.FaceVertexFlags[vx];
+			if (flags & ChunkObjHandler::RELATIVE_POSITION) { vertex.x += static_cast<int>(chunk.FirstPosition); }
+			if (flags & ChunkObjHandler::RELATIVE_UV)       { vertex.y += static_cast<int>(chunk.FirstUV); }
+			if (flags & ChunkObjHandler::RELATIVE_NORMAL)   { vertex.z += static_cast<int>(chunk.FirstNormal); }
+
+			size_t index = chunk.FirstFaceVertex + vx;
+			faceVertices[index] = vertex;
+			keys[index]         = MakeVertexKey(vertex);
+			shards[index]       = static_cast<uint8_t>(HashVertexKey(keys[index]) % numShards);
+		}
+
+		// We no longer need the chunk's copy of the data
+		chunk.Positions = std::vector<glm::vec3>();
+		chunk.Normals   = std::vector<glm::vec3>();
+		chunk.UVs       = std::vector<glm::vec2>();
+		chunk.FaceVertices    = std::vector<glm::ivec3>();
+		chunk.FaceVertexFlags = std::vector<uint8_t>();
+	});
+
+	// De-duplicate the vertices. Each shard owns a subset of the keys, and finds the first face vertex
+	// that uses each of it's keys. Since every key belongs to exactly one shard, the shards can run in
+	// parallel without any locking
+	std::vector<uint32_t> firstUse(numFaceVertices);
+	pool.ParallelFor(numShards, [&](size_t shard) {
+		std::unordered_map<uint64_t, uint32_t> vertexMap;
+		vertexMap.reserve(numPositions / numShards + 1);
+		for (size_t ix = 0; ix < numFaceVertices; ix++) {
+			if (shards[ix] == shard) {
+				firstUse[ix] = vertexMap.try_emplace(keys[ix], static_cast<uint32_t>(ix)).first->second;
+			}
+		}
+	});
+
+	// Vertices are numbered in the order they are first used, which matches the single threaded parser
+	std::vector<uint32_t> remap(numFaceVertices);
+	result.Vertices.reserve(numPositions);
+	for (size_t ix = 0; ix < numFaceVertices; ix++) {
+		if (firstUse[ix] == ix) {
+			remap[ix] = static_cast<uint32_t>(result.Vertices.size());
+			result.Vertices.push_back(faceVertices[ix]);
+		} else {
+			remap[ix] = remap[firstUse[ix]];
+		}
+	}
+
+	// Build the triangle fans for each face
+	pool.ParallelFor(chunks.size(), [&](size_t ix) {
+		ChunkObjHandler& chunk = chunks[ix];
+		size_t vertex = chunk.FirstFaceVertex;
+		uint32_t* indices = result.Indices.data() + chunk.FirstIndex;
+		for (uint32_t faceSize : chunk.FaceSizes) {
+			for (uint32_t fx = 2; fx < faceSize; fx++) {
+				*indices++ = remap[vertex];
+				*indices++ = remap[vertex + fx - 1];
+				*indices++ = remap[vertex + fx];
+			}
+			vertex += faceSize;
+		}
+	});
+}
+
+void ObjParser::ParseFile(const std::string& filename, ObjData& result, uint32_t numThreads) {
+	MappedFile file(filename);
+
+	// If our file fails to open, we will throw an error
+	if (!file.IsOpen()) {
+		throw std::runtime_error("Failed to open file");
+	}
+
+	const char* data = reinterpret_cast<const char*>(file.GetData());
+	Parse(data, data + file.GetSize(), result, numThreads);
+}
+
+void ObjParser::Parse(const char* begin, const char* end, ObjData& result, uint32_t numThreads) {
+	result.Clear();
+
+	if (numThreads == 0) {
+		numThreads = ThreadPool::Get().GetNumThreads();
+	}
+	// We store shard IDs in a byte, so we can't have more shards than that
+	numThreads = numThreads > 255 ? 255 : numThreads;
+
+	if (numThreads > 1 && static_cast<size_t>(end - begin) >= MIN_PARALLEL_FILE_SIZE) {
+		ParseParallel(begin, end, result, numThreads);
+		return;
+	}
+
+	// Do a quick pass over the lines to count how much space we need, so we never re-allocate
+	ObjRecordCounts counts(begin, end);
+	result.Positions.reserve(counts.Positions);
+	result.Normals.reserve(counts.Normals);
+	result.UVs.reserve(counts.UVs);
+	result.Vertices.reserve(counts.Positions);
+	result.Indices.reserve(counts.Faces * 3);
+
+	SerialObjHandler handler(result);
+	handler.VertexMap.reserve(counts.Positions);
+	ParseLines(begin, end, handler);
+}
+
+// A copy of the original iostream based loader from OptimizedObjLoader, kept as the reference for Benchmark. This
+// deliberately keeps the original index handling, so it must not be changed to match the parser above
+static void ParseFileBaseline(const std::string& filename, ObjData& result) {
+	result.Clear();
+
+	// Open our file in binary mode
+	std::ifstream file;
+	file.open(filename, std::ios::binary);
+
+	// If our file fails to open, we will throw an error
+	if (!file) {
+		throw std::runtime_error("Failed to open file");
+	}
+
+	// Maps a key generated from obj indices to a vertex index that
+	// has been added to the mesh already
+	std::unordered_map<uint64_t, uint32_t> vertexMap;
+
+	// Storage for temporary data
+	std::string line;
+	glm::vec3 vecData;
+	glm::ivec3 vertexIndices;
+
+	// Read and process the entire file
+	while (file.peek() != EOF) {
+		// Read in the first part of the line (ex: f, v, vn, etc...)
+		std::string command;
+		file >> command;
+
+		// We will ignore the rest of the line for comment lines
+		if (command == "#") {
+			std::getline(file, line);
+		}
+		else if (command == "v") {
+			file >> vecData.x >> vecData.y >> vecData.z;
+			result.Positions.push_back(vecData);
+		}
+		else if (command == "vn") {
+			file >> vecData.x >> vecData.y >> vecData.z;
+			result.Normals.push_back(vecData);
+		}
+		else if (command == "vt") {
+			file >> vecData.x >> vecData.y;
+			result.UVs.push_back(glm::vec2(vecData));
+		}
+		else if (command == "f") {
+			// Read the rest of the line from the file
+			std::getline(file, line);
+			// Trim whitespace from either end of the line
+			StringTools::Trim(line);
+			// Create a string stream so we can use streaming operators on it
+			std::stringstream stream = std::stringstream(line);
+
+			uint32_t edges[4];
+			int ix = 0;
+			// Iterate over up to 4 sets of attributes
+			for (; ix < 4; ix++) {
+				if (stream.peek() != EOF) {
+					// Load in the faces, split up by slashes
+					char tempChar;
+					vertexIndices = glm::ivec3(0);
+					stream >> vertexIndices.x >> tempChar >> vertexIndices.y >> tempChar >> vertexIndices.z;
+					// The OBJ format can have negative values, which are a reference from the last added attributes
+					if (vertexIndices.x < 0) { vertexIndices.x = static_cast<int>(result.Positions.size()) + 1 + vertexIndices.x; }
+					if (vertexIndices.y < 0) { vertexIndices.y = static_cast<int>(result.UVs.size())       + 1 + vertexIndices.y; }
+					if (vertexIndices.z < 0) { vertexIndices.z = static_cast<int>(result.Normals.size())   + 1 + vertexIndices.z; }
+
+					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
+					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
+
+					auto it = vertexMap.find(key);
+					if (it != vertexMap.end()) {
+						edges[ix] = it->second;
+					} else {
+						result.Vertices.push_back(vertexIndices - glm::ivec3(1));
+						uint32_t index = static_cast<uint32_t>(result.Vertices.size()) - 1;
+						vertexMap[key] = index;
+						edges[ix] = index;
+					}
+				}
+				// We've reached the end of the line, break out of the loop
+				else { break; }
+			}
+
+			// Handling for triangle faces
+			if (ix == 3) {
+				result.Indices.push_back(edges[0]);
+				result.Indices.push_back(edges[1]);
+				result.Indices.push_back(edges[2]);
+			}
+			// Handling for quad faces
+			else if (ix == 4) {
+				result.Indices.push_back(edges[0]);
+				result.Indices.push_back(edges[1]);
+				result.Indices.push_back(edges[2]);
+
+				result.Indices.push_back(edges[0]);
+				result.Indices.push_back(edges[2]);
+				result.Indices.push_back(edges[3]);
+			}
+		}
+	}
+}
+
+// Checks whether two parse results describe the same mesh
+static bool ObjDataMatches(const ObjData& a, const ObjData& b) {
+	return
+		a.Positions.size() == b.Positions.size() &&
+		a.Normals.size() == b.Normals.size() &&
+		a.UVs.size() == b.UVs.size() &&
+		memcmp(a.Positions.data(), b.Positions.data(), a.Positions.size() * sizeof(glm::vec3)) == 0 &&
+		a.Vertices == b.Vertices &&
+		a.Indices == b.Indices;
+}
+
+void ObjParser::Benchmark(const std::string& filename, int iterations) {
+	using Clock = std::chrono::high_resolution_clock;
+	iterations = iterations < 1 ? 1 : iterations;
+
+	ObjData serialResult;
+	ObjData parallelResult;
+	ObjData baselineResult;
+
+	double serialTime = 0.0;
+	double parallelTime = 0.0;
+	double baselineTime = 0.0;
+	for (int ix = 0; ix < iterations; ix++) {
+		Clock::time_point start = Clock::now();
+		ParseFile(filename, serialResult);
+		Clock::time_point serialEnd = Clock::now();
+		ParseFile(filename, parallelResult, 0);
+		Clock::time_point parallelEnd = Clock::now();
+		ParseFileBaseline(filename, baselineResult);
+		Clock::time_point baselineEnd = Clock::now();
+
+		serialTime   += std::chrono::duration<double>(serialEnd - start).count();
+		parallelTime += std::chrono::duration<double>(parallelEnd - serialEnd).count();
+		baselineTime += std::chrono::duration<double>(baselineEnd - parallelEnd).count();
+	}
+	serialTime   /= iterations;
+	parallelTime /= iterations;
+	baselineTime /= iterations;
+
+	LOG_INFO("OBJ parser benchmark for \"{}\" ({} vertices, {} indices, {} iterations)", filename, serialResult.Vertices.size(), serialResult.Indices.size(), iterations);
+	LOG_INFO("\tiostream parser: {:.3f} ms", baselineTime * 1000.0);
+	LOG_INFO("\tObjParser:       {:.3f} ms ({:.1f}x faster)", serialTime * 1000.0, serialTime > 0.0 ? baselineTime / serialTime : 0.0);
+	LOG_INFO("\tObjParser (MT):  {:.3f} ms ({:.1f}x faster, {} threads)", parallelTime * 1000.0, parallelTime > 0.0 ? baselineTime / parallelTime : 0.0, ThreadPool::Get().GetNumThreads());
+
+	// The parallel parser must always match the single threaded one exactly
+	if (!ObjDataMatches(serialResult, parallelResult)) {
+		LOG_ERROR("\tParallel ObjParser produced different results than the serial one!");
+	}
+	// The iostream parser only reads v/vt/vn face vertices and up to 4 vertices per face, so other files are expected to differ
+	if (!ObjDataMatches(serialResult, baselineResult)) {
+		LOG_WARN("\tObjParser produced different results than the iostream parser");
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "GLM/glm.hpp"
+
+/// <summary>
+/// The raw data parsed from an OBJ file. Vertices are de-duplicated, so each unique
+/// combination of position, UV and normal appears once in Vertices
+/// </summary>
+struct ObjData {
+	std::vector<glm::vec3>  Positions;
+	std::vector<glm::vec3>  Normals;
+	std::vector<glm::vec2>  UVs;
+	// Zero based indices into the position, UV and normal arrays, -1 if the vertex does not use the attribute
+	std::vector<glm::ivec3> Vertices;
+	// Triangle list indices into Vertices
+	std::vector<uint32_t>   Indices;
+
+	void Clear();
+};
+
+/// <summary>
+/// Parses the geometry from OBJ files. The file is memory mapped and tokenized in place using
+/// std::from_chars, so it avoids the locale handling and allocations of iostreams
+///
+/// Supports v, vt, vn and f commands, negative (relative) indices, and v, v/vt, v//vn or v/vt/vn
+/// face vertices. Polygons with more than 3 vertices are split into triangle fans, so quads are
+/// split along their 0-2 diagonal
+/// </summary>
+class ObjParser {
+public:
+	ObjParser() = delete;
+
+	/// <summary>
+	/// Parses an OBJ file from disk, throws a runtime_error if the file cannot be opened
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="result">The object to store the parsed data in, any existing data is cleared</param>
+	/// <param name="numThreads">The number of threads to parse large files with, or 0 to use the whole thread pool</param>
+	static void ParseFile(const std::string& filename, ObjData& result, uint32_t numThreads = 1);
+	/// <summary>
+	/// Parses OBJ data from a block of memory. If more than one thread is requested and the data is
+	/// large enough, the data is split into chunks at line boundaries which are parsed on the thread
+	/// pool, then merged. The result is identical to parsing with a single thread
+	/// </summary>
+	/// <param name="begin">A pointer to the first character of the OBJ data</param>
+	/// <param name="end">A pointer one past the last character of the OBJ data</param>
+	/// <param name="result">The object to store the parsed data in, any existing data is cleared</param>
+	/// <param name="numThreads">The number of threads to parse large files with, or 0 to use the whole thread pool</param>
+	static void Parse(const char* begin, const char* end, ObjData& result, uint32_t numThreads = 1);
+
+	/// <summary>
+	/// Times ParseFile, both single threaded and on the whole thread pool, against the original
+	/// iostream based OBJ loader, and logs the average times and whether the results match
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to benchmark with</param>
+	/// <param name="iterations">The number of times to parse the file with each parser</param>
+	static void Benchmark(const std::string& filename, int iterations = 5);
+};
@@ -1,14 +1,20 @@
 #include "Utils/OptimizedObjLoader.h"
 
 #include "ObjLoader.h"
+#include "Utils/ObjParser.h"
+#include "Utils/MeshOptimizer.h"
 
 #include <string>
 #include <sstream>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <cstring>
+#include <cstddef>
+#include <thread>
 
 #include "Utils/StringUtils.h"
+#include "Utils/MappedFile.h"
 #include "GLFW/glfw3.h"
 #include "Logging.h"
 
@@ -18,6 +24,16 @@ const std::string binaryExtension = ".bin";
 namespace fs = std::filesystem;
 
 VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& filename) {
+	std::string binPath = PrepareFile(filename);
+	if (binPath.empty()) {
+		LOG_WARN("Cannot load model from \"{}\"", filename);
+		return nullptr;
+	}
+	// Load the corresponding binary file
+	return _LoadFromBinFile(binPath);
+}
+
+std::string OptimizedObjLoader::PrepareFile(const std::string& filename) {
 	// Get the file extension and lowercase it
 	fs::path filePath = std::filesystem::path(filename);
 	std::string extension = filePath.extension().string();
@@ -27,25 +43,57 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 	if (extension == ".obj") {
 		// Get the binary path
 		fs::path binPath = filePath.replace_extension(binaryExtension);
-		// If the file does not exist, convert the OBJ file to a binary file
-		if (!fs::exists(binPath)) {
-			ConvertToBinary(filename, binPath.string());
+		std::string key = fs::absolute(binPath).lexically_normal().string();
+
+		// Several resources may use the same OBJ, so only the first thread to get here converts it and the rest wait
+		std::shared_future<void> conversion;
+		std::promise<void> promise;
+		bool isConverting = false;
+		{
+			std::lock_guard<std::mutex> lock(__conversionMutex);
+			auto it = __conversions.find(key);
+			if (it != __conversions.end()) {
+				conversion = it->second;
+			}
+			// If the file does not exist, we're the one converting the OBJ file to a binary file
+			else if (!fs::exists(binPath)) {
+				__conversions[key] = promise.get_future().share();
+				isConverting = true;
+			}
 		}
-		// Load the corresponding binary file
-		return _LoadFromBinFile(binPath.string());
+
+		if (isConverting) {
+			try {
+				#ifdef PACKED_VERTICES
+				ConvertToBinary(filename, binPath.string(), true);
+				#else
+				ConvertToBinary(filename, binPath.string());
+				#endif
+				promise.set_value();
+			} catch (...) {
+				promise.set_exception(std::current_exception());
+				std::lock_guard<std::mutex> lock(__conversionMutex);
+				__conversions.erase(key);
+				throw;
+			}
+			std::lock_guard<std::mutex> lock(__conversionMutex);
+			__conversions.erase(key);
+		} else if (conversion.valid()) {
+			conversion.get();
+		}
+		return binPath.string();
 	} 
-	// Load our fancy binary files
+	// Our fancy binary files can be loaded as is
 	else if (extension == ".bin") {
-		return _LoadFromBinFile(filename);
+		return filename;
 	}
 	// We've never met this extension in our life
 	else {
-		LOG_WARN("Cannot load model from \"{}\"", filename);
-		return nullptr;
+		return "";
 	}
 }
 
-void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::string& outFile) {
+void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::string& outFile, bool packVertices) {
 	// Load in the input file
 	MeshBuilder<VertexPosNormTexColTangents>* mesh = _LoadFromObjFile(inFile);
 
@@ -62,8 +110,32 @@ void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::s
 		outFileName = path.string();
 	}
 
+	// Re-order the mesh for the vertex cache before we store it, so we only pay for this once
+	VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh->GetIndexDataPtr(), mesh->GetIndexCount(), mesh->GetVertexCount());
+	mesh->Optimize();
+	VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(mesh->GetIndexDataPtr(), mesh->GetIndexCount(), mesh->GetVertexCount());
+	LOG_INFO("Optimized \"{}\" for the vertex cache: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f} ({} -> {} vertex shader invocations)",
+		inFile, before.ACMR, after.ACMR, before.ATVR, after.ATVR, before.VerticesTransformed, after.VerticesTransformed);
+
+	// Generate the simplified versions of the mesh that will be drawn at a distance
+	uint32_t lodCount = mesh->GenerateLods();
+	if (lodCount > 1) {
+		const auto& lods = mesh->GetLods();
+		LOG_INFO("Generated {} LODs for \"{}\", coarsest has {} triangles with an error of {:.3f}",
+			lodCount, inFile, lods.back().IndexCount / 3, lods.back().Error);
+	}
+
+	// Large meshes are split up if it lets us use 16 bit indices
+	if (mesh->SplitForShortIndices()) {
+		LOG_INFO("Split \"{}\" into {} sub-meshes for 16 bit indices", inFile, mesh->GetSubMeshes().size());
+	}
+
 	// Save the mesh to the file
-	SaveBinaryFile(*mesh, outFileName);
+	if (packVertices) {
+		SavePackedBinaryFile(*mesh, outFileName);
+	} else {
+		SaveBinaryFile(*mesh, outFileName);
+	}
 
 	float endTime = static_cast<float>(glfwGetTime());
 	LOG_TRACE("Converted OBJ file to binary \"{}\" in {} seconds ({} vertices, {} indices)", inFile, endTime - startTime, mesh->GetVertexCount(), mesh->GetIndexCount());
@@ -73,152 +145,34 @@ void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::s
 }
 
 MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(const std::string& filename) {
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
-
-	// If our file fails to open, we will throw an error
-	if (!file) {
-		throw std::runtime_error("Failed to open file");
-	}
-
 	// Could also take this in as a parameter
 	glm::vec4 color = glm::vec4(1.0f);
 
-	// Our attributes
-	std::vector<glm::vec3>  positions;
-	std::vector<glm::vec3>  normals;
-	std::vector<glm::vec2>  uvs;
-	std::vector<glm::ivec3> vertices;
-	std::vector<uint32_t>   indices;
-
-	// Maps a key generated from obj indices to a vertex index that
-	// has been added to the mesh already
-	std::unordered_map<uint64_t, uint32_t> vertexMap;
-
 	// We'll use the mesh builder since it supports easily adding
 	// vertices and indices
 	MeshBuilder<VertexPosNormTexColTangents>* mesh = new MeshBuilder<VertexPosNormTexColTangents>();
 
-	// Storage for temporary data
-	std::string line;
-	glm::vec3 vecData;
-	glm::ivec3 vertexIndices;
-
 	float startTime = static_cast<float>(glfwGetTime());
 
-	// Read and process the entire file
-	while (file.peek() != EOF) {
-		// Read in the first part of the line (ex: f, v, vn, etc...)
-		std::string command;
-		file >> command;
-
-		// We will ignore the rest of the line for comment lines
-		if (command == "#") {
-			std::getline(file, line);
-		}
-
-		// The v command defines a vertex's position
-		else if (command == "v") {
-			// Read in and store a position
-			file >> vecData.x >> vecData.y >> vecData.z;
-			positions.push_back(vecData);
-		}
-		// TODO: handle normals and textures
-		else if (command == "vn") {
-			// Read in and store a position
-			file >> vecData.x >> vecData.y >> vecData.z;
-			normals.push_back(vecData);
-		} else if (command == "vt") {
-			// Read in and store a position
-			file >> vecData.x >> vecData.y;
-			uvs.push_back(vecData);
-		}
-
-		// The f command defines a polygon in the mesh
-		// NOTE: make sure you triangulate in blender, otherwise it will
-		// output quads instead of triangles
-		else if (command == "f") {
-			// Read the rest of the line from the file
-			std::getline(file, line);
-			// Trim whitespace from either end of the line
-			StringTools::Trim(line);
-			// Create a string stream so we can use streaming operators on it
-			std::stringstream stream = std::stringstream(line);
-
-			uint32_t edges[4];
-			int ix = 0;
-			// Iterate over up to 4 sets of attributes
-			for (; ix < 4; ix++) {
-				if (stream.peek() != EOF) {
-					// Load in the faces, split up by slashes
-					char tempChar;
-					vertexIndices = glm::ivec3(0);
-					stream >> vertexIndices.x >> tempChar >> vertexIndices.y >> tempChar >> vertexIndices.z;
-					// The OBJ format can have negative values, which are a reference from the last added attributes
-					if (vertexIndices.x < 0) { vertexIndices.x = positions.size() + 1 + vertexIndices.x; }
-					if (vertexIndices.y < 0) { vertexIndices.y = uvs.size()       + 1 + vertexIndices.y; }
-					if (vertexIndices.z < 0) { vertexIndices.z = normals.size()   + 1 + vertexIndices.z; }
-
-					// We can construct a key using a bitmask of the attribute indices
-					// This let's us quickly look up a combination of attributes to see if it's already been added
-					// Note that this limits us to 2,097,150 unique attributes for positions, normals and textures
-					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
-					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
-
-					// Find the index associated with the combination of attributes
-					auto it = vertexMap.find(key);
-
-					// If it exists, we push the index to our indices
-					if (it != vertexMap.end()) {
-						edges[ix] = it->second;
-					} else {
-						vertices.push_back(vertexIndices - glm::ivec3(1));
-						uint32_t index = static_cast<uint32_t>(vertices.size()) - 1;
-
-						// Cache the index based on our key
-						vertexMap[key] = index;
-						// Add index to mesh, and add to edges list for if we are using quads
-						edges[ix] = index;
-					}
-				}
-				// We've reached the end of the line, break out of the loop
-				else { break; }
-			}
+	// Parse the positions, normals, UVs and de-duplicated vertices from the file, this is only
+	// done when converting to binary, so we can split large files across all our threads
+	ObjData data;
+	ObjParser::ParseFile(filename, data, 0);
 
-			// Handling for triangle faces
-			if (ix == 3) {
-				indices.push_back(edges[0]);
-				indices.push_back(edges[1]);
-				indices.push_back(edges[2]);
-			}
-			// Handling for quad faces
-			else if (ix == 4) {
-				indices.push_back(edges[0]);
-				indices.push_back(edges[1]);
-				indices.push_back(edges[2]);
-
-				indices.push_back(edges[0]);
-				indices.push_back(edges[2]);
-				indices.push_back(edges[3]);
-			}
-		}
-	}
-
-	mesh->ReserveVertexSpace(vertices.size());
-	for (const auto& vertexIndices : vertices) {
+	mesh->ReserveVertexSpace(data.Vertices.size());
+	for (const auto& vertexIndices : data.Vertices) {
 		// Construct a new vertex using the indices for the vertex
 		VertexPosNormTexColTangents vertex;
-		vertex.Position = positions[vertexIndices.x];
-		vertex.UV       = vertexIndices.y != 0 ? uvs[vertexIndices.y] : glm::vec2(0.0f);
-		vertex.Normal   = vertexIndices.z != 0 ? normals[vertexIndices.z] : glm::vec3(0.0f, 0.0f, 1.0f);
+		vertex.Position = data.Positions[vertexIndices.x];
+		vertex.UV       = vertexIndices.y >= 0 ? data.UVs[vertexIndices.y] : glm::vec2(0.0f);
+		vertex.Normal   = vertexIndices.z >= 0 ? data.Normals[vertexIndices.z] : glm::vec3(0.0f, 0.0f, 1.0f);
 		vertex.Color    = color;
 
 		// Add to the mesh, get index of the added vertex
 		mesh->AddVertex(vertex);
 	}
-	mesh->ReserveIndexSpace(indices.size());
-	for (uint32_t ix : indices) {
+	mesh->ReserveIndexSpace(data.Indices.size());
+	for (uint32_t ix : data.Indices) {
 		mesh->AddIndex(ix);
 	}
 
@@ -234,95 +188,350 @@ MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(c
 }
 
 VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string& filename) {
-
-	// Open the output file
-	std::ifstream file(filename, std::ios::binary);
+	// Map the file into memory, the buffers will be loaded directly from the mapped pages
+	MappedFile file(filename);
 	// If our file fails to open, we will throw an error
-	if (!file) { throw std::runtime_error("Failed to open file"); }
+	if (!file.IsOpen()) { throw std::runtime_error("Failed to open file"); }
 
 	float startTime = static_cast<float>(glfwGetTime());
 
-	// Get the file size so we can avoid reading past the end
-	file.seekg(0, std::ios::end);
-	size_t size = file.tellg();
-	file.seekg(0, std::ios::beg);
+	// All versions start with the header bytes and the version number
+	const uint8_t* data = file.GetData();
+	size_t size = file.GetSize();
+	if (size < sizeof(BinaryHeaderV2) || memcmp(data, HEADER_BYTES, 4) != 0) {
+		LOG_ERROR("\"{}\" is not a binary mesh file!", filename);
+		return nullptr;
+	}
+	uint16_t version;
+	memcpy(&version, data + 4, sizeof(uint16_t));
 
+	// Handle our version
+	VertexArrayObject::Sptr result = nullptr;
+	if (version == 0x01) {
+		result = _LoadFromBinFileV1(data, size);
+	} else if (version == 0x02) {
+		result = _LoadFromBinFileV2(data, size);
+	} else {
+		LOG_ERROR("Unsupported binary mesh version {} in \"{}\"", version, filename);
+	}
+
+	if (result != nullptr) {
+		// Calculate and trace out how long it took us to load
+		float endTime = static_cast<float>(glfwGetTime());
+		LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, result->GetVertexCount(), result->GetElementCount());
+	}
+
+	return result;
+}
+
+VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFileV1(const uint8_t* data, size_t size) {
 	// Read the header from the file
 	BinaryHeader header = BinaryHeader();
 	if (size >= sizeof(BinaryHeader)) {
-		file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+		memcpy(&header, data, sizeof(BinaryHeader));
 	} else {
 		LOG_ERROR("Not enough data in the file!");
 		return nullptr;
 	}
 
-	// TODO: validate header
+	// Determine how many bytes we need in the file
+	size_t requiredBytes =
+		sizeof(BinaryHeader) +
+		(header.NumAttributes * sizeof(BufferAttribute)) +
+		(header.VertexStride * (size_t)header.NumVertices) +
+		(header.NumIndices * GetIndexTypeSize(header.IndicesType));
 
-	// Handle our version
-	if (header.Version == 0x01) {
-		// Determine how many bytes we need in the file
-		size_t requiredBytes =
-			sizeof(BinaryHeader) +
-			(header.NumAttributes * sizeof(BufferAttribute)) +
-			(header.VertexStride * (size_t)header.NumVertices) +
-			(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-
-		// Make sure there's enough data in the file
-		if (size < requiredBytes) {
-			LOG_ERROR("Not enough data in the file!");
-			return nullptr;
+	// Make sure there's enough data in the file
+	if (size < requiredBytes) {
+		LOG_ERROR("Not enough data in the file!");
+		return nullptr;
+	}
+
+	// The attributes, indices and vertices are packed one after another after the header
+	const uint8_t* attributeData = data + sizeof(BinaryHeader);
+	const uint8_t* indexData     = attributeData + header.NumAttributes * sizeof(BufferAttribute);
+	const uint8_t* vertexData    = indexData + header.NumIndices * GetIndexTypeSize(header.IndicesType);
+
+	// Read all attributes from the file, this is basically our VDECL
+	std::vector<BufferAttribute> vertexDeclaration;
+	vertexDeclaration.resize(header.NumAttributes);
+	memcpy(vertexDeclaration.data(), attributeData, header.NumAttributes * sizeof(BufferAttribute));
+
+	// If we have index data, load it straight from the mapped file
+	IndexBuffer::Sptr indices = nullptr;
+	if (header.NumIndices > 0) {
+		indices = IndexBuffer::Create(BufferUsage::StaticDraw);
+		indices->LoadData(indexData, static_cast<uint32_t>(GetIndexTypeSize(header.IndicesType)), header.NumIndices, header.IndicesType);
+	}
+
+	// Create a new VBO and load data into OpenGL
+	VertexBuffer::Sptr vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+	vertices->LoadData(vertexData, header.VertexStride, header.NumVertices);
+
+	// Create the VAO and attach our index and vertex buffers
+	VertexArrayObject::Sptr result = VertexArrayObject::Create();
+	result->SetIndexBuffer(indices);
+	result->AddVertexBuffer(vertices, vertexDeclaration);
+
+	// Copy in the vertex declaration we loaded
+	result->SetVDecl(vertexDeclaration);
+
+	// Version 1 files do not store bounds, so we need to calculate them from the positions
+	for (const BufferAttribute& attrib : vertexDeclaration) {
+		if (attrib.Usage == AttribUsage::Position && attrib.Type == AttributeType::Float && attrib.Size >= 3) {
+			const glm::vec3* positions = reinterpret_cast<const glm::vec3*>(vertexData + attrib.Offset);
+			result->SetBounds(Bounds::FromPoints(positions, header.NumVertices, header.VertexStride));
+			break;
 		}
+	}
+
+	return result;
+}
+
+VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFileV2(const uint8_t* data, size_t size) {
+	BinaryHeaderV2 header = BinaryHeaderV2();
+	memcpy(&header, data, sizeof(BinaryHeaderV2));
 
-		// Read all attributes from the file, this is basically our VDECL
-		std::vector<BufferAttribute> vertexDeclaration;
-		vertexDeclaration.resize(header.NumAttributes);
-		for (int ix = 0; ix < header.NumAttributes; ix++) {
-			file.read(reinterpret_cast<char*>(&vertexDeclaration[ix]), sizeof(BufferAttribute));
+	// Make sure the table of contents fits in the file
+	if (header.TocOffset + (uint64_t)header.NumSections * sizeof(BinarySection) > size) {
+		LOG_ERROR("Not enough data in the file!");
+		return nullptr;
+	}
+
+	// Find each of the sections we know about, sections we don't know about are skipped
+	const BinarySection* vertexDecl = nullptr;
+	const BinarySection* vertices   = nullptr;
+	const BinarySection* indices    = nullptr;
+	const BinarySection* subMeshes  = nullptr;
+	const BinarySection* bounds     = nullptr;
+	const BinarySection* positionTransform = nullptr;
+	const BinarySection* lods       = nullptr;
+	const BinarySection* toc = reinterpret_cast<const BinarySection*>(data + header.TocOffset);
+	for (uint16_t ix = 0; ix < header.NumSections; ix++) {
+		const BinarySection& section = toc[ix];
+		// Offset and size are checked separately so that huge values can't wrap around when added
+		if (section.Offset > size || section.Size > size - section.Offset || section.Size < (uint64_t)section.ElementSize * section.ElementCount) {
+			LOG_ERROR("Section {} extends past the end of the file!", ix);
+			return nullptr;
+		}
+		switch (section.Type) {
+			case BinarySectionType::VertexDecl: vertexDecl = &section; break;
+			case BinarySectionType::Vertices:   vertices   = &section; break;
+			case BinarySectionType::Indices:    indices    = &section; break;
+			case BinarySectionType::SubMeshes:  subMeshes  = &section; break;
+			case BinarySectionType::Bounds:     bounds     = &section; break;
+			case BinarySectionType::PositionTransform: positionTransform = &section; break;
+			case BinarySectionType::Lods:       lods       = &section; break;
+			default: break;
 		}
+	}
 
-		// These will have the buffer pointers
-		IndexBuffer::Sptr indices = nullptr;
-		VertexBuffer::Sptr vertices = nullptr;
-
-		// If we have index data, load it
-		if (header.NumIndices > 0) {
-			// Create index buffer
-			indices = IndexBuffer::Create(BufferUsage::StaticDraw);
-
-			// Create memory to store indices, then read from the file
-			void* dataStore = malloc(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			file.read(reinterpret_cast<char*>(dataStore), header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			
-			// Load data into OpenGL and free the CPU memory we allocated
-			indices->LoadData(dataStore, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
-			free(dataStore);
+	if (vertexDecl == nullptr || vertices == nullptr || vertexDecl->ElementSize != sizeof(BufferAttribute)) {
+		LOG_ERROR("Binary mesh is missing its vertex data!");
+		return nullptr;
+	}
+
+	// Read all attributes from the file, this is basically our VDECL
+	std::vector<BufferAttribute> vertexDeclaration;
+	vertexDeclaration.resize(vertexDecl->ElementCount);
+	memcpy(vertexDeclaration.data(), data + vertexDecl->Offset, vertexDecl->ElementCount * sizeof(BufferAttribute));
+
+	// Sections are aligned, so the mapped pages can go straight to OpenGL without a copy
+	IndexBuffer::Sptr indexBuffer = nullptr;
+	if (indices != nullptr && indices->ElementCount > 0) {
+		IndexType indexType = static_cast<IndexType>(indices->Format);
+		if ((indexType != IndexType::UByte && indexType != IndexType::UShort && indexType != IndexType::UInt) || indices->ElementSize != GetIndexTypeSize(indexType)) {
+			LOG_ERROR("Binary mesh has an invalid index format!");
+			return nullptr;
 		}
+		indexBuffer = IndexBuffer::Create(BufferUsage::StaticDraw);
+		indexBuffer->LoadData(data + indices->Offset, indices->ElementSize, indices->ElementCount, indexType);
+	}
 
-		// Create a new VBO
-		vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+	VertexBuffer::Sptr vertexBuffer = VertexBuffer::Create(BufferUsage::StaticDraw);
+	vertexBuffer->LoadData(data + vertices->Offset, vertices->ElementSize, vertices->ElementCount);
 
-		// Create memory to store vertices and load from file
-		void* vertexStore = malloc(header.NumVertices * (size_t)header.VertexStride);
-		file.read(reinterpret_cast<char*>(vertexStore), header.NumVertices * (size_t)header.VertexStride);
+	// Create the VAO and attach our index and vertex buffers
+	VertexArrayObject::Sptr result = VertexArrayObject::Create();
+	result->SetIndexBuffer(indexBuffer);
+	result->AddVertexBuffer(vertexBuffer, vertexDeclaration);
+	result->SetVDecl(vertexDeclaration);
 
-		// Load data into OpenGL and free the CPU copy
-		vertices->LoadData(vertexStore, header.VertexStride, header.NumVertices);
-		free(vertexStore);
+	if (subMeshes != nullptr && subMeshes->ElementSize == sizeof(VertexArrayObject::SubMesh)) {
+		std::vector<VertexArrayObject::SubMesh> parts(subMeshes->ElementCount);
+		memcpy(parts.data(), data + subMeshes->Offset, subMeshes->ElementCount * sizeof(VertexArrayObject::SubMesh));
+		result->SetSubMeshes(parts);
+	}
 
-		// Create the VAO and attach our index and vertex buffers
-		VertexArrayObject::Sptr result = VertexArrayObject::Create();
-		result->SetIndexBuffer(indices);
-		result->AddVertexBuffer(vertices, vertexDeclaration);
+	// Older files don't have the sub-mesh range on their LODs, those fields are left at 0 so the LOD is drawn as a single range
+	const uint32_t minLodSize = static_cast<uint32_t>(offsetof(VertexArrayObject::MeshLod, FirstSubMesh));
+	if (lods != nullptr && lods->ElementSize >= minLodSize && lods->ElementSize <= sizeof(VertexArrayObject::MeshLod) && lods->ElementCount > 0) {
+		std::vector<VertexArrayObject::MeshLod> ranges(lods->ElementCount, VertexArrayObject::MeshLod());
+		for (uint32_t ix = 0; ix < lods->ElementCount; ix++) {
+			memcpy(&ranges[ix], data + lods->Offset + (uint64_t)ix * lods->ElementSize, lods->ElementSize);
+		}
+		result->SetLods(ranges);
+	}
 
-		// Copy in the vertex declaration we loaded
-		result->SetVDecl(vertexDeclaration);
+	// Packed meshes store their positions relative to a box, which we need to undo when rendering
+	if (positionTransform != nullptr && positionTransform->ElementSize == sizeof(glm::mat4) && positionTransform->ElementCount > 0) {
+		glm::mat4 transform;
+		memcpy(&transform, data + positionTransform->Offset, sizeof(glm::mat4));
+		result->SetPositionTransform(transform);
+	}
 
-		// Calculate and trace out how long it took us to load
-		float endTime = static_cast<float>(glfwGetTime());
-		LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, header.NumVertices, header.NumIndices);
+	// Use the stored bounds if we have them, otherwise fall back to calculating them
+	if (bounds != nullptr && bounds->ElementSize == sizeof(BinaryBounds) && bounds->ElementCount > 0) {
+		BinaryBounds stored;
+		memcpy(&stored, data + bounds->Offset, sizeof(BinaryBounds));
+		Bounds meshBounds;
+		meshBounds.Box    = BoundingBox(glm::vec3(stored.Min[0], stored.Min[1], stored.Min[2]), glm::vec3(stored.Max[0], stored.Max[1], stored.Max[2]));
+		meshBounds.Sphere = BoundingSphere(glm::vec3(stored.Center[0], stored.Center[1], stored.Center[2]), stored.Radius);
+		result->SetBounds(meshBounds);
+	} else {
+		for (const BufferAttribute& attrib : vertexDeclaration) {
+			if (attrib.Usage == AttribUsage::Position && attrib.Type == AttributeType::Float && attrib.Size >= 3) {
+				const glm::vec3* positions = reinterpret_cast<const glm::vec3*>(data + vertices->Offset + attrib.Offset);
+				result->SetBounds(Bounds::FromPoints(positions, vertices->ElementCount, vertices->ElementSize));
+				break;
+			}
+		}
+	}
+
+	return result;
+}
 
-		return result;
+void OptimizedObjLoader::SavePackedBinaryFile(const MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::string& outFilename) {
+	// The positions are quantized within the bounds of the mesh
+	Bounds bounds;
+	if (mesh.GetVertexCount() > 0) {
+		bounds = Bounds::FromPoints(&mesh.GetVertexDataPtr()[0].Position, mesh.GetVertexCount(), sizeof(VertexPosNormTexColTangents));
 	}
 
-	return nullptr;
+	std::vector<VertexPackedPosNormTexColTangents> vertices;
+	vertices.resize(mesh.GetVertexCount());
+	for (size_t ix = 0; ix < mesh.GetVertexCount(); ix++) {
+		vertices[ix] = VertexPackedPosNormTexColTangents::Pack(mesh.GetVertexDataPtr()[ix], bounds.Box);
+	}
+	glm::mat4 positionTransform = VertexPackedPosNormTexColTangents::GetPositionTransform(bounds.Box);
+
+	_WriteBinaryFile(outFilename, VertexPackedPosNormTexColTangents::V_DECL, vertices.data(), sizeof(VertexPackedPosNormTexColTangents), static_cast<uint32_t>(vertices.size()),
+		mesh.GetIndexDataPtr(), static_cast<uint32_t>(mesh.GetIndexCount()), mesh.GetSubMeshes(), mesh.GetLods(), bounds, &positionTransform);
 }
+
+void OptimizedObjLoader::_WriteBinaryFile(const std::string& outFilename, const std::vector<BufferAttribute>& vDecl,
+	const void* vertices, uint32_t vertexStride, uint32_t vertexCount,
+	const uint32_t* indices, uint32_t indexCount, const std::vector<VertexArrayObject::SubMesh>& subMeshes,
+	const std::vector<VertexArrayObject::MeshLod>& lods, const Bounds& meshBounds, const glm::mat4* positionTransform)
+{
+	// Write to a temporary file and move it into place once it's complete, so that nothing can load a half written file
+	fs::path tempPath = outFilename;
+	tempPath += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	std::ofstream file(tempPath, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open output file");
+	}
+
+	// Store the bounds, so the loader doesn't need to read the vertices
+	BinaryBounds bounds = BinaryBounds();
+	for (int ix = 0; ix < 3; ix++) {
+		bounds.Min[ix]    = meshBounds.Box.Min[ix];
+		bounds.Max[ix]    = meshBounds.Box.Max[ix];
+		bounds.Center[ix] = meshBounds.Sphere.Center[ix];
+	}
+	bounds.Radius = meshBounds.Sphere.Radius;
+
+	// If the mesh hasn't been split, we store a single sub-mesh covering all of it (or all of the first LOD)
+	std::vector<VertexArrayObject::SubMesh> parts = subMeshes;
+	if (parts.empty()) {
+		VertexArrayObject::SubMesh subMesh;
+		subMesh.FirstIndex  = 0;
+		subMesh.IndexCount  = lods.empty() ? indexCount : lods[0].IndexCount;
+		subMesh.BaseVertex  = 0;
+		subMesh.VertexCount = vertexCount;
+		parts.push_back(subMesh);
+	}
+
+	// Store 16 bit indices if every sub-mesh has few enough vertices
+	bool shortIndices = true;
+	for (const auto& part : parts) {
+		shortIndices &= part.VertexCount <= MeshOptimizer::MAX_SHORT_INDEX_VERTICES;
+	}
+	std::vector<uint16_t> narrowIndices;
+	if (shortIndices) {
+		narrowIndices.resize(indexCount);
+		for (uint32_t ix = 0; ix < indexCount; ix++) {
+			narrowIndices[ix] = static_cast<uint16_t>(indices[ix]);
+		}
+	}
+
+	// Describe all the sections we'll be writing
+	std::vector<BinarySection> sections;
+	std::vector<const void*>   sectionData;
+	auto addSection = [&](BinarySectionType type, const void* data, uint32_t elementSize, uint32_t elementCount, uint32_t format = 0) {
+		BinarySection section = BinarySection();
+		section.Type         = type;
+		section.ElementSize  = elementSize;
+		section.ElementCount = elementCount;
+		section.Format       = format;
+		section.Size         = static_cast<uint64_t>(elementSize) * elementCount;
+		sections.push_back(section);
+		sectionData.push_back(data);
+	};
+	addSection(BinarySectionType::VertexDecl, vDecl.data(), sizeof(BufferAttribute), static_cast<uint32_t>(vDecl.size()));
+	addSection(BinarySectionType::Vertices, vertices, vertexStride, vertexCount);
+	if (indexCount > 0) {
+		if (shortIndices) {
+			addSection(BinarySectionType::Indices, narrowIndices.data(), sizeof(uint16_t), indexCount, static_cast<uint32_t>(IndexType::UShort));
+		} else {
+			addSection(BinarySectionType::Indices, indices, sizeof(uint32_t), indexCount, static_cast<uint32_t>(IndexType::UInt));
+		}
+	}
+	addSection(BinarySectionType::SubMeshes, parts.data(), sizeof(VertexArrayObject::SubMesh), static_cast<uint32_t>(parts.size()));
+	if (meshBounds.IsValid()) {
+		addSection(BinarySectionType::Bounds, &bounds, sizeof(BinaryBounds), 1);
+	}
+	if (positionTransform != nullptr) {
+		addSection(BinarySectionType::PositionTransform, positionTransform, sizeof(glm::mat4), 1);
+	}
+	if (!lods.empty()) {
+		addSection(BinarySectionType::Lods, lods.data(), sizeof(VertexArrayObject::MeshLod), static_cast<uint32_t>(lods.size()));
+	}
+
+	// Lay out the sections after the table of contents, aligned to 16 bytes
+	auto align = [](uint64_t offset) { return (offset + 15) & ~15ull; };
+	BinaryHeaderV2 header = BinaryHeaderV2();
+	header.Version     = 0x02; // This is version 2! Update this and implement different readers if changes to format are made
+	header.NumSections = static_cast<uint16_t>(sections.size());
+	header.TocOffset   = static_cast<uint32_t>(align(sizeof(BinaryHeaderV2)));
+	uint64_t offset = align(header.TocOffset + sections.size() * sizeof(BinarySection));
+	for (auto& section : sections) {
+		section.Offset = offset;
+		offset = align(offset + section.Size);
+	}
+
+	// Write the header and table of contents, then the sections with padding between them
+	const char padding[16] = { 0 };
+	file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeaderV2));
+	file.write(padding, header.TocOffset - sizeof(BinaryHeaderV2));
+	file.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(BinarySection));
+	uint64_t written = header.TocOffset + sections.size() * sizeof(BinarySection);
+	for (size_t ix = 0; ix < sections.size(); ix++) {
+		file.write(padding, sections[ix].Offset - written);
+		file.write(reinterpret_cast<const char*>(sectionData[ix]), sections[ix].Size);
+		written = sections[ix].Offset + sections[ix].Size;
+	}
+
+	bool failed = !file.good();
+	file.close();
+	std::error_code error;
+	if (failed) {
+		fs::remove(tempPath, error);
+		throw std::runtime_error("Failed to write output file");
+	}
+	fs::rename(tempPath, outFilename, error);
+	if (error) {
+		fs::remove(tempPath, error);
+		throw std::runtime_error("Failed to move output file into place");
+	}
+}
\ No newline at end of file
@@ -7,6 +7,9 @@
  */
 #pragma once
 #include <fstream>
+#include <future>
+#include <mutex>
+#include <unordered_map>
 
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/VertexTypes.h"
@@ -27,11 +30,20 @@ public:
 	/// <returns>A VAO loaded from disk</returns>
 	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
 	/// <summary>
+	/// Converts an OBJ file to it's binary version if that hasn't been done yet. This does not touch
+	/// the GL context, so it can be called from worker threads to do the slow part of LoadFromFile.
+	/// If another thread is already converting the same file, this waits for it instead
+	/// </summary>
+	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <returns>The path of the file that LoadFromFile will read</returns>
+	static std::string PrepareFile(const std::string& filename);
+	/// <summary>
 	/// Manually converts an OBJ file into a binary mesh file
 	/// </summary>
 	/// <param name="inFile">The path to OBJ file to convert</param>
 	/// <param name="outFile">The output path for the bin file, or empty to use the inFile path and replace the extension with .bin</param>
-	static void ConvertToBinary(const std::string& inFile, const std::string& outFile = "");
+	/// <param name="packVertices">True to store the vertices as VertexPackedPosNormTexColTangents instead of VertexPosNormTexColTangents</param>
+	static void ConvertToBinary(const std::string& inFile, const std::string& outFile = "", bool packVertices = false);
 
 	/// <summary>
 	/// Saves a mesh builder of the given type to a binary file
@@ -41,9 +53,16 @@ public:
 	/// <param name="outFilename"></param>
 	template <typename VertexType>
 	static void SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename);
+	/// <summary>
+	/// Saves a mesh builder to a binary file, compressing the vertices to VertexPackedPosNormTexColTangents
+	/// </summary>
+	/// <param name="mesh">The mesh to save</param>
+	/// <param name="outFilename">The path of the file to write</param>
+	static void SavePackedBinaryFile(const MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::string& outFilename);
 
 protected:
-	// Will be put at the start of the binary file, contains info about the contents of the file
+	// Will be put at the start of version 1 binary files, contains info about the contents of the file
+	// Version 1 files are no longer written, but can still be loaded
 	struct BinaryHeader {
 		// A check value so we can ensure that we're loading in the right file type
 		char      HeaderBytes[4] ={ 'B', 'O', 'B', 'J' };
@@ -61,42 +80,82 @@ protected:
 		uint8_t   NumAttributes = 0;
 	};
 
+	// Will be put at the start of version 2 binary files. The header is followed by a table of
+	// contents that describes each section of the file. Sections start on 16 byte boundaries,
+	// so that the file can be memory mapped and the data handed directly to OpenGL
+	struct BinaryHeaderV2 {
+		// A check value so we can ensure that we're loading in the right file type, matches version 1
+		char      HeaderBytes[4] ={ 'B', 'O', 'B', 'J' };
+		// The version code, always at the same offset as in version 1
+		uint16_t  Version = 0x02;
+		// The number of entries in the table of contents
+		uint16_t  NumSections = 0;
+		// The offset of the table of contents from the start of the file
+		uint32_t  TocOffset = 0;
+		uint32_t  Reserved = 0;
+	};
+
+	// The types of data that can be stored in a version 2 binary file
+	enum class BinarySectionType : uint32_t {
+		VertexDecl = 1, // The BufferAttributes for the vertex buffer
+		Vertices   = 2, // The interleaved vertex data
+		Indices    = 3, // The index data, Format stores the IndexType
+		SubMeshes  = 4, // VertexArrayObject::SubMesh ranges, optional
+		Bounds     = 5, // A single BinaryBounds, optional
+		PositionTransform = 6, // A single glm::mat4 that maps quantized positions to local space, optional
+		Lods       = 7  // VertexArrayObject::MeshLod ranges of the index buffer, optional
+	};
+
+	// An entry in the table of contents of a version 2 binary file
+	struct BinarySection {
+		BinarySectionType Type;
+		// The size of a single element in the section, in bytes
+		uint32_t ElementSize;
+		// The number of elements in the section
+		uint32_t ElementCount;
+		// Extra info about the section's data, depends on the type
+		uint32_t Format;
+		// The offset of the section from the start of the file, and its size in bytes
+		uint64_t Offset;
+		uint64_t Size;
+	};
+
+	// The precomputed bounds of the mesh, so we don't need to touch the vertex data when loading
+	struct BinaryBounds {
+		float Min[3];
+		float Max[3];
+		float Center[3];
+		float Radius;
+	};
+
 	OptimizedObjLoader() = default;
 	~OptimizedObjLoader() = default;
 
+	// The binary files that are currently being converted by PrepareFile, keyed by their absolute path
+	inline static std::mutex                                              __conversionMutex;
+	inline static std::unordered_map<std::string, std::shared_future<void>> __conversions;
+
 	static MeshBuilder<VertexPosNormTexColTangents>* _LoadFromObjFile(const std::string& filename);
 	static VertexArrayObject::Sptr _LoadFromBinFile(const std::string& filename);
+	static VertexArrayObject::Sptr _LoadFromBinFileV1(const uint8_t* data, size_t size);
+	static VertexArrayObject::Sptr _LoadFromBinFileV2(const uint8_t* data, size_t size);
+
+	// Writes a version 2 binary file, the indices are narrowed to 16 bits if the sub-meshes allow it.
+	// positionTransform may be null if the positions are not quantized
+	static void _WriteBinaryFile(const std::string& outFilename, const std::vector<BufferAttribute>& vDecl,
+		const void* vertices, uint32_t vertexStride, uint32_t vertexCount,
+		const uint32_t* indices, uint32_t indexCount, const std::vector<VertexArrayObject::SubMesh>& subMeshes,
+		const std::vector<VertexArrayObject::MeshLod>& lods, const Bounds& bounds, const glm::mat4* positionTransform);
 };
 
 template <typename VertexType>
 void OptimizedObjLoader::SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename) {
-	// Open the output file
-	std::ofstream file(outFilename, std::ios::binary);
-	if (!file) {
-		throw std::runtime_error("Failed to open output file");
-	}
-
-	// Create the fixed size header for our output file
-	BinaryHeader header  = BinaryHeader();
-	header.Version       = 0x01; // This is version 1! Update this and implement different readers if changes to format are made
-	header.NumIndices    = mesh.GetIndexCount();
-	header.IndicesType   = IndexType::UInt;
-	header.NumVertices   = mesh.GetVertexCount();
-	header.VertexStride  = sizeof(VertexType);
-	header.NumAttributes = VertexType::V_DECL.size();
-
-	// Write header bytes to the stream
-	file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
-
-	// Write which attributes we have to the stream
-	for (int ix = 0; ix < VertexType::V_DECL.size(); ix++) {
-		file.write(reinterpret_cast<const char*>(&VertexType::V_DECL[ix]), sizeof(BufferAttribute));
-	}
-	// Write any index data to the file
-	if (mesh.GetIndexCount() > 0) {
-		file.write(reinterpret_cast<const char*>(mesh.GetIndexDataPtr()), mesh.GetIndexCount() * sizeof(uint32_t));
+	// Calculate the bounds up front, so the loader doesn't need to read the vertices
+	Bounds bounds;
+	if (mesh.GetVertexCount() > 0) {
+		bounds = Bounds::FromPoints(&mesh.GetVertexDataPtr()[0].Position, mesh.GetVertexCount(), sizeof(VertexType));
 	}
 
-	// Write vertex data to file
-	file.write(reinterpret_cast<const char*>(mesh.GetVertexDataPtr()), mesh.GetVertexCount() * sizeof(VertexType));
+	_WriteBinaryFile(outFilename, VertexType::V_DECL, mesh.GetVertexDataPtr(), sizeof(VertexType), static_cast<uint32_t>(mesh.GetVertexCount()),
+		mesh.GetIndexDataPtr(), static_cast<uint32_t>(mesh.GetIndexCount()), mesh.GetSubMeshes(), mesh.GetLods(), bounds, nullptr);
 }
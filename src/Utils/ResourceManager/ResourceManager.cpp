@@ -3,9 +3,15 @@
 #include "Utils/ObjLoader.h"
 #include "Utils/FileHelpers.h"
 #include "Utils/StringUtils.h"
+#include "Utils/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
 
 std::map<std::type_index, std::map<Guid, IResource::Sptr>> ResourceManager::_resources;
-std::map<std::string, std::function<Guid(const nlohmann::json&)>> ResourceManager::_typeLoaders;
+std::map<std::string, ResourceManager::TypeLoader> ResourceManager::_typeLoaders;
+std::vector<std::shared_ptr<ResourceManager::LoadJob>> ResourceManager::_jobQueue;
+std::map<Guid, std::shared_ptr<ResourceManager::LoadJob>> ResourceManager::_pendingJobs;
 
 nlohmann::ordered_json ResourceManager::_manifest;
 
@@ -27,17 +33,50 @@ void ResourceManager::LoadManifest(const std::string& path, bool preloadAssets)
 	_manifest = blob;
 
 	if (preloadAssets) {
-		for (auto& [typeName, items] : blob.items()) {
-			auto& func = _typeLoaders[typeName];
-			if (func) {
-				for (auto& [guid, blob] : items.items()) {
-					func(blob);
-				}
-			}
+		PreloadAllAsync();
+		WaitForLoads();
+	}
+}
+
+void ResourceManager::PreloadAllAsync() {
+	for (auto& [typeName, items] : _manifest.items()) {
+		if (_typeLoaders.count(typeName) == 0 || !items.is_object()) {
+			continue;
+		}
+		for (auto& [guid, blob] : items.items()) {
+			_StartJob(typeName, Guid(guid));
 		}
 	}
 }
 
+void ResourceManager::Update() {
+	// Finishing a job can start new ones (ex: a resource calling Get), so we can't use iterators here
+	for (size_t ix = 0; ix < _jobQueue.size(); ix++) {
+		std::shared_ptr<LoadJob> job = _jobQueue[ix];
+		if (_IsJobReady(job)) {
+			_FinishJob(job);
+		}
+	}
+	_jobQueue.erase(std::remove_if(_jobQueue.begin(), _jobQueue.end(), [](const std::shared_ptr<LoadJob>& job) {
+		return job->IsDone;
+	}), _jobQueue.end());
+}
+
+void ResourceManager::WaitForLoads() {
+	// Finishing a job can start new ones and grow the queue, so we hold our own reference to each job
+	for (size_t ix = 0; ix < _jobQueue.size(); ix++) {
+		std::shared_ptr<LoadJob> job = _jobQueue[ix];
+		_FinishJob(job);
+	}
+	_jobQueue.erase(std::remove_if(_jobQueue.begin(), _jobQueue.end(), [](const std::shared_ptr<LoadJob>& job) {
+		return job->IsDone;
+	}), _jobQueue.end());
+}
+
+size_t ResourceManager::GetPendingLoadCount() {
+	return _pendingJobs.size();
+}
+
 void ResourceManager::SaveManifest(const std::string& path) {
 	// Update all resources in the manifest so they match their current representation
 	for (auto& [type, map] : _resources) {
@@ -53,8 +92,107 @@ void ResourceManager::SaveManifest(const std::string& path) {
 }
 
 void ResourceManager::Cleanup() {
+	// Any prepare steps still running only hold copies of their data, so the jobs can just be dropped
+	_jobQueue.clear();
+	_pendingJobs.clear();
 	for (auto& [type, map] : _resources) {
 		map.clear();
 	}
 }
 
+std::shared_ptr<ResourceManager::LoadJob> ResourceManager::_StartJob(const std::string& typeName, Guid id) {
+	// If the resource is already loading, we can share the job
+	auto pending = _pendingJobs.find(id);
+	if (pending != _pendingJobs.end()) {
+		return pending->second;
+	}
+
+	auto loader = _typeLoaders.find(typeName);
+	auto items = _manifest.find(typeName);
+	if (loader == _typeLoaders.end() || items == _manifest.end() || !items->contains(id.str())) {
+		return nullptr;
+	}
+	if (_resources[loader->second.Type][id] != nullptr) {
+		return nullptr;
+	}
+
+	std::shared_ptr<LoadJob> job = std::make_shared<LoadJob>();
+	job->TypeName = typeName;
+	job->Id = id;
+	job->Data = (*items)[id.str()];
+
+	// Register the job before looking for dependencies, so resources that reference each other share it
+	_pendingJobs[id] = job;
+	_jobQueue.push_back(job);
+
+	if (loader->second.Prepare) {
+		job->Prepared = ThreadPool::Get().Enqueue([prepare = loader->second.Prepare, data = job->Data]() {
+			return prepare(data);
+		});
+	}
+
+	_AddDependencies(job, job->Data);
+	return job;
+}
+
+void ResourceManager::_FinishJob(const std::shared_ptr<LoadJob>& job) {
+	// IsFinishing stops us from recursing forever if resources depend on each other
+	if (job == nullptr || job->IsDone || job->IsFinishing) {
+		return;
+	}
+	job->IsFinishing = true;
+
+	for (const auto& dependency : job->Dependencies) {
+		_FinishJob(dependency);
+	}
+
+	std::shared_ptr<void> prepared = job->Prepared.valid() ? job->Prepared.get() : nullptr;
+
+	// The resource may have been created some other way while it was loading, in which case we keep that one
+	const TypeLoader& loader = _typeLoaders.at(job->TypeName);
+	job->Result = _resources[loader.Type][job->Id];
+	if (job->Result == nullptr) {
+		job->Result = loader.Load(job->Data, prepared);
+	}
+
+	job->IsDone = true;
+	_pendingJobs.erase(job->Id);
+}
+
+bool ResourceManager::_IsJobReady(const std::shared_ptr<LoadJob>& job) {
+	if (job->Prepared.valid() && job->Prepared.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		return false;
+	}
+	return std::all_of(job->Dependencies.begin(), job->Dependencies.end(), [](const std::shared_ptr<LoadJob>& dependency) {
+		return dependency->IsDone;
+	});
+}
+
+void ResourceManager::_AddDependencies(const std::shared_ptr<LoadJob>& job, const nlohmann::json& blob) {
+	if (blob.is_structured()) {
+		for (const auto& item : blob) {
+			_AddDependencies(job, item);
+		}
+	}
+	else if (blob.is_string()) {
+		// GUIDs are always stored as 36 character strings, which rules out most other values cheaply
+		const std::string& value = blob.get_ref<const std::string&>();
+		if (value.size() != 36) {
+			return;
+		}
+		Guid id = Guid(value);
+		if (!id.isValid() || id == job->Id) {
+			return;
+		}
+		for (auto& [typeName, items] : _manifest.items()) {
+			if (items.is_object() && items.contains(value)) {
+				std::shared_ptr<LoadJob> dependency = _StartJob(typeName, id);
+				if (dependency != nullptr) {
+					job->Dependencies.push_back(dependency);
+				}
+				return;
+			}
+		}
+	}
+}
+
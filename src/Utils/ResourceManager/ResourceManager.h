@@ -3,14 +3,25 @@
 #include <json.hpp>
 #include <unordered_map>
 #include <typeindex>
+#include <future>
+#include <vector>
 
 #include "Utils/GUID.hpp"
 #include "Utils/ResourceManager/IResource.h"
 #include "Utils/StringUtils.h"
 
+template <typename T>
+class ResourceFuture;
+
 /// <summary>
 /// Utility class for managing and loading resources from JSON
 /// manifest files
+/// 
+/// Resources can be loaded in the background with LoadAsync and PreloadAllAsync. Types that
+/// have a static PrepareFromJson do their file IO and parsing on the ThreadPool, and the rest of
+/// the load (creating GL objects) happens on the main thread in Update. Resources that are
+/// referenced by GUID in another resource's manifest entry (ex: a material's shader and textures)
+/// are treated as dependencies, and are always finished first
 /// </summary>
 class ResourceManager {
 public:
@@ -63,8 +74,9 @@ public:
 
 			// If the manifest has an entry, we can load it!
 			if (_manifest[typeName].contains(id)) {
-				// Invoke the loader function with the manifest data
-				_typeLoaders[typeName](_manifest[typeName][id]);
+				// If the asset is already loading in the background this will finish it, rather than
+				// loading it a second time
+				_FinishJob(_StartJob(typeName, id));
 
 				// Search resources again to get the resource
 				return std::dynamic_pointer_cast<T>(_resources[std::type_index(typeid(T))][id]);
@@ -87,13 +99,30 @@ public:
 		std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
 
 		// Create the type loader for the type
-		_typeLoaders[typeName] = [](const nlohmann::json& data) {
-			IResource::Sptr res = T::FromJson(data);
+		TypeLoader loader(std::type_index(typeid(T)));
+		loader.Load = [](const nlohmann::json& data, const std::shared_ptr<void>& prepared) {
+			IResource::Sptr res;
+			if constexpr (test_prepare_json<T, const nlohmann::json&>::value) {
+				res = prepared != nullptr ? 
+					T::FromJson(data, std::static_pointer_cast<typename T::PreparedData>(prepared)) : 
+					T::FromJson(data);
+			} else {
+				res = T::FromJson(data);
+			}
 			res->OverrideGUID(Guid(data["guid"]));
 			_resources[std::type_index(typeid(T))][res->GetGUID()] = res;
-			return res->GetGUID();
+			return res;
 		};
 
+		// Types that can do part of their loading without the GL context get a prepare step that
+		// will be run on the thread pool
+		if constexpr (test_prepare_json<T, const nlohmann::json&>::value) {
+			loader.Prepare = [](const nlohmann::json& data) {
+				return std::static_pointer_cast<void>(T::PrepareFromJson(data));
+			};
+		}
+		_typeLoaders.insert_or_assign(typeName, loader);
+
 		// Make sure we haven't registered the type yet, then add an empty object
 		// to the manifest to ensure it can be saved
 		if (!_manifest.contains(typeName)) {
@@ -125,13 +154,53 @@ public:
 		}
 	}
 
+	/// <summary>
+	/// Starts loading a resource from the manifest in the background. The returned future can
+	/// be polled to see if the resource has finished loading, which will happen during Update
+	/// </summary>
+	/// <typeparam name="T">The type of resource to load</typeparam>
+	/// <param name="id">The ID of the resource to load</param>
+	/// <returns>A future that will hold the resource, or nullptr if it is not in the manifest</returns>
+	template<typename T, typename = std::enable_if<is_valid_resource<T>()>::type>
+	static ResourceFuture<T> LoadAsync(Guid id) {
+		std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
+		std::shared_ptr<LoadJob> job = _StartJob(typeName, id);
+
+		// If no job was started, the resource is either loaded already or doesn't exist
+		if (job == nullptr) {
+			job = std::make_shared<LoadJob>();
+			job->TypeName = typeName;
+			job->Id = id;
+			job->Result = _resources[std::type_index(typeid(T))][id];
+			job->IsDone = true;
+		}
+		return ResourceFuture<T>(job);
+	}
+	/// <summary>
+	/// Starts loading every resource in the manifest that hasn't been loaded yet in the background
+	/// </summary>
+	static void PreloadAllAsync();
+	/// <summary>
+	/// Finishes any background loads whose data and dependencies are ready, should be called
+	/// once per frame from the main thread
+	/// </summary>
+	static void Update();
+	/// <summary>
+	/// Blocks until every background load has finished
+	/// </summary>
+	static void WaitForLoads();
+	/// <summary>
+	/// Gets the number of resources that are still loading in the background
+	/// </summary>
+	static size_t GetPendingLoadCount();
+
 	/// <summary>
 	/// Gets the current JSON manifest
 	/// </summary>
 	static const nlohmann::ordered_json& GetManifest();
 	/// <summary>
 	/// Loads a manifest file into the resource manager. Note that this will not perform load on the assets themselves 
-	/// unless preloadAssets is set to true
+	/// unless preloadAssets is set to true, in which case they are loaded in parallel and this blocks until they are done
 	/// </summary>
 	/// <param name="path">The path to the JSON manifest file</param>
 	/// <param name="preloadAssets">True if all assets should be loaded into memory</param>
@@ -148,6 +217,57 @@ public:
 	static void Cleanup();
 
 protected:
+	template <typename T>
+	friend class ResourceFuture;
+
+	/// <summary>
+	/// The functions needed to load a registered type
+	/// </summary>
+	struct TypeLoader {
+		std::type_index Type;
+		// Creates the resource from it's JSON data and the result of Prepare (or nullptr), and stores it
+		std::function<IResource::Sptr(const nlohmann::json&, const std::shared_ptr<void>&)> Load;
+		// Does the part of the load that can happen on a worker thread, empty if the type has no prepare step
+		std::function<std::shared_ptr<void>(const nlohmann::json&)>                       Prepare;
+
+		TypeLoader(std::type_index type) : Type(type), Load(nullptr), Prepare(nullptr) {}
+	};
+
+	/// <summary>
+	/// A resource that is being loaded in the background
+	/// </summary>
+	struct LoadJob {
+		std::string                           TypeName;
+		Guid                                  Id;
+		// A copy of the resource's manifest entry, so the worker thread doesn't touch the manifest
+		nlohmann::json                        Data;
+		// The result of the type's prepare step, not valid if the type doesn't have one
+		std::future<std::shared_ptr<void>>    Prepared;
+		// Jobs for the resources this one references, which must be finished before it
+		std::vector<std::shared_ptr<LoadJob>> Dependencies;
+		IResource::Sptr                       Result = nullptr;
+		bool                                  IsFinishing = false;
+		bool                                  IsDone = false;
+	};
+
+	/// <summary>
+	/// Starts a background load for a resource in the manifest, along with any resources it depends on
+	/// </summary>
+	/// <returns>The job loading the resource, or nullptr if it is already loaded or not in the manifest</returns>
+	static std::shared_ptr<LoadJob> _StartJob(const std::string& typeName, Guid id);
+	/// <summary>
+	/// Finishes a job on the calling thread, waiting for it's prepare step if needed. Must be called from the main thread
+	/// </summary>
+	static void _FinishJob(const std::shared_ptr<LoadJob>& job);
+	/// <summary>
+	/// Returns true if a job can be finished without blocking
+	/// </summary>
+	static bool _IsJobReady(const std::shared_ptr<LoadJob>& job);
+	/// <summary>
+	/// Searches a JSON blob for the GUIDs of other resources in the manifest, and starts jobs for them
+	/// </summary>
+	static void _AddDependencies(const std::shared_ptr<LoadJob>& job, const nlohmann::json& blob);
+
 	/// <summary>
 	/// This is a map of maps
 	/// The top level map uses type_index, so there's a map per resource type
@@ -157,11 +277,54 @@ protected:
 	/// <summary>
 	/// This map stores registered types, so we can load them from JSON files
 	/// </summary>
-	static std::map<std::string, std::function<Guid(const nlohmann::json&)>> _typeLoaders;
+	static std::map<std::string, TypeLoader> _typeLoaders;
+	/// <summary>
+	/// Background loads that have not finished yet, in the order they were started
+	/// </summary>
+	static std::vector<std::shared_ptr<LoadJob>> _jobQueue;
+	/// <summary>
+	/// Looks up background loads by the GUID of the resource they're loading
+	/// </summary>
+	static std::map<Guid, std::shared_ptr<LoadJob>> _pendingJobs;
 
 	/// <summary>
 	/// We use an ORDERED JSON file to allow serializing types in the order they are registered.
 	/// This allows us to register dependencies before the dependent resource
 	/// </summary>
 	static nlohmann::ordered_json _manifest;
+};
+
+/// <summary>
+/// A handle to a resource that is being loaded in the background by ResourceManager::LoadAsync
+/// </summary>
+/// <typeparam name="T">The type of resource being loaded</typeparam>
+template <typename T>
+class ResourceFuture {
+public:
+	ResourceFuture() : _job(nullptr) {}
+
+	/// <summary>
+	/// Returns true if the resource has finished loading, and Get will not block
+	/// </summary>
+	bool IsReady() const { return _job == nullptr || _job->IsDone; }
+
+	/// <summary>
+	/// Gets the resource, finishing the load on the calling thread if it hasn't finished yet.
+	/// Must be called from the main thread
+	/// </summary>
+	/// <returns>The resource, or nullptr if it could not be found</returns>
+	std::shared_ptr<T> Get() const {
+		if (_job == nullptr) {
+			return nullptr;
+		}
+		ResourceManager::_FinishJob(_job);
+		return std::dynamic_pointer_cast<T>(_job->Result);
+	}
+
+protected:
+	friend class ResourceManager;
+
+	std::shared_ptr<ResourceManager::LoadJob> _job;
+
+	ResourceFuture(const std::shared_ptr<ResourceManager::LoadJob>& job) : _job(job) {}
 };
\ No newline at end of file
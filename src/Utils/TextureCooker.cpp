@@ -0,0 +1,501 @@
+#include "TextureCooker.h"
+#include "Logging.h"
+#include "Utils/ThreadPool.h"
+
+#include <stb_image.h>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <climits>
+
+// Cooked files are stored next to their source images with this extension
+static const std::string cookedExtension = ".ctex";
+
+// Should be incremented whenever the cooker's output changes, so that existing files get re-cooked
+static const uint64_t cookerVersion = 1;
+
+// FNV-1a, used to build the stamp of the source files
+static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+	for (size_t ix = 0; ix < size; ix++) {
+		hash ^= bytes[ix];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static size_t AlignTo16(size_t value) {
+	return (value + 15) & ~static_cast<size_t>(15);
+}
+
+// Gets the size of a single face of a mip level, in bytes
+static size_t GetLevelSize(TextureCompression compression, uint32_t width, uint32_t height) {
+	if (compression == TextureCompression::None) {
+		return (size_t)width * height * 4;
+	}
+	// Everything is stored in 4x4 blocks, BC1 blocks are 8 bytes and the others are 16
+	size_t blockSize = compression == TextureCompression::BC1 ? 8 : 16;
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+// Makes the next mip level by averaging each 2x2 block of RGBA texels, edge texels are repeated for odd sizes
+static void Downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight) {
+	for (uint32_t y = 0; y < dstHeight; y++) {
+		uint32_t y0 = std::min(y * 2, srcHeight - 1);
+		uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+		for (uint32_t x = 0; x < dstWidth; x++) {
+			uint32_t x0 = std::min(x * 2, srcWidth - 1);
+			uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+			for (uint32_t c = 0; c < 4; c++) {
+				uint32_t sum =
+					src[((size_t)y0 * srcWidth + x0) * 4 + c] + src[((size_t)y0 * srcWidth + x1) * 4 + c] +
+					src[((size_t)y1 * srcWidth + x0) * 4 + c] + src[((size_t)y1 * srcWidth + x1) * 4 + c];
+				dst[((size_t)y * dstWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+// Copies a 4x4 block of RGBA texels, edge texels are repeated for blocks that hang off the image
+static void FetchBlock(const uint8_t* texels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t block[16][4]) {
+	for (uint32_t y = 0; y < 4; y++) {
+		uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+		for (uint32_t x = 0; x < 4; x++) {
+			uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+			memcpy(block[y * 4 + x], texels + ((size_t)sourceY * width + sourceX) * 4, 4);
+		}
+	}
+}
+
+// Encodes 16 single channel values as a BC4 block, which is also used for the alpha of BC3 and both channels of BC5
+static void EncodeChannelBlock(const uint8_t values[16], uint8_t* out) {
+	uint8_t maxValue = *std::max_element(values, values + 16);
+	uint8_t minValue = *std::min_element(values, values + 16);
+	out[0] = maxValue;
+	out[1] = minValue;
+
+	// If every value is the same, all the indices can point at the first endpoint
+	uint64_t indices = 0;
+	if (maxValue > minValue) {
+		// With the first endpoint larger, the palette is both endpoints plus 6 evenly spaced values between them
+		int palette[8];
+		palette[0] = maxValue;
+		palette[1] = minValue;
+		for (int ix = 2; ix < 8; ix++) {
+			palette[ix] = ((8 - ix) * maxValue + (ix - 1) * minValue + 3) / 7;
+		}
+
+		for (int ix = 0; ix < 16; ix++) {
+			int best = 0;
+			int bestError = 256;
+			for (int iy = 0; iy < 8; iy++) {
+				int error = std::abs(values[ix] - palette[iy]);
+				if (error < bestError) {
+					best = iy;
+					bestError = error;
+				}
+			}
+			indices |= static_cast<uint64_t>(best) << (3 * ix);
+		}
+	}
+
+	for (int ix = 0; ix < 6; ix++) {
+		out[2 + ix] = static_cast<uint8_t>(indices >> (8 * ix));
+	}
+}
+
+static uint16_t PackRgb565(const int rgb[3]) {
+	int r = (std::clamp(rgb[0], 0, 255) * 31 + 127) / 255;
+	int g = (std::clamp(rgb[1], 0, 255) * 63 + 127) / 255;
+	int b = (std::clamp(rgb[2], 0, 255) * 31 + 127) / 255;
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static void UnpackRgb565(uint16_t color, int rgb[3]) {
+	int r = (color >> 11) & 31;
+	int g = (color >> 5) & 63;
+	int b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Encodes the RGB of 16 texels as a BC1 block, using the bounding box of the colors as the endpoints
+static void EncodeColorBlock(const uint8_t block[16][4], uint8_t* out) {
+	int minColor[3] = { 255, 255, 255 };
+	int maxColor[3] = { 0, 0, 0 };
+	int mean[3] = { 0, 0, 0 };
+	for (int ix = 0; ix < 16; ix++) {
+		for (int c = 0; c < 3; c++) {
+			minColor[c] = std::min(minColor[c], (int)block[ix][c]);
+			maxColor[c] = std::max(maxColor[c], (int)block[ix][c]);
+			mean[c] += block[ix][c];
+		}
+	}
+	for (int c = 0; c < 3; c++) {
+		mean[c] /= 16;
+	}
+
+	// The diagonal of the box only follows the colors if the channels increase together, so flip
+	// red and blue if they go against green
+	int covarianceRG = 0;
+	int covarianceBG = 0;
+	for (int ix = 0; ix < 16; ix++) {
+		int green = block[ix][1] - mean[1];
+		covarianceRG += (block[ix][0] - mean[0]) * green;
+		covarianceBG += (block[ix][2] - mean[2]) * green;
+	}
+	if (covarianceRG < 0) {
+		std::swap(minColor[0], maxColor[0]);
+	}
+	if (covarianceBG < 0) {
+		std::swap(minColor[2], maxColor[2]);
+	}
+
+	// Pull the endpoints in a bit, the extremes of the box are usually outliers
+	for (int c = 0; c < 3; c++) {
+		int inset = (maxColor[c] - minColor[c]) / 16;
+		maxColor[c] -= inset;
+		minColor[c] += inset;
+	}
+
+	// The first endpoint needs to be larger for the 4 color palette
+	uint16_t color0 = PackRgb565(maxColor);
+	uint16_t color1 = PackRgb565(minColor);
+	if (color0 < color1) {
+		std::swap(color0, color1);
+	}
+
+	// If the endpoints are the same, all the indices can point at the first endpoint
+	uint32_t indices = 0;
+	if (color0 != color1) {
+		int palette[4][3];
+		UnpackRgb565(color0, palette[0]);
+		UnpackRgb565(color1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+		}
+
+		for (int ix = 0; ix < 16; ix++) {
+			int best = 0;
+			int bestError = INT_MAX;
+			for (int iy = 0; iy < 4; iy++) {
+				int dr = block[ix][0] - palette[iy][0];
+				int dg = block[ix][1] - palette[iy][1];
+				int db = block[ix][2] - palette[iy][2];
+				int error = dr * dr + dg * dg + db * db;
+				if (error < bestError) {
+					best = iy;
+					bestError = error;
+				}
+			}
+			indices |= static_cast<uint32_t>(best) << (2 * ix);
+		}
+	}
+
+	out[0] = static_cast<uint8_t>(color0);
+	out[1] = static_cast<uint8_t>(color0 >> 8);
+	out[2] = static_cast<uint8_t>(color1);
+	out[3] = static_cast<uint8_t>(color1 >> 8);
+	for (int ix = 0; ix < 4; ix++) {
+		out[4 + ix] = static_cast<uint8_t>(indices >> (8 * ix));
+	}
+}
+
+// Block compresses a level of RGBA texels into out, which must be GetLevelSize bytes
+static void CompressLevel(const uint8_t* texels, uint32_t width, uint32_t height, TextureCompression compression, uint8_t* out) {
+	uint32_t blocksX = (width + 3) / 4;
+	uint32_t blocksY = (height + 3) / 4;
+	size_t blockSize = compression == TextureCompression::BC1 ? 8 : 16;
+
+	uint8_t block[16][4];
+	uint8_t channel[16];
+	for (uint32_t blockY = 0; blockY < blocksY; blockY++) {
+		for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+			FetchBlock(texels, width, height, blockX, blockY, block);
+			uint8_t* dst = out + ((size_t)blockY * blocksX + blockX) * blockSize;
+
+			switch (compression) {
+				case TextureCompression::BC1:
+					EncodeColorBlock(block, dst);
+					break;
+				case TextureCompression::BC3:
+					for (int ix = 0; ix < 16; ix++) { channel[ix] = block[ix][3]; }
+					EncodeChannelBlock(channel, dst);
+					EncodeColorBlock(block, dst + 8);
+					break;
+				case TextureCompression::BC5:
+					for (int ix = 0; ix < 16; ix++) { channel[ix] = block[ix][0]; }
+					EncodeChannelBlock(channel, dst);
+					for (int ix = 0; ix < 16; ix++) { channel[ix] = block[ix][1]; }
+					EncodeChannelBlock(channel, dst + 8);
+					break;
+				default:
+					break;
+			}
+		}
+	}
+}
+
+InternalFormat CookedTexture::GetInternalFormat() const {
+	switch (Compression) {
+		case TextureCompression::BC1: return InternalFormat::BC1;
+		case TextureCompression::BC3: return InternalFormat::BC3;
+		case TextureCompression::BC5: return InternalFormat::BC5;
+		default:                      return InternalFormat::RGBA8;
+	}
+}
+
+std::string TextureCooker::GetCookedPath(const std::string& source, bool cubemap) {
+	std::filesystem::path path(source);
+	path.replace_extension(cubemap ? ".cube" + cookedExtension : cookedExtension);
+	return path.string();
+}
+
+CookedTexture::Sptr TextureCooker::Cook(const std::vector<const uint8_t*>& faces, uint32_t width, uint32_t height, TextureCompression compression, bool generateMips) {
+	LOG_ASSERT(!faces.empty() && width > 0 && height > 0, "Cannot cook an empty texture");
+
+	// Only pay for alpha if the image actually uses it
+	if (compression == TextureCompression::Auto) {
+		compression = TextureCompression::BC1;
+		for (const uint8_t* texels : faces) {
+			for (size_t ix = 0; ix < (size_t)width * height && compression == TextureCompression::BC1; ix++) {
+				if (texels[ix * 4 + 3] != 255) {
+					compression = TextureCompression::BC3;
+				}
+			}
+		}
+	}
+
+	CookedTexture::Sptr result = std::make_shared<CookedTexture>();
+	result->Compression = compression;
+	result->Width = width;
+	result->Height = height;
+	result->Faces = static_cast<uint32_t>(faces.size());
+
+	// Lay out the mip chain up front so that we only allocate once. This matches the number of
+	// levels that Texture2D allocates when generating mip maps
+	size_t offset = 0;
+	uint32_t levelWidth = width;
+	uint32_t levelHeight = height;
+	while (true) {
+		size_t faceSize = GetLevelSize(compression, levelWidth, levelHeight);
+		result->Levels.push_back({ levelWidth, levelHeight, offset, faceSize });
+		offset += AlignTo16(faceSize * faces.size());
+
+		if (!generateMips || (levelWidth == 1 && levelHeight == 1)) {
+			break;
+		}
+		levelWidth = std::max(levelWidth / 2, 1u);
+		levelHeight = std::max(levelHeight / 2, 1u);
+	}
+	result->Data.resize(offset, 0);
+
+	for (size_t face = 0; face < faces.size(); face++) {
+		// Each level is made from the uncompressed texels of the level before it
+		std::vector<uint8_t> current(faces[face], faces[face] + (size_t)width * height * 4);
+		std::vector<uint8_t> next;
+
+		for (size_t level = 0; level < result->Levels.size(); level++) {
+			const CookedTexture::Level& info = result->Levels[level];
+			if (level > 0) {
+				const CookedTexture::Level& previous = result->Levels[level - 1];
+				next.resize((size_t)info.Width * info.Height * 4);
+				Downsample(current.data(), previous.Width, previous.Height, next.data(), info.Width, info.Height);
+				current.swap(next);
+			}
+
+			uint8_t* dst = result->Data.data() + info.Offset + info.FaceSize * face;
+			if (compression == TextureCompression::None) {
+				memcpy(dst, current.data(), info.FaceSize);
+			} else {
+				CompressLevel(current.data(), info.Width, info.Height, compression, dst);
+			}
+		}
+	}
+
+	return result;
+}
+
+bool TextureCooker::Save(const CookedTexture& texture, const std::string& path, uint64_t sourceStamp) {
+	CookedHeader header;
+	header.SourceStamp = sourceStamp;
+	header.Compression = texture.Compression;
+	header.Width = texture.Width;
+	header.Height = texture.Height;
+	header.Faces = texture.Faces;
+	header.NumLevels = static_cast<uint32_t>(texture.Levels.size());
+
+	// The level data is written after the header and level table, offsets in the file are from the start of the file
+	size_t dataStart = AlignTo16(sizeof(CookedHeader) + sizeof(CookedLevelEntry) * texture.Levels.size());
+	std::vector<CookedLevelEntry> entries;
+	for (const CookedTexture::Level& level : texture.Levels) {
+		entries.push_back({ level.Width, level.Height, dataStart + level.Offset, level.FaceSize });
+	}
+
+	// Several textures may be cooking the same file at once, so write to a temporary file and move it into place
+	std::filesystem::path tempPath = path;
+	tempPath += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary);
+		if (!file) {
+			LOG_WARN("Failed to write cooked texture \"{}\"", path);
+			return false;
+		}
+
+		static const char padding[16] = { 0 };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(CookedHeader));
+		file.write(reinterpret_cast<const char*>(entries.data()), sizeof(CookedLevelEntry) * entries.size());
+		file.write(padding, dataStart - sizeof(CookedHeader) - sizeof(CookedLevelEntry) * entries.size());
+		file.write(reinterpret_cast<const char*>(texture.Data.data()), texture.Data.size());
+		if (!file.good()) {
+			LOG_WARN("Failed to write cooked texture \"{}\"", path);
+			file.close();
+			std::error_code error;
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	if (error) {
+		LOG_WARN("Failed to write cooked texture \"{}\": {}", path, error.message());
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
+
+CookedTexture::Sptr TextureCooker::Load(const std::string& path, uint64_t sourceStamp) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return nullptr;
+	}
+
+	// The whole file is kept as the texture's data, so level offsets can be used as they are
+	CookedTexture::Sptr result = std::make_shared<CookedTexture>();
+	result->Data.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	if (result->Data.size() < sizeof(CookedHeader) || !file.read(reinterpret_cast<char*>(result->Data.data()), result->Data.size())) {
+		LOG_WARN("Discarding invalid cooked texture \"{}\"", path);
+		return nullptr;
+	}
+	file.close();
+
+	CookedHeader header;
+	memcpy(&header, result->Data.data(), sizeof(CookedHeader));
+	bool valid =
+		memcmp(header.HeaderBytes, CookedHeader().HeaderBytes, 4) == 0 &&
+		header.Version == CookedHeader().Version &&
+		header.Compression != TextureCompression::Auto && header.Compression <= TextureCompression::BC5 &&
+		(header.Faces == 1 || header.Faces == 6) &&
+		header.NumLevels > 0 && header.NumLevels <= 32 &&
+		sizeof(CookedHeader) + sizeof(CookedLevelEntry) * header.NumLevels <= result->Data.size();
+	if (!valid) {
+		LOG_WARN("Discarding invalid cooked texture \"{}\"", path);
+		return nullptr;
+	}
+
+	// Out of date files will be re-cooked by the caller
+	if (sourceStamp != 0 && header.SourceStamp != sourceStamp) {
+		return nullptr;
+	}
+
+	result->Compression = header.Compression;
+	result->Width = header.Width;
+	result->Height = header.Height;
+	result->Faces = header.Faces;
+
+	const CookedLevelEntry* entries = reinterpret_cast<const CookedLevelEntry*>(result->Data.data() + sizeof(CookedHeader));
+	for (uint32_t ix = 0; ix < header.NumLevels; ix++) {
+		const CookedLevelEntry& entry = entries[ix];
+		if (entry.FaceSize != GetLevelSize(header.Compression, entry.Width, entry.Height) ||
+			entry.Offset + entry.FaceSize * header.Faces > result->Data.size()) {
+			LOG_WARN("Discarding invalid cooked texture \"{}\"", path);
+			return nullptr;
+		}
+		result->Levels.push_back({ entry.Width, entry.Height, static_cast<size_t>(entry.Offset), static_cast<size_t>(entry.FaceSize) });
+	}
+
+	return result;
+}
+
+uint64_t TextureCooker::GetSourceStamp(const std::vector<std::string>& sources, TextureCompression compression, bool generateMips) {
+	uint64_t hash = HashBytes(&cookerVersion, sizeof(uint64_t));
+	hash = HashBytes(&compression, sizeof(TextureCompression), hash);
+	hash = HashBytes(&generateMips, sizeof(bool), hash);
+
+	for (const std::string& source : sources) {
+		std::error_code error;
+		uint64_t size = static_cast<uint64_t>(std::filesystem::file_size(source, error));
+		if (error) {
+			return 0;
+		}
+		int64_t writeTime = static_cast<int64_t>(std::filesystem::last_write_time(source, error).time_since_epoch().count());
+		if (error) {
+			return 0;
+		}
+		hash = HashBytes(&size, sizeof(uint64_t), hash);
+		hash = HashBytes(&writeTime, sizeof(int64_t), hash);
+	}
+
+	// 0 is reserved for unknown sources
+	return hash != 0 ? hash : 1;
+}
+
+CookedTexture::Sptr TextureCooker::LoadOrCook(const std::vector<std::string>& sources, const std::string& cookedPath, TextureCompression compression, bool generateMips) {
+	uint64_t stamp = GetSourceStamp(sources, compression, generateMips);
+	CookedTexture::Sptr result = Load(cookedPath, stamp);
+	if (result != nullptr && result->Faces == sources.size()) {
+		return result;
+	}
+
+	// The cooker always works with RGBA texels
+	struct SourceImage {
+		uint8_t* Data;
+		int      Width;
+		int      Height;
+	};
+	std::vector<SourceImage> images(sources.size(), { nullptr, 0, 0 });
+	auto decode = [&](size_t ix) {
+		int numChannels = 0;
+		images[ix].Data = stbi_load(sources[ix].c_str(), &images[ix].Width, &images[ix].Height, &numChannels, 4);
+	};
+	if (sources.size() > 1) {
+		ThreadPool::Get().ParallelFor(sources.size(), decode);
+	} else if (!sources.empty()) {
+		decode(0);
+	}
+
+	bool valid = !images.empty();
+	std::vector<const uint8_t*> faces;
+	for (size_t ix = 0; ix < images.size(); ix++) {
+		if (images[ix].Data == nullptr) {
+			LOG_WARN("STBI Failed to load image from \"{}\"", sources[ix]);
+			valid = false;
+		} else if (images[ix].Width != images[0].Width || images[ix].Height != images[0].Height) {
+			LOG_WARN("Image \"{}\" does not match the size of \"{}\", cannot cook", sources[ix], sources[0]);
+			valid = false;
+		}
+		faces.push_back(images[ix].Data);
+	}
+
+	result = nullptr;
+	if (valid) {
+		result = Cook(faces, images[0].Width, images[0].Height, compression, generateMips);
+		if (Save(*result, cookedPath, stamp)) {
+			LOG_INFO("Cooked \"{}\" as {} with {} mip levels ({} KB)", cookedPath, ~result->Compression, result->Levels.size(), result->Data.size() / 1024);
+		}
+	}
+
+	for (SourceImage& image : images) {
+		if (image.Data != nullptr) {
+			stbi_image_free(image.Data);
+		}
+	}
+	return result;
+}
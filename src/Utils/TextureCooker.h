@@ -0,0 +1,161 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <EnumToString.h>
+
+#include "Graphics/GlEnums.h"
+#include "Utils/Macros.h"
+
+/// <summary>
+/// The block compression to use when cooking a texture
+/// None: RGBA8 texels, no compression
+/// Auto: BC1 if every texel is opaque, otherwise BC3
+/// BC1:  RGB at 4 bits per texel, alpha is discarded
+/// BC3:  RGBA at 8 bits per texel
+/// BC5:  Red and green at 8 bits per texel, intended for normal maps
+/// </summary>
+ENUM(TextureCompression, uint32_t,
+	None = 0,
+	Auto = 1,
+	BC1  = 2,
+	BC3  = 3,
+	BC5  = 4
+);
+
+/// <summary>
+/// A texture that has been converted to the format it will be stored in on the GPU, with all of
+/// it's mip levels calculated up front
+/// </summary>
+struct CookedTexture {
+	MAKE_PTRS(CookedTexture);
+
+	/// <summary>
+	/// Describes where a single mip level is stored. The level's faces are stored back to back
+	/// </summary>
+	struct Level {
+		uint32_t Width;
+		uint32_t Height;
+		// The offset of the level's first face within Data, in bytes
+		size_t   Offset;
+		// The size of a single face of the level, in bytes
+		size_t   FaceSize;
+	};
+
+	// The compression of the texels, this is never Auto
+	TextureCompression Compression;
+	uint32_t           Width;
+	uint32_t           Height;
+	// 1 for 2D textures, 6 for cubemaps (in CubeMapFace order)
+	uint32_t           Faces;
+	std::vector<Level>   Levels;
+	std::vector<uint8_t> Data;
+
+	/// <summary>
+	/// Gets the internal format to allocate the texture's storage with
+	/// </summary>
+	InternalFormat GetInternalFormat() const;
+	/// <summary>
+	/// Returns true if the levels need to be uploaded with glCompressedTextureSubImage, otherwise
+	/// they contain RGBA8 texels
+	/// </summary>
+	bool IsCompressed() const { return Compression != TextureCompression::None; }
+	/// <summary>
+	/// Gets a pointer to the texels for a face of a mip level
+	/// </summary>
+	const uint8_t* GetLevelData(uint32_t level, uint32_t face = 0) const { return Data.data() + Levels[level].Offset + Levels[level].FaceSize * face; }
+};
+
+/// <summary>
+/// Converts images into a GPU ready container (.ctex) with every mip level precomputed and optionally
+/// block compressed, so that loading a texture is just a file read and a copy to the GPU, with no
+/// image decoding or mip map generation.
+///
+/// Cooked files store a stamp of the source files they were made from, and are re-cooked if the
+/// source images or the cook settings change
+/// </summary>
+class TextureCooker {
+public:
+	/// <summary>
+	/// Gets the path that the cooked version of an image should be stored at
+	/// </summary>
+	/// <param name="source">The path of the source image, or the first face of a cubemap</param>
+	/// <param name="cubemap">True if the cooked file will contain all 6 faces of a cubemap</param>
+	static std::string GetCookedPath(const std::string& source, bool cubemap = false);
+
+	/// <summary>
+	/// Cooks one or more RGBA8 images of the same size into a single texture, this is safe to call
+	/// from worker threads
+	/// </summary>
+	/// <param name="faces">The texels for each face, 1 face for 2D textures and 6 for cubemaps</param>
+	/// <param name="width">The width of each face, in pixels</param>
+	/// <param name="height">The height of each face, in pixels</param>
+	/// <param name="compression">The block compression to apply</param>
+	/// <param name="generateMips">True to generate the full mip chain, false to only store the base level</param>
+	static CookedTexture::Sptr Cook(const std::vector<const uint8_t*>& faces, uint32_t width, uint32_t height, TextureCompression compression, bool generateMips);
+
+	/// <summary>
+	/// Writes a cooked texture to disk
+	/// </summary>
+	/// <param name="texture">The texture to save</param>
+	/// <param name="path">The path of the file to write</param>
+	/// <param name="sourceStamp">The stamp from GetSourceStamp to store in the file, or 0</param>
+	/// <returns>True if the file was written</returns>
+	static bool Save(const CookedTexture& texture, const std::string& path, uint64_t sourceStamp = 0);
+	/// <summary>
+	/// Loads a cooked texture from disk
+	/// </summary>
+	/// <param name="path">The path of the .ctex file</param>
+	/// <param name="sourceStamp">If non-zero, the file will only be loaded if it was cooked from sources with this stamp</param>
+	/// <returns>The texture, or nullptr if the file is missing, invalid or out of date</returns>
+	static CookedTexture::Sptr Load(const std::string& path, uint64_t sourceStamp = 0);
+
+	/// <summary>
+	/// Calculates a stamp that changes whenever any of the source files or the cook settings change.
+	/// Returns 0 if any of the sources do not exist
+	/// </summary>
+	static uint64_t GetSourceStamp(const std::vector<std::string>& sources, TextureCompression compression, bool generateMips);
+
+	/// <summary>
+	/// Loads a cooked texture if it is up to date with it's source images, otherwise decodes the
+	/// sources with stbi, cooks them and saves the result for next time. The caller is responsible
+	/// for setting stbi's flip flag. When there are multiple sources, they are decoded with
+	/// ThreadPool::ParallelFor
+	/// </summary>
+	/// <param name="sources">The source images, 1 for 2D textures or 6 for cubemaps</param>
+	/// <param name="cookedPath">The path of the cooked file to load or create</param>
+	/// <param name="compression">The block compression to apply</param>
+	/// <param name="generateMips">True to generate the full mip chain</param>
+	/// <returns>The cooked texture, or nullptr if the sources could not be loaded</returns>
+	static CookedTexture::Sptr LoadOrCook(const std::vector<std::string>& sources, const std::string& cookedPath, TextureCompression compression, bool generateMips);
+
+protected:
+	TextureCooker() = default;
+	~TextureCooker() = default;
+
+	// Will be put at the start of cooked files, followed by a CookedLevelEntry for each mip level
+	struct CookedHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char     HeaderBytes[4] = { 'C', 'T', 'E', 'X' };
+		// Should be incremented if the layout of the file changes
+		uint32_t Version = 1;
+		// The stamp of the sources the file was cooked from, 0 if unknown
+		uint64_t SourceStamp = 0;
+		TextureCompression Compression = TextureCompression::None;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		uint32_t Faces = 0;
+		uint32_t NumLevels = 0;
+		uint32_t Reserved = 0;
+	};
+
+	// Describes a mip level in a cooked file, levels start on 16 byte boundaries
+	struct CookedLevelEntry {
+		uint32_t Width;
+		uint32_t Height;
+		// The offset of the level from the start of the file, and the size of each of it's faces in bytes
+		uint64_t Offset;
+		uint64_t FaceSize;
+	};
+};
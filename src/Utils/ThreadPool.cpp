@@ -0,0 +1,79 @@
+#include "Utils/ThreadPool.h"
+
+thread_local bool ThreadPool::__isWorkerThread = false;
+
+ThreadPool::ThreadPool(uint32_t numThreads) :
+	_workers(),
+	_queue(),
+	_queueMutex(),
+	_queueCondition(),
+	_isRunning(true)
+{
+	if (numThreads == 0) {
+		numThreads = std::thread::hardware_concurrency();
+	}
+	numThreads = numThreads == 0 ? 1 : numThreads;
+
+	_workers.reserve(numThreads);
+	for (uint32_t ix = 0; ix < numThreads; ix++) {
+		_workers.emplace_back(&ThreadPool::_WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_queueMutex);
+		_isRunning = false;
+	}
+	_queueCondition.notify_all();
+
+	// Workers will finish any queued tasks before they exit
+	for (auto& worker : _workers) {
+		worker.join();
+	}
+}
+
+ThreadPool& ThreadPool::Get() {
+	static ThreadPool instance;
+	return instance;
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& func) {
+	if (count == 1 || __isWorkerThread) {
+		for (size_t ix = 0; ix < count; ix++) {
+			func(ix);
+		}
+		return;
+	}
+
+	std::vector<std::future<void>> tasks;
+	tasks.reserve(count);
+	for (size_t ix = 0; ix < count; ix++) {
+		tasks.push_back(Enqueue([&func, ix]() { func(ix); }));
+	}
+
+	// Wait for all tasks before re-throwing any exceptions, since the tasks reference func
+	for (auto& task : tasks) {
+		task.wait();
+	}
+	for (auto& task : tasks) {
+		task.get();
+	}
+}
+
+void ThreadPool::_WorkerLoop() {
+	__isWorkerThread = true;
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_queueMutex);
+			_queueCondition.wait(lock, [this]() { return !_isRunning || !_queue.empty(); });
+			if (_queue.empty()) {
+				return;
+			}
+			task = std::move(_queue.front());
+			_queue.pop_front();
+		}
+		task();
+	}
+}
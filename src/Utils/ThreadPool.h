@@ -0,0 +1,83 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <cstdint>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// A simple pool of worker threads that pull tasks from a shared queue. Use Get to access the
+/// application's shared pool, so we don't end up with more threads than cores
+/// </summary>
+class ThreadPool {
+public:
+	NO_COPY(ThreadPool);
+	NO_MOVE(ThreadPool);
+
+	/// <summary>
+	/// Creates a new thread pool
+	/// </summary>
+	/// <param name="numThreads">The number of worker threads, or 0 to use one per hardware thread</param>
+	ThreadPool(uint32_t numThreads = 0);
+	~ThreadPool();
+
+	/// <summary>
+	/// Gets the shared thread pool for the application
+	/// </summary>
+	static ThreadPool& Get();
+
+	/// <summary>
+	/// Gets the number of worker threads in this pool
+	/// </summary>
+	uint32_t GetNumThreads() const { return static_cast<uint32_t>(_workers.size()); }
+	/// <summary>
+	/// Returns true if the calling thread is a worker thread of a thread pool
+	/// </summary>
+	static bool IsWorkerThread() { return __isWorkerThread; }
+
+	/// <summary>
+	/// Queues a task to be run on one of the worker threads
+	/// </summary>
+	/// <param name="func">The function to invoke</param>
+	/// <returns>A future that will contain the result of the function once it has run</returns>
+	template <typename Func>
+	auto Enqueue(Func&& func) -> std::future<decltype(func())> {
+		typedef decltype(func()) ResultType;
+		std::shared_ptr<std::packaged_task<ResultType()>> task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Func>(func));
+		std::future<ResultType> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(_queueMutex);
+			_queue.emplace_back([task]() { (*task)(); });
+		}
+		_queueCondition.notify_one();
+		return result;
+	}
+
+	/// <summary>
+	/// Invokes a function for each index in [0, count) across the worker threads, and waits
+	/// for all of them to finish. When called from within a task, the indices are run one after
+	/// another on the calling thread instead, since a worker waiting on tasks queued behind it
+	/// could deadlock the pool
+	/// </summary>
+	/// <param name="count">The number of times to invoke the function</param>
+	/// <param name="func">The function to invoke with each index</param>
+	void ParallelFor(size_t count, const std::function<void(size_t)>& func);
+
+private:
+	std::vector<std::thread>          _workers;
+	std::deque<std::function<void()>> _queue;
+	std::mutex                        _queueMutex;
+	std::condition_variable           _queueCondition;
+	bool                              _isRunning;
+
+	// True on threads that are running _WorkerLoop
+	static thread_local bool __isWorkerThread;
+
+	void _WorkerLoop();
+};
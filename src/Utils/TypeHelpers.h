@@ -11,4 +11,18 @@ namespace detail {
 } // detail::
 
 template<class T, class Arg>
-struct test_json : decltype(detail::test_json<T, Arg>(0)){};
\ No newline at end of file
+struct test_json : decltype(detail::test_json<T, Arg>(0)){};
+
+namespace detail {
+	template<class T, class A0>
+	static auto test_prepare_json(int)->sfinae_true<decltype(T::PrepareFromJson(std::declval<A0>()))>;
+	template<class, class A0>
+	static auto test_prepare_json(long)->std::false_type;
+} // detail::
+
+/// <summary>
+/// True if T has a static PrepareFromJson(Arg), used by the ResourceManager to find resources that
+/// can do part of their loading on worker threads
+/// </summary>
+template<class T, class Arg>
+struct test_prepare_json : decltype(detail::test_prepare_json<T, Arg>(0)){};
\ No newline at end of file